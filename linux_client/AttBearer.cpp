@@ -0,0 +1,153 @@
+/* self */
+#include "AttBearer.h"
+
+/* stdlib */
+#include <cstdio>
+
+static void AttBearer_PutUint16(std::vector<uint8_t> &pdu, uint16_t value) {
+    pdu.push_back(value & 0xFF);
+    pdu.push_back(value >> 8);
+}
+
+void AttBearer::Read(uint16_t handle, ResponseCallback callback) {
+    std::vector<uint8_t> pdu = {ATT_OP_READ_REQ};
+    AttBearer_PutUint16(pdu, handle);
+    Enqueue(std::move(pdu), std::move(callback));
+}
+
+void AttBearer::Write(uint16_t handle, const std::vector<uint8_t> &value, ResponseCallback callback) {
+    std::vector<uint8_t> pdu = {ATT_OP_WRITE_REQ};
+    AttBearer_PutUint16(pdu, handle);
+    pdu.insert(pdu.end(), value.begin(), value.end());
+    Enqueue(std::move(pdu), std::move(callback));
+}
+
+// commands are not confirmed, so they bypass queue and go out immediately
+void AttBearer::WriteCommand(uint16_t handle, const std::vector<uint8_t> &value) {
+    if (!isConnected) {
+        return;
+    }
+
+    std::vector<uint8_t> pdu = {ATT_OP_WRITE_CMD};
+    AttBearer_PutUint16(pdu, handle);
+    pdu.insert(pdu.end(), value.begin(), value.end());
+    SendPdu(pdu);
+}
+
+void AttBearer::SetNotificationCallback(NotificationCallback callback) {
+    notificationCallback = std::move(callback);
+}
+
+void AttBearer::SetDisconnectCallback(DisconnectCallback callback) {
+    disconnectCallback = std::move(callback);
+}
+
+size_t AttBearer::GetQueuedCount() const {
+    return queue.size();
+}
+
+bool AttBearer::IsConnected() const {
+    return isConnected;
+}
+
+void AttBearer::Enqueue(std::vector<uint8_t> pdu, ResponseCallback callback) {
+    if (!isConnected) {
+        callback(ATT_ERR_DISCONNECTED, {});
+        return;
+    }
+
+    queue.push_back(Request{std::move(pdu), std::move(callback)});
+    SendNext();
+}
+
+void AttBearer::SendNext() {
+    if (isInFlight || queue.empty() || !isConnected) {
+        return;
+    }
+
+    isInFlight = true;
+    SendPdu(queue.front().pdu);
+}
+
+// next request is sent before callback runs, so link stays busy while caller processes response
+void AttBearer::CompleteRequest(uint8_t error, const std::vector<uint8_t> &value) {
+    if (!isInFlight || queue.empty()) {
+        fprintf(stderr, "ATT response without request\n");
+        return;
+    }
+
+    Request request = std::move(queue.front());
+    queue.pop_front();
+    isInFlight = false;
+    SendNext();
+
+    request.callback(error, value);
+}
+
+void AttBearer::ReceivePdu(const uint8_t *pdu, size_t len) {
+    if (len < 1) {
+        return;
+    }
+
+    switch (pdu[0]) {
+        case ATT_OP_READ_RSP:
+            CompleteRequest(ATT_SUCCESS, std::vector<uint8_t>(pdu + 1, pdu + len));
+            break;
+
+        case ATT_OP_WRITE_RSP:
+            CompleteRequest(ATT_SUCCESS, {});
+            break;
+
+        case ATT_OP_ERROR_RSP:
+            CompleteRequest(len >= 5 ? pdu[4] : (uint8_t)ATT_ERR_REQ_NOT_SUPPORTED, {});
+            break;
+
+        case ATT_OP_HANDLE_VALUE_NTF:
+        case ATT_OP_HANDLE_VALUE_IND:
+            if (len >= 3 && notificationCallback) {
+                notificationCallback(pdu[1] | (pdu[2] << 8), std::vector<uint8_t>(pdu + 3, pdu + len));
+            }
+            // service changed indication must be confirmed, content does not matter as handles are fixed
+            if (pdu[0] == ATT_OP_HANDLE_VALUE_IND) {
+                SendPdu({ATT_OP_HANDLE_VALUE_CNF});
+            }
+            break;
+
+        case ATT_OP_MTU_REQ:
+            // records of stopwatch fit default MTU
+            SendPdu({ATT_OP_MTU_RSP, ATT_DEFAULT_MTU, 0x00});
+            break;
+
+        default:
+            // other server requests are not supported, commands are ignored
+            if ((pdu[0] & 0x01) == 0 && (pdu[0] & ATT_COMMAND_FLAG) == 0) {
+                SendPdu({ATT_OP_ERROR_RSP, pdu[0], 0x00, 0x00, ATT_ERR_REQ_NOT_SUPPORTED});
+            }
+            break;
+    }
+}
+
+void AttBearer::SetConnected() {
+    isConnected = true;
+    isInFlight = false;
+}
+
+// callbacks of lost requests run after state is cleared, so they can already queue requests on new link
+void AttBearer::SetDisconnected() {
+    if (!isConnected) {
+        return;
+    }
+
+    isConnected = false;
+    isInFlight = false;
+
+    std::deque<Request> lost;
+    lost.swap(queue);
+    for (auto &request : lost) {
+        request.callback(ATT_ERR_DISCONNECTED, {});
+    }
+
+    if (disconnectCallback) {
+        disconnectCallback();
+    }
+}
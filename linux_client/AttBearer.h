@@ -0,0 +1,83 @@
+#ifndef ATT_BEARER_H
+#define ATT_BEARER_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#define ATT_DEFAULT_MTU 23
+#define ATT_COMMAND_FLAG 0x40
+
+// ATT opcodes and errors used by stopwatch protocol
+enum : uint8_t {
+    ATT_OP_ERROR_RSP = 0x01,
+    ATT_OP_MTU_REQ = 0x02,
+    ATT_OP_MTU_RSP = 0x03,
+    ATT_OP_READ_REQ = 0x0A,
+    ATT_OP_READ_RSP = 0x0B,
+    ATT_OP_WRITE_REQ = 0x12,
+    ATT_OP_WRITE_RSP = 0x13,
+    ATT_OP_HANDLE_VALUE_NTF = 0x1B,
+    ATT_OP_HANDLE_VALUE_IND = 0x1D,
+    ATT_OP_HANDLE_VALUE_CNF = 0x1E,
+    ATT_OP_WRITE_CMD = 0x52,
+};
+
+enum : uint8_t {
+    ATT_SUCCESS = 0x00,
+    ATT_ERR_INVALID_HANDLE = 0x01,
+    ATT_ERR_REQ_NOT_SUPPORTED = 0x06,
+    ATT_ERR_LENGTH = 0x0D,
+    ATT_ERR_RANGE = 0xFF,
+    // not sent by device, reported when link is lost while request is queued or in flight
+    ATT_ERR_DISCONNECTED = 0xFE,
+};
+
+// Client side of ATT bearer. ATT allows only one request in flight on bearer, so requests are not pipelined but
+// queued, and the next one is sent from the same call that handles the response, without waiting for the caller
+// to react. Callers queue whole sequences of requests upfront, so a sequence costs one round trip per request
+// and the link never idles between them. Only write commands overlap with request in flight.
+class AttBearer {
+   public:
+    using ResponseCallback = std::function<void(uint8_t error, const std::vector<uint8_t> &value)>;
+    using NotificationCallback = std::function<void(uint16_t handle, const std::vector<uint8_t> &value)>;
+    using DisconnectCallback = std::function<void()>;
+
+    virtual ~AttBearer() = default;
+
+    void Read(uint16_t handle, ResponseCallback callback);
+    void Write(uint16_t handle, const std::vector<uint8_t> &value, ResponseCallback callback);
+    void WriteCommand(uint16_t handle, const std::vector<uint8_t> &value);
+
+    void SetNotificationCallback(NotificationCallback callback);
+    void SetDisconnectCallback(DisconnectCallback callback);
+
+    size_t GetQueuedCount() const;
+    bool IsConnected() const;
+
+   protected:
+    virtual void SendPdu(const std::vector<uint8_t> &pdu) = 0;
+
+    void ReceivePdu(const uint8_t *pdu, size_t len);
+    void SetConnected();
+    void SetDisconnected();
+
+   private:
+    struct Request {
+        std::vector<uint8_t> pdu;
+        ResponseCallback callback;
+    };
+
+    std::deque<Request> queue;
+    bool isInFlight = false;
+    bool isConnected = false;
+    NotificationCallback notificationCallback;
+    DisconnectCallback disconnectCallback;
+
+    void Enqueue(std::vector<uint8_t> pdu, ResponseCallback callback);
+    void SendNext();
+    void CompleteRequest(uint8_t error, const std::vector<uint8_t> &value);
+};
+
+#endif
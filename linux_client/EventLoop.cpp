@@ -0,0 +1,95 @@
+/* self */
+#include "EventLoop.h"
+
+/* stdlib */
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+
+/* linux */
+#include <poll.h>
+
+void EventLoop::AddFd(int fd, short events, FdCallback callback) {
+    watches[fd] = Watch{events, std::move(callback)};
+}
+
+void EventLoop::SetFdEvents(int fd, short events) {
+    auto it = watches.find(fd);
+    if (it != watches.end()) {
+        it->second.events = events;
+    }
+}
+
+void EventLoop::RemoveFd(int fd) {
+    watches.erase(fd);
+}
+
+uint64_t EventLoop::AddTimer(Clock::duration delay, TimerCallback callback) {
+    uint64_t id = nextTimerId++;
+    timers.emplace(Clock::now() + delay, Timer{id, std::move(callback)});
+    return id;
+}
+
+void EventLoop::CancelTimer(uint64_t timerId) {
+    for (auto it = timers.begin(); it != timers.end(); ++it) {
+        if (it->second.id == timerId) {
+            timers.erase(it);
+            return;
+        }
+    }
+}
+
+// callbacks may add or cancel timers, so each due timer is removed before it is called
+void EventLoop::RunDueTimers() {
+    while (!timers.empty() && timers.begin()->first <= Clock::now()) {
+        TimerCallback callback = std::move(timers.begin()->second.callback);
+        timers.erase(timers.begin());
+        callback();
+    }
+}
+
+void EventLoop::Run() {
+    std::vector<pollfd> fds;
+
+    isStopped = false;
+    while (!isStopped) {
+        int timeout = -1;
+        if (!timers.empty()) {
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers.begin()->first - Clock::now());
+            timeout = wait.count() > 0 ? wait.count() : 0;
+        }
+
+        if (watches.empty() && timers.empty()) {
+            return;
+        }
+
+        fds.clear();
+        for (auto &watch : watches) {
+            fds.push_back(pollfd{watch.first, watch.second.events, 0});
+        }
+
+        int ready = poll(fds.data(), fds.size(), timeout);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            return;
+        }
+
+        // watch may be removed by callback of other descriptor in the same pass
+        for (auto &fd : fds) {
+            if (fd.revents == 0) {
+                continue;
+            }
+            auto it = watches.find(fd.fd);
+            if (it != watches.end()) {
+                FdCallback callback = it->second.callback;
+                callback(fd.revents);
+            }
+        }
+
+        RunDueTimers();
+    }
+}
+
+void EventLoop::Stop() {
+    isStopped = true;
+}
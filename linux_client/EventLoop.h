@@ -0,0 +1,45 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+
+// Single threaded poll loop, all devices of one process share it, so no locking is needed anywhere.
+class EventLoop {
+   public:
+    using Clock = std::chrono::steady_clock;
+    using FdCallback = std::function<void(short revents)>;
+    using TimerCallback = std::function<void()>;
+
+    void AddFd(int fd, short events, FdCallback callback);
+    void SetFdEvents(int fd, short events);
+    void RemoveFd(int fd);
+
+    uint64_t AddTimer(Clock::duration delay, TimerCallback callback);
+    void CancelTimer(uint64_t timerId);
+
+    void Run();
+    void Stop();
+
+   private:
+    struct Watch {
+        short events;
+        FdCallback callback;
+    };
+
+    struct Timer {
+        uint64_t id;
+        TimerCallback callback;
+    };
+
+    std::map<int, Watch> watches;
+    std::multimap<Clock::time_point, Timer> timers;
+    uint64_t nextTimerId = 1;
+    bool isStopped = false;
+
+    void RunDueTimers();
+};
+
+#endif
@@ -0,0 +1,174 @@
+/* self */
+#include "L2capTransport.h"
+
+/* stdlib */
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+/* linux */
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Bluetooth socket ABI of Linux kernel, declared here so libbluetooth headers are not needed for build
+#define L2CAP_AF_BLUETOOTH 31
+#define L2CAP_BTPROTO_L2CAP 0
+#define L2CAP_SOL_BLUETOOTH 274
+#define L2CAP_BT_SECURITY 4
+#define L2CAP_BT_SECURITY_LOW 1
+#define L2CAP_BT_SECURITY_MEDIUM 2
+#define L2CAP_ATT_CID 4
+#define L2CAP_BDADDR_LE_PUBLIC 0x01
+#define L2CAP_BDADDR_LE_RANDOM 0x02
+
+struct L2capBdAddr {
+    uint8_t b[6];
+} __attribute__((packed));
+
+struct L2capSockAddr {
+    sa_family_t l2_family;
+    unsigned short l2_psm;
+    L2capBdAddr l2_bdaddr;
+    unsigned short l2_cid;
+    uint8_t l2_bdaddr_type;
+};
+
+struct L2capSecurity {
+    uint8_t level;
+    uint8_t key_size;
+};
+
+#define L2CAP_MAX_PDU 512
+
+static int L2capTransport_ParseAddress(const std::string &text, L2capBdAddr *address) {
+    unsigned int b[6];
+
+    if (sscanf(text.c_str(), "%2x:%2x:%2x:%2x:%2x:%2x", &b[5], &b[4], &b[3], &b[2], &b[1], &b[0]) != 6) {
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        address->b[i] = b[i];
+    }
+    return 0;
+}
+
+L2capTransport::L2capTransport(EventLoop &loop) : loop(loop) {
+}
+
+L2capTransport::~L2capTransport() {
+    Close();
+}
+
+int L2capTransport::Connect(const std::string &address, bool isRandomAddress, bool isEncrypted, ConnectCallback callback) {
+    L2capSockAddr local = {};
+    L2capSockAddr remote = {};
+    int status;
+
+    status = L2capTransport_ParseAddress(address, &remote.l2_bdaddr);
+    if (status) {
+        return status;
+    }
+
+    fd = socket(L2CAP_AF_BLUETOOTH, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, L2CAP_BTPROTO_L2CAP);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    local.l2_family = L2CAP_AF_BLUETOOTH;
+    local.l2_cid = L2CAP_ATT_CID;
+    local.l2_bdaddr_type = L2CAP_BDADDR_LE_PUBLIC;
+    if (bind(fd, (sockaddr *)&local, sizeof(local)) < 0) {
+        status = -errno;
+        Close();
+        return status;
+    }
+
+    L2capSecurity security = {};
+    security.level = isEncrypted ? L2CAP_BT_SECURITY_MEDIUM : L2CAP_BT_SECURITY_LOW;
+    if (setsockopt(fd, L2CAP_SOL_BLUETOOTH, L2CAP_BT_SECURITY, &security, sizeof(security)) < 0) {
+        status = -errno;
+        Close();
+        return status;
+    }
+
+    remote.l2_family = L2CAP_AF_BLUETOOTH;
+    remote.l2_cid = L2CAP_ATT_CID;
+    remote.l2_bdaddr_type = isRandomAddress ? L2CAP_BDADDR_LE_RANDOM : L2CAP_BDADDR_LE_PUBLIC;
+    if (connect(fd, (sockaddr *)&remote, sizeof(remote)) < 0 && errno != EINPROGRESS) {
+        status = -errno;
+        Close();
+        return status;
+    }
+
+    // connection completes when socket becomes writable
+    isConnecting = true;
+    connectCallback = std::move(callback);
+    loop.AddFd(fd, POLLOUT, [this](short revents) { OnEvents(revents); });
+    return 0;
+}
+
+void L2capTransport::Disconnect() {
+    Close();
+    SetDisconnected();
+}
+
+void L2capTransport::Close() {
+    if (fd < 0) {
+        return;
+    }
+
+    loop.RemoveFd(fd);
+    close(fd);
+    fd = -1;
+    isConnecting = false;
+}
+
+void L2capTransport::SendPdu(const std::vector<uint8_t> &pdu) {
+    if (fd < 0) {
+        return;
+    }
+
+    // seqpacket socket keeps PDU boundaries, kernel queue is far larger than single request
+    if (send(fd, pdu.data(), pdu.size(), MSG_NOSIGNAL) < 0 && errno != EAGAIN) {
+        perror("send");
+    }
+}
+
+void L2capTransport::OnEvents(short revents) {
+    if (isConnecting) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+
+        ConnectCallback callback = std::move(connectCallback);
+        if (error) {
+            Close();
+            callback(error);
+            return;
+        }
+
+        isConnecting = false;
+        loop.SetFdEvents(fd, POLLIN);
+        SetConnected();
+        callback(0);
+        return;
+    }
+
+    if (revents & POLLIN) {
+        uint8_t pdu[L2CAP_MAX_PDU];
+        ssize_t len = recv(fd, pdu, sizeof(pdu), 0);
+        if (len > 0) {
+            ReceivePdu(pdu, len);
+            return;
+        }
+        if (len < 0 && errno == EAGAIN) {
+            return;
+        }
+    }
+
+    // hang up, error or orderly shutdown by device
+    Disconnect();
+}
@@ -0,0 +1,36 @@
+#ifndef L2CAP_TRANSPORT_H
+#define L2CAP_TRANSPORT_H
+
+#include "AttBearer.h"
+#include "EventLoop.h"
+
+#include <functional>
+#include <string>
+
+// ATT bearer on BlueZ LE L2CAP socket (fixed channel 4). Kernel handles the connection, so bluetoothd
+// may keep running. Device must be paired with bluetoothctl first when encryption is requested.
+class L2capTransport : public AttBearer {
+   public:
+    using ConnectCallback = std::function<void(int error)>;
+
+    L2capTransport(EventLoop &loop);
+    ~L2capTransport() override;
+
+    // address is "AA:BB:CC:DD:EE:FF", completes asynchronously, error is errno value
+    int Connect(const std::string &address, bool isRandomAddress, bool isEncrypted, ConnectCallback callback);
+    void Disconnect();
+
+   protected:
+    void SendPdu(const std::vector<uint8_t> &pdu) override;
+
+   private:
+    EventLoop &loop;
+    int fd = -1;
+    bool isConnecting = false;
+    ConnectCallback connectCallback;
+
+    void OnEvents(short revents);
+    void Close();
+};
+
+#endif
@@ -0,0 +1,548 @@
+/* self */
+#include "SimulatedStopwatch.h"
+
+/* stdlib */
+#include <algorithm>
+#include <memory>
+
+using namespace StopwatchProtocol;
+
+#define SIMULATED_LAPS_MAX 256
+#define SIMULATED_CONNECT_EVENTS 3
+
+// activity of firmware, periods are those of GUI.c, FuelGauge.c, Energy.c and advertising config in BLE.c
+#define SIMULATED_ENERGY_SAMPLE_PERIOD std::chrono::seconds(10)
+#define SIMULATED_GUI_ACTIVE_PERIOD std::chrono::milliseconds(50)
+#define SIMULATED_GUI_IDLE_PERIOD std::chrono::milliseconds(1000)
+#define SIMULATED_FUEL_GAUGE_PERIOD std::chrono::milliseconds(300)
+#define SIMULATED_ADVERTISING_INTERVAL_MS 500.0
+#define SIMULATED_BATTERY_PERCENT 80
+
+// page is 4 command and 129 data bytes, running time and current lap change 3 pages, advertising icon 1
+#define SIMULATED_RUNNING_FRAME_BYTES (3 * 133)
+#define SIMULATED_ANIMATION_FRAME_BYTES 133
+// three register reads, 1 byte register address and 2 bytes value each
+#define SIMULATED_FUEL_GAUGE_POLL_BYTES 9
+
+// CPU active time of each activity, estimated from profiler figures of firmware
+#define SIMULATED_GUI_TICK_US 150
+#define SIMULATED_FRAME_US 1500
+#define SIMULATED_FUEL_GAUGE_POLL_US 100
+#define SIMULATED_RADIO_EVENT_US 300
+
+static void SimulatedStopwatch_PutUint32(std::vector<uint8_t> &value, uint32_t x) {
+    value.push_back(x);
+    value.push_back(x >> 8);
+    value.push_back(x >> 16);
+    value.push_back(x >> 24);
+}
+
+static uint32_t SimulatedStopwatch_GetUint32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t SimulatedStopwatch_UsToTicks(double us) {
+    return (uint32_t)(us * POWER_TICK_PER_SEC / 1000000);
+}
+
+SimulatedStopwatch::SimulatedStopwatch(EventLoop &loop, unsigned seed) : loop(loop), random(seed) {
+    bootTime = EventLoop::Clock::now() - std::chrono::seconds(std::uniform_int_distribution<int>(1, 3600)(random));
+    lapEventsStreamId = random();
+
+    energySampleTime = EventLoop::Clock::now();
+    radioAccountTime = energySampleTime;
+    deepSleepBlockedSince = energySampleTime;
+    energyReport.assign(ENERGY_REPORT_LEN, 0);
+
+    guiTimer = loop.AddTimer(SIMULATED_GUI_IDLE_PERIOD, [this]() { GuiTick(); });
+    fuelGaugeTimer = loop.AddTimer(SIMULATED_FUEL_GAUGE_PERIOD, [this]() { FuelGaugePoll(); });
+    energyTimer = loop.AddTimer(SIMULATED_ENERGY_SAMPLE_PERIOD, [this]() { SampleEnergy(); });
+}
+
+SimulatedStopwatch::~SimulatedStopwatch() {
+    if (athleteTimer) {
+        loop.CancelTimer(athleteTimer);
+    }
+    loop.CancelTimer(guiTimer);
+    loop.CancelTimer(fuelGaugeTimer);
+    loop.CancelTimer(energyTimer);
+    for (auto *link : std::set<SimulatedTransport *>(links)) {
+        link->Disconnect();
+    }
+}
+
+uint32_t SimulatedStopwatch::GetTick() const {
+    auto sinceBoot = EventLoop::Clock::now() - bootTime;
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::microseconds>(sinceBoot).count() * TICK_PER_SEC / 1000000);
+}
+
+void SimulatedStopwatch::StartAthlete(int minLapMs, int maxLapMs, int lapsPerRun) {
+    this->minLapMs = minLapMs;
+    this->maxLapMs = maxLapMs;
+    this->lapsPerRun = lapsPerRun;
+
+    int delayMs = std::uniform_int_distribution<int>(0, maxLapMs)(random);
+    athleteTimer = loop.AddTimer(std::chrono::milliseconds(delayMs), [this]() { AthleteStep(); });
+}
+
+void SimulatedStopwatch::AthleteStep() {
+    uint32_t tick = GetTick();
+
+    if (!isRunning) {
+        if (totalTime) {
+            Reset();
+        }
+        Start(tick);
+    } else if ((int)lapOffsets.size() < lapsPerRun) {
+        Lap(tick);
+    } else {
+        Stop(tick);
+    }
+
+    int delayMs = std::uniform_int_distribution<int>(minLapMs, maxLapMs)(random);
+    athleteTimer = loop.AddTimer(std::chrono::milliseconds(delayMs), [this]() { AthleteStep(); });
+}
+
+uint8_t SimulatedStopwatch::ExecuteCommand(uint8_t command) {
+    uint32_t tick = GetTick();
+
+    if (command > COMMAND_RESET) {
+        return ATT_ERR_RANGE;
+    }
+
+    if (command == COMMAND_RESET) {
+        Reset();
+        return ATT_SUCCESS;
+    }
+
+    if (command == COMMAND_START) {
+        if (isRunning) {
+            return ATT_ERR_BAD_STATE;
+        }
+        Start(tick);
+        return ATT_SUCCESS;
+    }
+
+    if (!isRunning) {
+        return ATT_ERR_BAD_STATE;
+    }
+
+    if (command == COMMAND_STOP) {
+        Stop(tick);
+    } else {
+        Lap(tick);
+    }
+    return ATT_SUCCESS;
+}
+
+void SimulatedStopwatch::Start(uint32_t tick) {
+    AccountDeepSleepBlocked();
+    isRunning = true;
+    startTick = tick;
+    lapOffsets.clear();
+
+    AddLapEvent(LAP_EVENT_START, 0, tick, 0);
+    NotifyAll(LAPS_COUNT_CCC_HANDLE, LAPS_COUNT_VALUE_HANDLE, {0});
+    NotifyAll(STATUS_CCC_HANDLE, STATUS_VALUE_HANDLE, {1});
+}
+
+void SimulatedStopwatch::Stop(uint32_t tick) {
+    AccountDeepSleepBlocked();
+    isRunning = false;
+    totalTime = tick - startTick;
+
+    AddLapEvent(LAP_EVENT_STOP, 0, tick, totalTime);
+    NotifyAll(STATUS_CCC_HANDLE, STATUS_VALUE_HANDLE, {0});
+}
+
+void SimulatedStopwatch::Lap(uint32_t tick) {
+    if (lapOffsets.size() >= SIMULATED_LAPS_MAX) {
+        return;
+    }
+
+    uint32_t previous = lapOffsets.empty() ? startTick : lapOffsets.back();
+    lapOffsets.push_back(tick);
+
+    AddLapEvent(LAP_EVENT_LAP, lapOffsets.size() - 1, tick, tick - previous);
+    NotifyAll(LAPS_COUNT_CCC_HANDLE, LAPS_COUNT_VALUE_HANDLE, {(uint8_t)lapOffsets.size()});
+}
+
+void SimulatedStopwatch::Reset() {
+    AccountDeepSleepBlocked();
+    isRunning = false;
+    totalTime = 0;
+    lapOffsets.clear();
+
+    AddLapEvent(LAP_EVENT_RESET, 0, GetTick(), 0);
+    NotifyAll(LAPS_COUNT_CCC_HANDLE, LAPS_COUNT_VALUE_HANDLE, {0});
+    NotifyAll(STATUS_CCC_HANDLE, STATUS_VALUE_HANDLE, {0});
+}
+
+// like GUI_TimerHandler, LED is sent every tick, display only while something changes, tick is fast only then
+void SimulatedStopwatch::GuiTick() {
+    bool isAdvertising = links.empty();
+    guiTickCount++;
+
+    energyCounters.ledFrames++;
+    activeUs += SIMULATED_GUI_TICK_US;
+
+    if (isRunning) {
+        energyCounters.displayBytes += SIMULATED_RUNNING_FRAME_BYTES;
+        activeUs += SIMULATED_FRAME_US;
+    } else if (isAdvertising && guiTickCount % 5 == 0) {
+        energyCounters.displayBytes += SIMULATED_ANIMATION_FRAME_BYTES;
+        activeUs += SIMULATED_FRAME_US;
+    }
+
+    auto period = isRunning || isAdvertising ? SIMULATED_GUI_ACTIVE_PERIOD : SIMULATED_GUI_IDLE_PERIOD;
+    guiTimer = loop.AddTimer(period, [this]() { GuiTick(); });
+}
+
+void SimulatedStopwatch::FuelGaugePoll() {
+    energyCounters.fuelGaugeBytes += SIMULATED_FUEL_GAUGE_POLL_BYTES;
+    activeUs += SIMULATED_FUEL_GAUGE_POLL_US;
+
+    fuelGaugeTimer = loop.AddTimer(SIMULATED_FUEL_GAUGE_PERIOD, [this]() { FuelGaugePoll(); });
+}
+
+// like BLE_AccountAllRadioEvents, called before links change, every link has event each connection interval
+// and device advertises while no central is connected
+void SimulatedStopwatch::AccountRadioEvents() {
+    auto now = EventLoop::Clock::now();
+    double elapsedMs = std::chrono::duration<double, std::milli>(now - radioAccountTime).count();
+    radioAccountTime = now;
+
+    double events = 0;
+    if (links.empty()) {
+        events += elapsedMs / SIMULATED_ADVERTISING_INTERVAL_MS;
+    }
+    for (auto *link : links) {
+        events += elapsedMs / link->config.connectionIntervalMs;
+    }
+
+    // device counts whole events, fraction is carried over
+    radioEvents += events;
+    energyCounters.radioEvents += (uint32_t)radioEvents;
+    radioEvents -= (uint32_t)radioEvents;
+    activeUs += events * SIMULATED_RADIO_EVENT_US;
+}
+
+// like Power_SelectState, deep sleep is not allowed while stopwatch runs or central is connected, called before
+// either changes
+void SimulatedStopwatch::AccountDeepSleepBlocked() {
+    auto now = EventLoop::Clock::now();
+    if (isRunning || !links.empty()) {
+        deepSleepBlockedUs += std::chrono::duration<double, std::micro>(now - deepSleepBlockedSince).count();
+    }
+    deepSleepBlockedSince = now;
+}
+
+// like Energy_Sample, window is split into power states as Power.c would count it, fuel gauge of simulated device
+// does not measure current
+void SimulatedStopwatch::SampleEnergy() {
+    AccountRadioEvents();
+    AccountDeepSleepBlocked();
+
+    auto now = EventLoop::Clock::now();
+    double windowUs = std::chrono::duration<double, std::micro>(now - energySampleTime).count();
+    energySampleTime = now;
+
+    uint32_t windowTicks = SimulatedStopwatch_UsToTicks(windowUs);
+    uint32_t activeTicks = SimulatedStopwatch_UsToTicks(std::min(windowUs, activeUs));
+    uint32_t sleepTicks = SimulatedStopwatch_UsToTicks((windowUs - std::min(windowUs, activeUs)) * std::min(1.0, deepSleepBlockedUs / windowUs));
+    energyCounters.time += windowTicks;
+    energyCounters.residency[POWER_STATE_ACTIVE] += activeTicks;
+    energyCounters.residency[POWER_STATE_SLEEP] += sleepTicks;
+    energyCounters.residency[POWER_STATE_DEEPSLEEP] += windowTicks - activeTicks - sleepTicks;
+    activeUs = 0;
+    deepSleepBlockedUs = 0;
+
+    if (EnergyModel_GetCurrents(&lastEnergyCounters, &energyCounters, 1, energyCurrents)) {
+        lastEnergyCounters = energyCounters;
+    }
+
+    int runtime = EnergyModel_GetRemainingRuntime(EnergyModel_GetTotalCurrent(energyCurrents), SIMULATED_BATTERY_PERCENT, 0);
+    EnergyModel_GetReport(energyCurrents, 0, runtime, energyReport.data(), energyReport.size());
+
+    energyTimer = loop.AddTimer(SIMULATED_ENERGY_SAMPLE_PERIOD, [this]() { SampleEnergy(); });
+}
+
+uint32_t SimulatedStopwatch::GetOldestLapEvent() const {
+    return lapEventsHead > LAP_EVENTS_MAX ? lapEventsHead - LAP_EVENTS_MAX : 0;
+}
+
+void SimulatedStopwatch::AddLapEvent(LapEventKind kind, uint8_t lapIndex, uint32_t tick, uint32_t delta) {
+    lapEvents[lapEventsHead % LAP_EVENTS_MAX] = StoredEvent{kind, lapIndex, tick, delta};
+    lapEventsHead++;
+
+    for (auto *link : links) {
+        SendLapEvents(link);
+    }
+}
+
+void SimulatedStopwatch::SendLapEvents(SimulatedTransport *link) {
+    if (!link->enabledCcc.count(LAP_EVENTS_CCC_HANDLE)) {
+        return;
+    }
+
+    if (link->lapEventsCursor < GetOldestLapEvent()) {
+        link->lapEventsCursor = GetOldestLapEvent();
+    }
+
+    while (link->lapEventsCursor != lapEventsHead) {
+        uint32_t sequence = link->lapEventsCursor++;
+        const StoredEvent &e = lapEvents[sequence % LAP_EVENTS_MAX];
+
+        std::vector<uint8_t> record;
+        SimulatedStopwatch_PutUint32(record, sequence);
+        record.push_back(e.kind);
+        record.push_back(e.lapIndex);
+        SimulatedStopwatch_PutUint32(record, e.tick);
+        SimulatedStopwatch_PutUint32(record, e.delta);
+        link->Notify(LAP_EVENTS_VALUE_HANDLE, record);
+    }
+}
+
+void SimulatedStopwatch::NotifyAll(uint16_t cccHandle, uint16_t valueHandle, const std::vector<uint8_t> &value) {
+    for (auto *link : links) {
+        if (link->enabledCcc.count(cccHandle)) {
+            link->Notify(valueHandle, value);
+        }
+    }
+}
+
+uint8_t SimulatedStopwatch::HandleRead(uint16_t handle, std::vector<uint8_t> &value) {
+    switch (handle) {
+        case STATUS_VALUE_HANDLE:
+            value.push_back(isRunning);
+            return ATT_SUCCESS;
+
+        case ELAPSED_VALUE_HANDLE:
+            SimulatedStopwatch_PutUint32(value, isRunning ? GetTick() - startTick : totalTime);
+            return ATT_SUCCESS;
+
+        case LAPS_COUNT_VALUE_HANDLE:
+            value.push_back(lapOffsets.size());
+            return ATT_SUCCESS;
+
+        case LAP_SELECT_VALUE_HANDLE:
+            value.push_back(lapSelect);
+            return ATT_SUCCESS;
+
+        case LAP_TIME_VALUE_HANDLE: {
+            uint32_t time = 0;
+            if (lapSelect < lapOffsets.size()) {
+                time = lapOffsets[lapSelect] - (lapSelect == 0 ? startTick : lapOffsets[lapSelect - 1]);
+            }
+            SimulatedStopwatch_PutUint32(value, time);
+            return ATT_SUCCESS;
+        }
+
+        case ENERGY_VALUE_HANDLE:
+            value = energyReport;
+            return ATT_SUCCESS;
+
+        case TIME_SYNC_VALUE_HANDLE:
+            SimulatedStopwatch_PutUint32(value, startTick);
+            value.push_back(isRunning ? 0x01 : 0x00);
+            return ATT_SUCCESS;
+
+        case LAP_EVENTS_VALUE_HANDLE:
+            SimulatedStopwatch_PutUint32(value, lapEventsHead);
+            SimulatedStopwatch_PutUint32(value, GetOldestLapEvent());
+            SimulatedStopwatch_PutUint32(value, lapEventsStreamId);
+            return ATT_SUCCESS;
+
+        case LAP_EVENTS_CHARACTERISTICS_HANDLE:
+            value.push_back(0x1A);
+            value.push_back(LAP_EVENTS_VALUE_HANDLE & 0xFF);
+            value.push_back(LAP_EVENTS_VALUE_HANDLE >> 8);
+            value.push_back(LAP_EVENTS_UUID);
+            value.insert(value.end(), UUID_BASE, UUID_BASE + sizeof(UUID_BASE));
+            return ATT_SUCCESS;
+
+        default:
+            return ATT_ERR_INVALID_HANDLE;
+    }
+}
+
+uint8_t SimulatedStopwatch::HandleWrite(SimulatedTransport *link, uint16_t handle, const std::vector<uint8_t> &value) {
+    switch (handle) {
+        case STATUS_CCC_HANDLE:
+        case LAPS_COUNT_CCC_HANDLE:
+        case TIME_SYNC_CCC_HANDLE:
+        case LAP_EVENTS_CCC_HANDLE:
+            if (value.size() != 2) {
+                return ATT_ERR_LENGTH;
+            }
+            if (value[0] & 0x01) {
+                link->enabledCcc.insert(handle);
+            } else {
+                link->enabledCcc.erase(handle);
+            }
+            // newly subscribed client gets only new events, like in firmware
+            if (handle == LAP_EVENTS_CCC_HANDLE) {
+                link->lapEventsCursor = lapEventsHead;
+            }
+            return ATT_SUCCESS;
+
+        case LAP_SELECT_VALUE_HANDLE:
+            if (value.size() < 1) {
+                return ATT_ERR_LENGTH;
+            }
+            lapSelect = value[0];
+            return ATT_SUCCESS;
+
+        case CONTROL_VALUE_HANDLE:
+            // simulated device has no time sync, timestamped commands are refused like on unsynchronized device
+            if (value.size() == 9) {
+                return ATT_ERR_NOT_SYNCHRONIZED;
+            }
+            if (value.size() != 1) {
+                return ATT_ERR_LENGTH;
+            }
+            return ExecuteCommand(value[0]);
+
+        case LAP_EVENTS_VALUE_HANDLE: {
+            if (value.size() != 4) {
+                return ATT_ERR_LENGTH;
+            }
+            uint32_t sequence = SimulatedStopwatch_GetUint32(value.data());
+            if (sequence < GetOldestLapEvent() || sequence > lapEventsHead) {
+                return ATT_ERR_RANGE;
+            }
+            link->lapEventsCursor = sequence;
+            SendLapEvents(link);
+            return ATT_SUCCESS;
+        }
+
+        default:
+            return ATT_ERR_INVALID_HANDLE;
+    }
+}
+
+std::vector<uint8_t> SimulatedStopwatch::HandlePdu(SimulatedTransport *link, const std::vector<uint8_t> &pdu) {
+    uint8_t opcode = pdu[0];
+    uint16_t handle = pdu.size() >= 3 ? pdu[1] | (pdu[2] << 8) : 0;
+    std::vector<uint8_t> value;
+    uint8_t status;
+
+    switch (opcode) {
+        case ATT_OP_READ_REQ:
+            status = HandleRead(handle, value);
+            if (status == ATT_SUCCESS) {
+                value.insert(value.begin(), ATT_OP_READ_RSP);
+                return value;
+            }
+            break;
+
+        case ATT_OP_WRITE_REQ:
+            status = HandleWrite(link, handle, std::vector<uint8_t>(pdu.begin() + 3, pdu.end()));
+            if (status == ATT_SUCCESS) {
+                return {ATT_OP_WRITE_RSP};
+            }
+            break;
+
+        case ATT_OP_WRITE_CMD:
+            HandleWrite(link, handle, std::vector<uint8_t>(pdu.begin() + 3, pdu.end()));
+            return {};
+
+        case ATT_OP_HANDLE_VALUE_CNF:
+            return {};
+
+        case ATT_OP_MTU_REQ:
+            return {ATT_OP_MTU_RSP, ATT_DEFAULT_MTU, 0x00};
+
+        default:
+            status = ATT_ERR_REQ_NOT_SUPPORTED;
+            break;
+    }
+
+    return {ATT_OP_ERROR_RSP, opcode, (uint8_t)(handle & 0xFF), (uint8_t)(handle >> 8), status};
+}
+
+SimulatedTransport::SimulatedTransport(EventLoop &loop, SimulatedStopwatch &device, SimulatedLinkConfig config)
+    : loop(loop), device(device), config(config), random(std::random_device()()) {
+}
+
+SimulatedTransport::~SimulatedTransport() {
+    for (uint64_t timer : timers) {
+        loop.CancelTimer(timer);
+    }
+    device.AccountRadioEvents();
+    device.AccountDeepSleepBlocked();
+    device.links.erase(this);
+}
+
+EventLoop::Clock::time_point SimulatedTransport::NextConnectionEvent(EventLoop::Clock::time_point after) const {
+    auto interval = std::chrono::duration_cast<EventLoop::Clock::duration>(std::chrono::duration<double, std::milli>(config.connectionIntervalMs));
+    auto events = (after - connectionTime) / interval + 1;
+    return connectionTime + events * interval;
+}
+
+// deliveries keep their order, each happens in connection event not earlier than previous one
+void SimulatedTransport::Deliver(EventLoop::Clock::time_point time, std::function<void()> action) {
+    if (time < lastDelivery) {
+        time = lastDelivery;
+    }
+    lastDelivery = time;
+
+    auto timerId = std::make_shared<uint64_t>(0);
+    *timerId = loop.AddTimer(time - EventLoop::Clock::now(), [this, timerId, action]() {
+        timers.erase(*timerId);
+        action();
+    });
+    timers.insert(*timerId);
+}
+
+void SimulatedTransport::Connect(ConnectCallback callback) {
+    connectionTime = EventLoop::Clock::now();
+    lastDelivery = connectionTime;
+
+    auto interval = std::chrono::duration<double, std::milli>(config.connectionIntervalMs * SIMULATED_CONNECT_EVENTS);
+    Deliver(connectionTime + std::chrono::duration_cast<EventLoop::Clock::duration>(interval), [this, callback]() {
+        lapEventsCursor = device.lapEventsHead;
+        enabledCcc.clear();
+        device.AccountRadioEvents();
+        device.AccountDeepSleepBlocked();
+        device.links.insert(this);
+        SetConnected();
+        callback(0);
+    });
+}
+
+void SimulatedTransport::Disconnect() {
+    for (uint64_t timer : timers) {
+        loop.CancelTimer(timer);
+    }
+    timers.clear();
+    device.AccountRadioEvents();
+    device.AccountDeepSleepBlocked();
+    device.links.erase(this);
+    SetDisconnected();
+}
+
+void SimulatedTransport::SendPdu(const std::vector<uint8_t> &pdu) {
+    auto arrival = NextConnectionEvent(EventLoop::Clock::now());
+
+    auto timerId = std::make_shared<uint64_t>(0);
+    *timerId = loop.AddTimer(arrival - EventLoop::Clock::now(), [this, timerId, pdu, arrival]() {
+        timers.erase(*timerId);
+
+        std::vector<uint8_t> response = device.HandlePdu(this, pdu);
+        if (!response.empty()) {
+            Deliver(NextConnectionEvent(arrival), [this, response]() { ReceivePdu(response.data(), response.size()); });
+        }
+    });
+    timers.insert(*timerId);
+}
+
+void SimulatedTransport::Notify(uint16_t handle, const std::vector<uint8_t> &value) {
+    if (std::uniform_real_distribution<double>(0, 1)(random) < config.notificationLoss) {
+        return;
+    }
+
+    std::vector<uint8_t> pdu = {ATT_OP_HANDLE_VALUE_NTF, (uint8_t)(handle & 0xFF), (uint8_t)(handle >> 8)};
+    pdu.insert(pdu.end(), value.begin(), value.end());
+    Deliver(NextConnectionEvent(EventLoop::Clock::now()), [this, pdu]() { ReceivePdu(pdu.data(), pdu.size()); });
+}
@@ -0,0 +1,147 @@
+#ifndef SIMULATED_STOPWATCH_H
+#define SIMULATED_STOPWATCH_H
+
+#include "AttBearer.h"
+#include "EventLoop.h"
+#include "StopwatchProtocol.h"
+
+extern "C" {
+#include "../max32655_firmware/EnergyModel.h"
+}
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+class SimulatedTransport;
+
+// In-process model of stopwatch firmware GATT server (BLE.c and GUI.c), with athlete pressing lap at random
+// intervals. Several clients may be attached at once, like centrals connected to real device. Activity of
+// firmware (GUI ticks, display frames, LED frames, fuel gauge polls, radio events, power states) is counted like
+// device counts it and turned into Energy characteristic by EnergyModel.c of firmware.
+class SimulatedStopwatch {
+   public:
+    SimulatedStopwatch(EventLoop &loop, unsigned seed);
+    ~SimulatedStopwatch();
+
+    uint32_t GetTick() const;
+
+    // athlete starts, laps every minLapMs..maxLapMs, stops after lapsPerRun laps, resets and starts again
+    void StartAthlete(int minLapMs, int maxLapMs, int lapsPerRun);
+
+    // returns ATT status like control characteristic of firmware
+    uint8_t ExecuteCommand(uint8_t command);
+
+   private:
+    friend class SimulatedTransport;
+
+    struct StoredEvent {
+        StopwatchProtocol::LapEventKind kind;
+        uint8_t lapIndex;
+        uint32_t tick;
+        uint32_t delta;
+    };
+
+    EventLoop &loop;
+    std::mt19937 random;
+    EventLoop::Clock::time_point bootTime;
+    std::set<SimulatedTransport *> links;
+
+    bool isRunning = false;
+    uint32_t startTick = 0;
+    uint32_t totalTime = 0;
+    std::vector<uint32_t> lapOffsets;
+    uint8_t lapSelect = 0;
+
+    StoredEvent lapEvents[StopwatchProtocol::LAP_EVENTS_MAX];
+    uint32_t lapEventsHead = 0;
+    uint32_t lapEventsStreamId;
+
+    int minLapMs = 0;
+    int maxLapMs = 0;
+    int lapsPerRun = 0;
+    uint64_t athleteTimer = 0;
+
+    // counters Energy.c reads on device, residency is split from CPU active time summed per activity and time
+    // deep sleep was blocked when sample is taken
+    EnergyModel_Counters energyCounters = {};
+    EnergyModel_Counters lastEnergyCounters = {};
+    int energyCurrents[ENERGY_SUBSYSTEM_COUNT] = {};
+    double radioEvents = 0;
+    double activeUs = 0;
+    double deepSleepBlockedUs = 0;
+    EventLoop::Clock::time_point energySampleTime;
+    EventLoop::Clock::time_point radioAccountTime;
+    EventLoop::Clock::time_point deepSleepBlockedSince;
+    std::vector<uint8_t> energyReport;
+    uint64_t guiTimer = 0;
+    uint32_t guiTickCount = 0;
+    uint64_t fuelGaugeTimer = 0;
+    uint64_t energyTimer = 0;
+
+    void Start(uint32_t tick);
+    void Stop(uint32_t tick);
+    void Lap(uint32_t tick);
+    void Reset();
+    void AthleteStep();
+
+    void GuiTick();
+    void FuelGaugePoll();
+    void AccountRadioEvents();
+    void AccountDeepSleepBlocked();
+    void SampleEnergy();
+
+    uint32_t GetOldestLapEvent() const;
+    void AddLapEvent(StopwatchProtocol::LapEventKind kind, uint8_t lapIndex, uint32_t tick, uint32_t delta);
+    void SendLapEvents(SimulatedTransport *link);
+    void NotifyAll(uint16_t cccHandle, uint16_t valueHandle, const std::vector<uint8_t> &value);
+
+    // returns response PDU, empty for commands
+    std::vector<uint8_t> HandlePdu(SimulatedTransport *link, const std::vector<uint8_t> &pdu);
+    uint8_t HandleRead(uint16_t handle, std::vector<uint8_t> &value);
+    uint8_t HandleWrite(SimulatedTransport *link, uint16_t handle, const std::vector<uint8_t> &value);
+};
+
+struct SimulatedLinkConfig {
+    double connectionIntervalMs = 30;
+    // probability of notification being lost, exercises sequence gap handling of client
+    double notificationLoss = 0;
+};
+
+// ATT bearer to simulated device. PDUs travel in connection events, request is answered in the event following
+// the one which carried it, like in firmware.
+class SimulatedTransport : public AttBearer {
+   public:
+    using ConnectCallback = std::function<void(int error)>;
+
+    SimulatedTransport(EventLoop &loop, SimulatedStopwatch &device, SimulatedLinkConfig config);
+    ~SimulatedTransport() override;
+
+    void Connect(ConnectCallback callback);
+    void Disconnect();
+
+   protected:
+    void SendPdu(const std::vector<uint8_t> &pdu) override;
+
+   private:
+    friend class SimulatedStopwatch;
+
+    EventLoop &loop;
+    SimulatedStopwatch &device;
+    SimulatedLinkConfig config;
+    std::mt19937 random;
+    EventLoop::Clock::time_point connectionTime;
+    EventLoop::Clock::time_point lastDelivery;
+    std::set<uint64_t> timers;
+    std::set<uint16_t> enabledCcc;
+    uint32_t lapEventsCursor = 0;
+
+    EventLoop::Clock::time_point NextConnectionEvent(EventLoop::Clock::time_point after) const;
+    void Deliver(EventLoop::Clock::time_point time, std::function<void()> action);
+    void Notify(uint16_t handle, const std::vector<uint8_t> &value);
+};
+
+#endif
@@ -0,0 +1,315 @@
+/* self */
+#include "StopwatchClient.h"
+
+/* stdlib */
+#include <algorithm>
+
+using namespace StopwatchProtocol;
+
+#define STOPWATCH_CLIENT_DECLARATION_LEN 19
+
+static uint16_t StopwatchClient_GetUint16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t StopwatchClient_GetUint32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static std::vector<uint8_t> StopwatchClient_Uint32(uint32_t x) {
+    return {(uint8_t)x, (uint8_t)(x >> 8), (uint8_t)(x >> 16), (uint8_t)(x >> 24)};
+}
+
+// fixed handles are trusted only when lap events characteristic is where this client expects it
+static bool StopwatchClient_IsLayoutValid(const std::vector<uint8_t> &declaration) {
+    return declaration.size() == STOPWATCH_CLIENT_DECLARATION_LEN &&
+           (declaration[1] | (declaration[2] << 8)) == LAP_EVENTS_VALUE_HANDLE &&
+           declaration[3] == LAP_EVENTS_UUID &&
+           std::equal(declaration.begin() + 4, declaration.end(), UUID_BASE);
+}
+
+void StopwatchClient::Attach(AttBearer &bearer, ReadyCallback callback) {
+    this->bearer = &bearer;
+    readyCallback = std::move(callback);
+    isStreaming = false;
+    isReplayPending = false;
+
+    bearer.SetNotificationCallback([this](uint16_t handle, const std::vector<uint8_t> &value) { HandleNotification(handle, value); });
+
+    // everything is queued upfront, notifications arriving before stream status is known are dropped and replayed later
+    bearer.Read(LAP_EVENTS_CHARACTERISTICS_HANDLE, [this](uint8_t error, const std::vector<uint8_t> &value) {
+        if (error == ATT_SUCCESS && !StopwatchClient_IsLayoutValid(value)) {
+            error = ATT_ERR_INVALID_HANDLE;
+        }
+        if (error) {
+            Fail(error);
+        }
+    });
+
+    bearer.Write(STATUS_CCC_HANDLE, {0x01, 0x00}, [this](uint8_t error, const std::vector<uint8_t> &) {
+        if (error) {
+            Fail(error);
+        }
+    });
+
+    bearer.Write(LAP_EVENTS_CCC_HANDLE, {0x01, 0x00}, [this](uint8_t error, const std::vector<uint8_t> &) {
+        if (error) {
+            Fail(error);
+        }
+    });
+
+    bearer.Read(STATUS_VALUE_HANDLE, [this](uint8_t error, const std::vector<uint8_t> &value) {
+        if (error || value.size() != 1) {
+            Fail(error ? error : (uint8_t)ATT_ERR_LENGTH);
+            return;
+        }
+
+        isRunning = value[0];
+        if (statusCallback) {
+            statusCallback(isRunning);
+        }
+    });
+
+    bearer.Read(LAP_EVENTS_VALUE_HANDLE, [this](uint8_t error, const std::vector<uint8_t> &value) {
+        if (error || value.size() != LAP_EVENTS_STATUS_LEN) {
+            Fail(error ? error : (uint8_t)ATT_ERR_LENGTH);
+            return;
+        }
+
+        StartStream(StreamStatus{StopwatchClient_GetUint32(&value[0]), StopwatchClient_GetUint32(&value[4]), StopwatchClient_GetUint32(&value[8])});
+    });
+}
+
+void StopwatchClient::Detach() {
+    if (bearer) {
+        bearer->SetNotificationCallback(nullptr);
+    }
+    bearer = nullptr;
+    readyCallback = nullptr;
+    isStreaming = false;
+}
+
+void StopwatchClient::SendCommand(Command command) {
+    if (bearer) {
+        bearer->WriteCommand(CONTROL_VALUE_HANDLE, {command});
+    }
+}
+
+void StopwatchClient::ReadEnergy(EnergyCallback callback) {
+    if (!bearer) {
+        return;
+    }
+
+    bearer->Read(ENERGY_VALUE_HANDLE, [callback](uint8_t error, const std::vector<uint8_t> &value) {
+        EnergyReport report = {};
+        if (error == ATT_SUCCESS && value.size() != ENERGY_REPORT_LEN) {
+            error = ATT_ERR_LENGTH;
+        }
+        if (error == ATT_SUCCESS) {
+            for (int i = 0; i < ENERGY_SUBSYSTEM_COUNT; i++) {
+                report.subsystemCurrent[i] = StopwatchClient_GetUint16(&value[i * 2]);
+            }
+            report.totalCurrent = StopwatchClient_GetUint16(&value[ENERGY_SUBSYSTEM_COUNT * 2]);
+            report.measuredCurrent = StopwatchClient_GetUint16(&value[ENERGY_SUBSYSTEM_COUNT * 2 + 2]);
+            report.remainingMinutes = StopwatchClient_GetUint16(&value[ENERGY_SUBSYSTEM_COUNT * 2 + 4]);
+        }
+        callback(error, report);
+    });
+}
+
+void StopwatchClient::SetLapCallback(LapCallback callback) {
+    lapCallback = std::move(callback);
+}
+
+void StopwatchClient::SetStatusCallback(StatusCallback callback) {
+    statusCallback = std::move(callback);
+}
+
+void StopwatchClient::SetClearedCallback(ClearedCallback callback) {
+    clearedCallback = std::move(callback);
+}
+
+bool StopwatchClient::IsRunning() const {
+    return isRunning;
+}
+
+uint32_t StopwatchClient::GetStartTick() const {
+    return startTick;
+}
+
+const std::vector<uint32_t> &StopwatchClient::GetLaps() const {
+    return laps;
+}
+
+// only first error of attach is reported, requests queued after it fail as well
+void StopwatchClient::Fail(uint8_t error) {
+    ReadyCallback callback = std::move(readyCallback);
+    readyCallback = nullptr;
+    if (callback) {
+        callback(error, false);
+    }
+}
+
+// laps already known are kept when device still holds all events since the last one applied
+void StopwatchClient::StartStream(const StreamStatus &status) {
+    if (hasStream && status.streamId == streamId && nextSequence >= status.oldest && nextSequence <= status.next) {
+        isStreaming = true;
+        RequestReplay(true);
+        return;
+    }
+
+    ReloadLaps(status);
+}
+
+// stream continues from position read before reload, laps loaded meanwhile are skipped during replay
+void StopwatchClient::ReloadLaps(const StreamStatus &status) {
+    // interrupted reload must not be resumed
+    isStreaming = false;
+    hasStream = false;
+    streamId = status.streamId;
+    nextSequence = status.next;
+    ClearLaps();
+
+    bearer->Read(TIME_SYNC_VALUE_HANDLE, [this](uint8_t error, const std::vector<uint8_t> &value) {
+        if (error == ATT_SUCCESS && value.size() >= 4) {
+            startTick = StopwatchClient_GetUint32(value.data());
+        }
+    });
+
+    bearer->Read(LAPS_COUNT_VALUE_HANDLE, [this](uint8_t error, const std::vector<uint8_t> &value) {
+        if (error || value.size() != 1) {
+            Fail(error ? error : (uint8_t)ATT_ERR_LENGTH);
+            return;
+        }
+
+        // all lap reads are queued at once, link carries one per connection event without waiting for this side.
+        // Live events are applied only after the last lap is loaded, earlier ones come again in replay.
+        uint8_t count = value[0];
+        for (uint8_t i = 0; i < count; i++) {
+            bearer->Write(LAP_SELECT_VALUE_HANDLE, {i}, [](uint8_t, const std::vector<uint8_t> &) {});
+            bearer->Read(LAP_TIME_VALUE_HANDLE, [this, i, count](uint8_t error, const std::vector<uint8_t> &value) {
+                if (error == ATT_SUCCESS && value.size() == 4) {
+                    AddLap(i, StopwatchClient_GetUint32(value.data()));
+                }
+                if (i == count - 1) {
+                    hasStream = true;
+                    isStreaming = true;
+                }
+            });
+        }
+        if (count == 0) {
+            hasStream = true;
+            isStreaming = true;
+        }
+
+        RequestReplay(false);
+    });
+}
+
+void StopwatchClient::RequestReplay(bool isResumed) {
+    isReplayPending = true;
+
+    bearer->Write(LAP_EVENTS_VALUE_HANDLE, StopwatchClient_Uint32(nextSequence), [this, isResumed](uint8_t error, const std::vector<uint8_t> &) {
+        isReplayPending = false;
+        if (error == ATT_ERR_DISCONNECTED) {
+            Fail(error);
+            return;
+        }
+
+        // device no longer holds events since last applied one
+        if (error) {
+            isStreaming = false;
+            bearer->Read(LAP_EVENTS_VALUE_HANDLE, [this](uint8_t error, const std::vector<uint8_t> &value) {
+                if (error || value.size() != LAP_EVENTS_STATUS_LEN) {
+                    Fail(error ? error : (uint8_t)ATT_ERR_LENGTH);
+                    return;
+                }
+                ReloadLaps(StreamStatus{StopwatchClient_GetUint32(&value[0]), StopwatchClient_GetUint32(&value[4]), StopwatchClient_GetUint32(&value[8])});
+            });
+            return;
+        }
+
+        ReadyCallback callback = std::move(readyCallback);
+        readyCallback = nullptr;
+        if (callback) {
+            callback(ATT_SUCCESS, isResumed);
+        }
+    });
+}
+
+void StopwatchClient::ClearLaps() {
+    laps.clear();
+    if (clearedCallback) {
+        clearedCallback();
+    }
+}
+
+// lap loaded by reload is skipped when replay delivers it again
+void StopwatchClient::AddLap(uint8_t lapIndex, uint32_t lapTime) {
+    if (lapIndex != laps.size()) {
+        return;
+    }
+
+    laps.push_back(lapTime);
+    if (lapCallback) {
+        lapCallback(lapIndex, lapTime);
+    }
+}
+
+void StopwatchClient::HandleNotification(uint16_t handle, const std::vector<uint8_t> &value) {
+    if (handle == STATUS_VALUE_HANDLE && value.size() == 1) {
+        isRunning = value[0];
+        if (statusCallback) {
+            statusCallback(isRunning);
+        }
+        return;
+    }
+
+    if (handle != LAP_EVENTS_VALUE_HANDLE || value.size() != LAP_EVENT_LEN || !isStreaming) {
+        return;
+    }
+
+    LapEvent event;
+    event.sequence = StopwatchClient_GetUint32(&value[0]);
+    event.kind = (LapEventKind)value[4];
+    event.lapIndex = value[5];
+    event.tick = StopwatchClient_GetUint32(&value[6]);
+    event.delta = StopwatchClient_GetUint32(&value[10]);
+
+    // replay overlapping with live events delivers some of them twice
+    if (event.sequence < nextSequence) {
+        return;
+    }
+
+    // notification was lost, events since last applied one are requested and the rest is dropped until they come.
+    // Replayed notification may be lost as well, so gap seen after replay completed asks again.
+    if (event.sequence > nextSequence) {
+        if (!isReplayPending) {
+            RequestReplay(false);
+        }
+        return;
+    }
+
+    HandleLapEvent(event);
+    nextSequence = event.sequence + 1;
+}
+
+void StopwatchClient::HandleLapEvent(const LapEvent &event) {
+    switch (event.kind) {
+        case LAP_EVENT_START:
+            startTick = event.tick;
+            ClearLaps();
+            break;
+
+        case LAP_EVENT_RESET:
+            ClearLaps();
+            break;
+
+        case LAP_EVENT_LAP:
+            AddLap(event.lapIndex, event.delta);
+            break;
+
+        default:
+            break;
+    }
+}
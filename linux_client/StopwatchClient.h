@@ -0,0 +1,70 @@
+#ifndef STOPWATCH_CLIENT_H
+#define STOPWATCH_CLIENT_H
+
+#include "AttBearer.h"
+#include "StopwatchProtocol.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Stopwatch state kept in sync over any ATT bearer. Laps follow lap event stream, so after reconnect only
+// events missed meanwhile are replayed, laps are reloaded only when device no longer holds them.
+class StopwatchClient {
+   public:
+    using ReadyCallback = std::function<void(uint8_t error, bool isResumed)>;
+    using LapCallback = std::function<void(uint8_t lapIndex, uint32_t lapTime)>;
+    using StatusCallback = std::function<void(bool isRunning)>;
+    using ClearedCallback = std::function<void()>;
+    using EnergyCallback = std::function<void(uint8_t error, const StopwatchProtocol::EnergyReport &report)>;
+
+    // queues whole attach sequence at once, callback runs when live lap events are flowing
+    void Attach(AttBearer &bearer, ReadyCallback callback);
+    void Detach();
+
+    void SendCommand(StopwatchProtocol::Command command);
+    void ReadEnergy(EnergyCallback callback);
+
+    void SetLapCallback(LapCallback callback);
+    void SetStatusCallback(StatusCallback callback);
+    void SetClearedCallback(ClearedCallback callback);
+
+    bool IsRunning() const;
+    uint32_t GetStartTick() const;
+    const std::vector<uint32_t> &GetLaps() const;
+
+   private:
+    struct StreamStatus {
+        uint32_t next;
+        uint32_t oldest;
+        uint32_t streamId;
+    };
+
+    AttBearer *bearer = nullptr;
+    ReadyCallback readyCallback;
+    LapCallback lapCallback;
+    StatusCallback statusCallback;
+    ClearedCallback clearedCallback;
+
+    bool isRunning = false;
+    uint32_t startTick = 0;
+    std::vector<uint32_t> laps;
+
+    bool hasStream = false;
+    bool isStreaming = false;
+    uint32_t streamId = 0;
+    uint32_t nextSequence = 0;
+    bool isReplayPending = false;
+
+    void Fail(uint8_t error);
+    void StartStream(const StreamStatus &status);
+    void ReloadLaps(const StreamStatus &status);
+    void RequestReplay(bool isResumed);
+    void ClearLaps();
+    void AddLap(uint8_t lapIndex, uint32_t lapTime);
+
+    void HandleNotification(uint16_t handle, const std::vector<uint8_t> &value);
+    void HandleLapEvent(const StopwatchProtocol::LapEvent &event);
+};
+
+#endif
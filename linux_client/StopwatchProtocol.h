@@ -0,0 +1,125 @@
+#ifndef STOPWATCH_PROTOCOL_H
+#define STOPWATCH_PROTOCOL_H
+
+#include <cstdint>
+
+// Handles of stopwatch service are fixed and only appended to (see handle enum in BLE.c),
+// so this client uses them directly without GATT discovery. Keep in sync with firmware.
+namespace StopwatchProtocol {
+
+enum : uint16_t {
+    SERVICE_HANDLE = 1000,
+
+    STATUS_CHARACTERISTICS_HANDLE,
+    STATUS_VALUE_HANDLE,
+    STATUS_CCC_HANDLE,
+    STATUS_CHARACTERISTICS_NAME_HANDLE,
+
+    ELAPSED_CHARACTERISTICS_HANDLE,
+    ELAPSED_VALUE_HANDLE,
+    ELAPSED_CHARACTERISTICS_NAME_HANDLE,
+
+    LAPS_COUNT_CHARACTERISTICS_HANDLE,
+    LAPS_COUNT_VALUE_HANDLE,
+    LAPS_COUNT_CCC_HANDLE,
+    LAPS_COUNT_CHARACTERISTICS_NAME_HANDLE,
+
+    LAP_SELECT_CHARACTERISTICS_HANDLE,
+    LAP_SELECT_VALUE_HANDLE,
+    LAP_SELECT_CHARACTERISTICS_NAME_HANDLE,
+
+    LAP_TIME_CHARACTERISTICS_HANDLE,
+    LAP_TIME_VALUE_HANDLE,
+    LAP_TIME_CHARACTERISTICS_NAME_HANDLE,
+
+    ENERGY_CHARACTERISTICS_HANDLE,
+    ENERGY_VALUE_HANDLE,
+    ENERGY_CHARACTERISTICS_NAME_HANDLE,
+
+    DIAGNOSTICS_CHARACTERISTICS_HANDLE,
+    DIAGNOSTICS_VALUE_HANDLE,
+    DIAGNOSTICS_CHARACTERISTICS_NAME_HANDLE,
+
+    TRACE_CHARACTERISTICS_HANDLE,
+    TRACE_VALUE_HANDLE,
+    TRACE_CHARACTERISTICS_NAME_HANDLE,
+
+    TIME_SYNC_CHARACTERISTICS_HANDLE,
+    TIME_SYNC_VALUE_HANDLE,
+    TIME_SYNC_CCC_HANDLE,
+    TIME_SYNC_CHARACTERISTICS_NAME_HANDLE,
+
+    CONTROL_CHARACTERISTICS_HANDLE,
+    CONTROL_VALUE_HANDLE,
+    CONTROL_CHARACTERISTICS_NAME_HANDLE,
+
+    LAP_EVENTS_CHARACTERISTICS_HANDLE,
+    LAP_EVENTS_VALUE_HANDLE,
+    LAP_EVENTS_CCC_HANDLE,
+    LAP_EVENTS_CHARACTERISTICS_NAME_HANDLE,
+
+    SESSION_CHARACTERISTICS_HANDLE,
+    SESSION_VALUE_HANDLE,
+    SESSION_CCC_HANDLE,
+    SESSION_CHARACTERISTICS_NAME_HANDLE,
+
+    LAP_STATS_CHARACTERISTICS_HANDLE,
+    LAP_STATS_VALUE_HANDLE,
+    LAP_STATS_CHARACTERISTICS_NAME_HANDLE,
+
+    LAST_HANDLE
+};
+
+// first byte of 128-bit UUIDs, rest is common for whole service
+constexpr uint8_t UUID_BASE[15] = {0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c};
+constexpr uint8_t LAP_EVENTS_UUID = 0x23;
+
+constexpr uint32_t TICK_PER_SEC = 32768;
+
+// application ATT errors, keep in sync with BLE_ATT_ERR_* in firmware
+constexpr uint8_t ATT_ERR_NOT_SYNCHRONIZED = 0x80;
+constexpr uint8_t ATT_ERR_BAD_STATE = 0x81;
+
+// currents in uA of display, fuel gauge, LED, radio, CPU, then total, measured and remaining runtime in minutes,
+// all u16, keep in sync with Energy_GetReport in firmware
+constexpr int ENERGY_REPORT_LEN = 16;
+constexpr int ENERGY_SUBSYSTEM_COUNT = 5;
+
+constexpr int LAP_EVENT_LEN = 14;
+constexpr int LAP_EVENTS_STATUS_LEN = 12;
+constexpr int LAP_EVENTS_MAX = 64;
+
+// keep in sync with GUI_COMMAND_* in firmware
+enum Command : uint8_t {
+    COMMAND_START,
+    COMMAND_STOP,
+    COMMAND_LAP,
+    COMMAND_RESET,
+};
+
+// keep in sync with BLE_LAP_EVENT_* in firmware
+enum LapEventKind : uint8_t {
+    LAP_EVENT_START,
+    LAP_EVENT_LAP,
+    LAP_EVENT_STOP,
+    LAP_EVENT_RESET,
+};
+
+struct EnergyReport {
+    uint16_t subsystemCurrent[ENERGY_SUBSYSTEM_COUNT];
+    uint16_t totalCurrent;
+    uint16_t measuredCurrent;
+    uint16_t remainingMinutes;
+};
+
+struct LapEvent {
+    uint32_t sequence;
+    LapEventKind kind;
+    uint8_t lapIndex;
+    uint32_t tick;
+    uint32_t delta;
+};
+
+}  // namespace StopwatchProtocol
+
+#endif
@@ -0,0 +1,265 @@
+// Command line client of stopwatch, streams laps of any number of devices over one event loop.
+//
+// Build: make
+// Usage: stopwatch_cli [-r] [-e] [-p seconds] [-c command] address...
+//        stopwatch_cli -s count [-i ms] [-l probability] [-d seconds] [-p seconds] [-c command]
+//   address  Bluetooth address of stopwatch, e.g. C0:FF:EE:00:00:01
+//   -r       addresses are random static addresses
+//   -e       require encrypted link, device must be paired with bluetoothctl first
+//   -c       send start, stop, lap or reset to every device when it is ready
+//   -s       connect to count simulated stopwatches instead of Bluetooth devices
+//   -i       connection interval of simulated links (default 30)
+//   -l       probability of losing simulated notification (default 0)
+//   -d       drop simulated links at random, on average every given number of seconds
+//   -p       print energy report of every connected device every given number of seconds, device updates it
+//            every 10 s, simulated device runs the same current model on its simulated activity
+
+#include "L2capTransport.h"
+#include "SimulatedStopwatch.h"
+#include "StopwatchClient.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#define CLI_RECONNECT_DELAY std::chrono::seconds(1)
+#define CLI_ATHLETE_MIN_LAP_MS 1500
+#define CLI_ATHLETE_MAX_LAP_MS 4000
+#define CLI_ATHLETE_LAPS 8
+
+using namespace StopwatchProtocol;
+
+struct Session {
+    std::string name;
+    std::unique_ptr<SimulatedStopwatch> device;
+    std::unique_ptr<AttBearer> bearer;
+    std::function<void()> connect;
+    std::function<void()> disconnect;
+    StopwatchClient client;
+    EventLoop::Clock::time_point connectStart;
+};
+
+static EventLoop loop;
+static std::vector<std::unique_ptr<Session>> sessions;
+static std::mt19937 dropRandom(std::random_device{}());
+static int command = -1;
+static double dropSeconds = 0;
+static double energySeconds = 0;
+
+static void Cli_Usage() {
+    fprintf(stderr, "usage: stopwatch_cli [-r] [-e] [-p seconds] [-c start|stop|lap|reset] address...\n");
+    fprintf(stderr, "       stopwatch_cli -s count [-i ms] [-l probability] [-d seconds] [-p seconds] [-c start|stop|lap|reset]\n");
+    exit(2);
+}
+
+static int Cli_ParseCommand(const char *text) {
+    static const char *names[] = {"start", "stop", "lap", "reset"};
+
+    for (int i = 0; i < 4; i++) {
+        if (strcmp(text, names[i]) == 0) {
+            return i;
+        }
+    }
+    Cli_Usage();
+    return -1;
+}
+
+static void Cli_PrintTime(const char *name, const char *what, uint32_t ticks) {
+    uint32_t ms = (uint64_t)ticks * 1000 / TICK_PER_SEC;
+    printf("%s: %s %u:%02u.%03u\n", name, what, ms / 60000, ms / 1000 % 60, ms % 1000);
+}
+
+static void Cli_Connect(Session *session) {
+    session->connectStart = EventLoop::Clock::now();
+    session->connect();
+}
+
+static void Cli_ScheduleReconnect(Session *session) {
+    loop.AddTimer(CLI_RECONNECT_DELAY, [session]() { Cli_Connect(session); });
+}
+
+// link came up, whole attach sequence is queued and runs without round trips through this code
+static void Cli_Connected(Session *session, int error) {
+    if (error) {
+        printf("%s: connect failed: %s\n", session->name.c_str(), strerror(error));
+        Cli_ScheduleReconnect(session);
+        return;
+    }
+
+    session->client.Attach(*session->bearer, [session](uint8_t error, bool isResumed) {
+        if (error) {
+            printf("%s: attach failed with ATT error 0x%02x\n", session->name.c_str(), error);
+            if (error != ATT_ERR_DISCONNECTED) {
+                session->disconnect();
+            }
+            return;
+        }
+
+        auto readyTime = std::chrono::duration_cast<std::chrono::milliseconds>(EventLoop::Clock::now() - session->connectStart);
+        printf("%s: ready in %lld ms, %s, %zu laps, %s\n", session->name.c_str(), (long long)readyTime.count(),
+               isResumed ? "resumed" : "reloaded", session->client.GetLaps().size(), session->client.IsRunning() ? "running" : "stopped");
+
+        if (command >= 0) {
+            session->client.SendCommand((Command)command);
+        }
+    });
+}
+
+static void Cli_SetupClient(Session *session) {
+    session->client.SetLapCallback([session](uint8_t lapIndex, uint32_t lapTime) {
+        char what[16];
+        snprintf(what, sizeof(what), "lap %u", lapIndex + 1);
+        Cli_PrintTime(session->name.c_str(), what, lapTime);
+    });
+
+    session->client.SetStatusCallback([session](bool isRunning) { printf("%s: %s\n", session->name.c_str(), isRunning ? "running" : "stopped"); });
+
+    session->client.SetClearedCallback([session]() { printf("%s: laps cleared\n", session->name.c_str()); });
+
+    session->bearer->SetDisconnectCallback([session]() {
+        printf("%s: disconnected\n", session->name.c_str());
+        session->client.Detach();
+        Cli_ScheduleReconnect(session);
+    });
+}
+
+static void Cli_ScheduleDrop(Session *session) {
+    double delay = std::exponential_distribution<double>(1 / dropSeconds)(dropRandom);
+
+    loop.AddTimer(std::chrono::duration_cast<EventLoop::Clock::duration>(std::chrono::duration<double>(delay)), [session]() {
+        if (session->bearer->IsConnected()) {
+            printf("%s: dropping link\n", session->name.c_str());
+            session->disconnect();
+        }
+        Cli_ScheduleDrop(session);
+    });
+}
+
+static void Cli_PrintEnergy(Session *session, uint8_t error, const EnergyReport &report) {
+    if (error) {
+        printf("%s: energy read failed with ATT error 0x%02x\n", session->name.c_str(), error);
+        return;
+    }
+
+    const uint16_t *current = report.subsystemCurrent;
+    printf("%s: display %u uA, fuel gauge %u uA, LED %u uA, radio %u uA, CPU %u uA, total %u uA, measured %u uA, runtime %u h %02u min\n",
+           session->name.c_str(), current[0], current[1], current[2], current[3], current[4], report.totalCurrent, report.measuredCurrent,
+           report.remainingMinutes / 60, report.remainingMinutes % 60);
+}
+
+static void Cli_ScheduleEnergy(Session *session) {
+    loop.AddTimer(std::chrono::duration_cast<EventLoop::Clock::duration>(std::chrono::duration<double>(energySeconds)), [session]() {
+        if (session->bearer->IsConnected()) {
+            session->client.ReadEnergy([session](uint8_t error, const EnergyReport &report) { Cli_PrintEnergy(session, error, report); });
+        }
+        Cli_ScheduleEnergy(session);
+    });
+}
+
+static void Cli_AddSimulated(int index, SimulatedLinkConfig config) {
+    auto session = std::make_unique<Session>();
+    Session *s = session.get();
+
+    s->name = "sim" + std::to_string(index);
+    s->device = std::make_unique<SimulatedStopwatch>(loop, index + 1);
+    s->device->StartAthlete(CLI_ATHLETE_MIN_LAP_MS, CLI_ATHLETE_MAX_LAP_MS, CLI_ATHLETE_LAPS);
+
+    auto transport = new SimulatedTransport(loop, *s->device, config);
+    s->bearer.reset(transport);
+    s->connect = [s, transport]() { transport->Connect([s](int error) { Cli_Connected(s, error); }); };
+    s->disconnect = [transport]() { transport->Disconnect(); };
+
+    Cli_SetupClient(s);
+    if (dropSeconds > 0) {
+        Cli_ScheduleDrop(s);
+    }
+    sessions.push_back(std::move(session));
+}
+
+static void Cli_AddBluetooth(const std::string &address, bool isRandomAddress, bool isEncrypted) {
+    auto session = std::make_unique<Session>();
+    Session *s = session.get();
+
+    s->name = address;
+
+    auto transport = new L2capTransport(loop);
+    s->bearer.reset(transport);
+    s->connect = [s, transport, address, isRandomAddress, isEncrypted]() {
+        int status = transport->Connect(address, isRandomAddress, isEncrypted, [s](int error) { Cli_Connected(s, error); });
+        if (status) {
+            Cli_Connected(s, -status);
+        }
+    };
+    s->disconnect = [transport]() { transport->Disconnect(); };
+
+    Cli_SetupClient(s);
+    sessions.push_back(std::move(session));
+}
+
+int main(int argc, char **argv) {
+    bool isRandomAddress = false;
+    bool isEncrypted = false;
+    int simulatedCount = 0;
+    SimulatedLinkConfig config;
+    int opt;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    while ((opt = getopt(argc, argv, "rec:s:i:l:d:p:")) != -1) {
+        switch (opt) {
+            case 'r':
+                isRandomAddress = true;
+                break;
+            case 'e':
+                isEncrypted = true;
+                break;
+            case 'c':
+                command = Cli_ParseCommand(optarg);
+                break;
+            case 's':
+                simulatedCount = atoi(optarg);
+                break;
+            case 'i':
+                config.connectionIntervalMs = atof(optarg);
+                break;
+            case 'l':
+                config.notificationLoss = atof(optarg);
+                break;
+            case 'd':
+                dropSeconds = atof(optarg);
+                break;
+            case 'p':
+                energySeconds = atof(optarg);
+                break;
+            default:
+                Cli_Usage();
+        }
+    }
+
+    if ((simulatedCount > 0) == (optind < argc)) {
+        Cli_Usage();
+    }
+
+    for (int i = 0; i < simulatedCount; i++) {
+        Cli_AddSimulated(i, config);
+    }
+    for (int i = optind; i < argc; i++) {
+        Cli_AddBluetooth(argv[i], isRandomAddress, isEncrypted);
+    }
+
+    for (auto &session : sessions) {
+        Cli_Connect(session.get());
+        if (energySeconds > 0) {
+            Cli_ScheduleEnergy(session.get());
+        }
+    }
+
+    loop.Run();
+    return 0;
+}
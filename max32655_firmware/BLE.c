@@ -2,7 +2,15 @@
 #include "BLE.h"
 
 /* project */
+#include "Energy.h"
 #include "GUI.h"
+#include "LapStats.h"
+#include "Power.h"
+#include "Profile.h"
+#include "Session.h"
+#include "Time.h"
+#include "TimeSync.h"
+#include "Trace.h"
 
 /* stdlib */
 #include <stdbool.h>
@@ -27,6 +35,7 @@
 #include <pal_bb.h>
 #include <pal_cfg.h>
 #include <rtc.h>
+#include <sec_api.h>
 #include <smp_api.h>
 #include <smp_handler.h>
 #include <svc_core.h>
@@ -36,6 +45,7 @@
 #include <wsf_bufio.h>
 #include <wsf_heap.h>
 #include <wsf_msg.h>
+#include <wsf_nvm.h>
 #include <wsf_timer.h>
 #include <wsf_trace.h>
 #include <wsf_types.h>
@@ -48,8 +58,10 @@ static void BLE_CccCallback(attsCccEvt_t *pEvt);
 static void BLE_Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg);
 static void BLE_Start();
 static void BLE_ProcessMessage(wsfMsgHdr_t *pMsg);
+static void BLE_UpdateBroadcast();
 static void BLE_HandlerInit(wsfHandlerId_t handlerId);
 static uint8_t BLE_StopwatchWriteCallback(dmConnId_t connId, uint16_t handle, uint8_t operation, uint16_t offset, uint16_t len, uint8_t *pValue, attsAttr_t *pAttr);
+static uint8_t BLE_StopwatchReadCallback(dmConnId_t connId, uint16_t handle, uint8_t operation, uint16_t offset, attsAttr_t *pAttr);
 
 static wsfBufPoolDesc_t memoryPoolDescriptors[] = {
     {.len = 16, .num = 8},
@@ -78,13 +90,26 @@ static const appAdvCfg_t advertisignConfig = {
     .advInterval = {800, 0, 0},
 };
 
+// broadcast listeners extrapolate between updates, so advertise faster and never time out
+static const appAdvCfg_t broadcastAdvertisignConfig = {
+    .advDuration = {0, 0, 0},
+    .advInterval = {160, 0, 0},
+};
+
+// must not exceed DM_CONN_MAX of the stack configuration
+#define BLE_CONN_MAX 3
+
+// notifications in flight per connection, slow client only delays its own notifications
+#define BLE_TX_CREDITS 2
+
 static const appSlaveCfg_t slaveConfig = {
-    .connMax = 1,
+    .connMax = BLE_CONN_MAX,
 };
 
+// central identity key lets bonded Windows host be recognised behind its private address
 static const appSecCfg_t securityConfig = {
     .auth = DM_AUTH_BOND_FLAG | DM_AUTH_SC_FLAG,
-    .iKeyDist = 0,
+    .iKeyDist = DM_KEY_DIST_IRK,
     .rKeyDist = DM_KEY_DIST_LTK,
     .oob = FALSE,
     .initiateSec = TRUE,
@@ -99,7 +124,18 @@ static const appUpdateCfg_t updateConfig = {
     .maxAttempts = 5,
 };
 
-static const uint8_t avertisignData[] = {
+#define BLE_BROADCAST_TIMER_EVENT 0xE4
+
+#define BLE_BROADCAST_UPDATE_PERIOD 1000
+
+#define BLE_BROADCAST_COMPANY_ID 0xFFFF
+#define BLE_BROADCAST_VERSION 1
+#define BLE_BROADCAST_FLAG_RUNNING 0x01
+
+// offset of manufacturer specific data payload (after company ID) in avertisignData
+#define BLE_BROADCAST_PAYLOAD_OFFSET 10
+
+static uint8_t avertisignData[] = {
     /*! flags */
     2,                                                  /*! length */
     DM_ADV_TYPE_FLAGS,                                  /*! AD type */
@@ -109,6 +145,17 @@ static const uint8_t avertisignData[] = {
     2,                    /*! length */
     DM_ADV_TYPE_TX_POWER, /*! AD type */
     0,                    /*! tx power */
+
+    /*! stopwatch broadcast */
+    15,                                          /*! length */
+    DM_ADV_TYPE_MANUFACTURER,                    /*! AD type */
+    UINT16_TO_BYTES(BLE_BROADCAST_COMPANY_ID),   /*! company ID */
+    BLE_BROADCAST_VERSION,                       /*! version */
+    0,                                           /*! flags */
+    0,                                           /*! update sequence */
+    0, 0, 0, 0,                                  /*! elapsed time */
+    0,                                           /*! laps count */
+    0, 0, 0, 0,                                  /*! last lap time */
 };
 
 static const uint8_t scanData[] = {
@@ -138,9 +185,74 @@ static const uint8_t scanData[] = {
 #define STOPWATCH_LAPS_COUNT_CHARACTERISTICS_GUID 0x20, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
 #define STOPWATCH_LAP_SELECT_CHARACTERISTICS_GUID 0x21, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
 #define STOPWATCH_LAP_TIME_CHARACTERISTICS_GUID 0x22, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_ENERGY_CHARACTERISTICS_GUID 0x30, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_DIAGNOSTICS_CHARACTERISTICS_GUID 0x31, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_TRACE_CHARACTERISTICS_GUID 0x32, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_TIME_SYNC_CHARACTERISTICS_GUID 0x40, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_CONTROL_CHARACTERISTICS_GUID 0x41, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_LAP_EVENTS_CHARACTERISTICS_GUID 0x23, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_SESSION_CHARACTERISTICS_GUID 0x50, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+#define STOPWATCH_LAP_STATS_CHARACTERISTICS_GUID 0x25, 0xca, 0x1f, 0x05, 0x95, 0x95, 0xf5, 0xd6, 0x21, 0x7c, 0xcc, 0x85, 0x88, 0x1e, 0x61, 0x2c
+
+// records drained from trace buffer by single (long) read
+#define STOPWATCH_TRACE_READ_RECORDS 20
+
+// ping: op, seq, host t1 (u64) -> notification: op, seq, t1, device receive tick t2 (u32), device reply tick t3 (u32),
+// connection interval in ticks (u32), t3 is taken when reply is queued, it leaves at the next connection event
+// set mapping: op, host time (u64), device tick (u32), drift in ppb (i32)
+// start at: op, host time (u64), cancel start: op
+#define BLE_TIME_SYNC_OP_PING 0x01
+#define BLE_TIME_SYNC_OP_SET_MAPPING 0x02
+#define BLE_TIME_SYNC_OP_START_AT 0x03
+#define BLE_TIME_SYNC_OP_CANCEL_START 0x04
+#define BLE_TIME_SYNC_PING_LEN 10
+#define BLE_TIME_SYNC_PONG_LEN 22
+#define BLE_TIME_SYNC_SET_MAPPING_LEN 17
+#define BLE_TIME_SYNC_START_AT_LEN 9
+#define BLE_TIME_SYNC_MAX_LEN BLE_TIME_SYNC_PONG_LEN
+
+// read value: stopwatch start tick (u32), flags
+#define BLE_TIME_SYNC_STATUS_LEN 5
+#define BLE_TIME_SYNC_FLAG_RUNNING 0x01
+#define BLE_TIME_SYNC_FLAG_SYNCHRONIZED 0x02
+#define BLE_TIME_SYNC_FLAG_START_SCHEDULED 0x04
+
+// Idle connection runs on interval of up to a second, sync round asks for short one, so replies take milliseconds
+// and wait for connection event adds little uncertainty. Set mapping ends round and restores idle interval.
+#define BLE_TIME_SYNC_CONN_INTERVAL_MIN 6
+#define BLE_TIME_SYNC_CONN_INTERVAL_MAX 12
+
+// command (u8) and optional host time (u64) when operator issued it, without time command applies on arrival
+#define BLE_CONTROL_COMMAND_LEN 1
+#define BLE_CONTROL_TIMESTAMPED_COMMAND_LEN 9
+
+// commands older than this are refused, mapping is probably wrong
+#define BLE_CONTROL_MAX_AGE_TICKS (10 * TIME_TICK_PER_SEC)
+
+// notification: sequence (u32), event, lap index, tick (u32), delta (u32) where delta is lap time or total time on stop
+// read: next sequence (u32), oldest retained sequence (u32), stream ID (u32), write: sequence (u32) to replay from
+#define BLE_LAP_EVENT_LEN 14
+#define BLE_LAP_EVENTS_STATUS_LEN 12
+#define BLE_LAP_EVENTS_RESYNC_LEN 4
+
+// power of two, client lagging more than this gets gap in sequence and reloads laps
+#define BLE_LAP_EVENTS_MAX 64
+
+// write: any byte starts export of current session (see Session.h), notification: offset (u16) of chunk
+// and chunk data, offset BLE_SESSION_ABORTED without data when laps were overwritten during export
+#define BLE_SESSION_START_LEN 1
+#define BLE_SESSION_OFFSET_LEN 2
+#define BLE_SESSION_CHUNK_MAX 64
+#define BLE_SESSION_ABORTED 0xFFFF
+
+// application ATT errors
+#define BLE_ATT_ERR_NOT_SYNCHRONIZED 0x80
+#define BLE_ATT_ERR_BAD_STATE 0x81
 
 #define STOPWATCH_HANDLE_OFFSET 1000
 
+// Handles are fixed and clients cache them as long as the GATT database hash matches. New attributes
+// are appended at the end only, so handles of existing ones never move between firmware versions.
 enum {
     STOPWATCH_SERVICE_HANDLE = STOPWATCH_HANDLE_OFFSET,
 
@@ -166,6 +278,41 @@ enum {
     STOPWATCH_LAP_TIME_VALUE_HANDLE,
     STOPWATCH_LAP_TIME_CHARACTERISTICS_NAME_HANDLE,
 
+    STOPWATCH_ENERGY_CHARACTERISTICS_HANDLE,
+    STOPWATCH_ENERGY_VALUE_HANDLE,
+    STOPWATCH_ENERGY_CHARACTERISTICS_NAME_HANDLE,
+
+    STOPWATCH_DIAGNOSTICS_CHARACTERISTICS_HANDLE,
+    STOPWATCH_DIAGNOSTICS_VALUE_HANDLE,
+    STOPWATCH_DIAGNOSTICS_CHARACTERISTICS_NAME_HANDLE,
+
+    STOPWATCH_TRACE_CHARACTERISTICS_HANDLE,
+    STOPWATCH_TRACE_VALUE_HANDLE,
+    STOPWATCH_TRACE_CHARACTERISTICS_NAME_HANDLE,
+
+    STOPWATCH_TIME_SYNC_CHARACTERISTICS_HANDLE,
+    STOPWATCH_TIME_SYNC_VALUE_HANDLE,
+    STOPWATCH_TIME_SYNC_CCC_HANDLE,
+    STOPWATCH_TIME_SYNC_CHARACTERISTICS_NAME_HANDLE,
+
+    STOPWATCH_CONTROL_CHARACTERISTICS_HANDLE,
+    STOPWATCH_CONTROL_VALUE_HANDLE,
+    STOPWATCH_CONTROL_CHARACTERISTICS_NAME_HANDLE,
+
+    STOPWATCH_LAP_EVENTS_CHARACTERISTICS_HANDLE,
+    STOPWATCH_LAP_EVENTS_VALUE_HANDLE,
+    STOPWATCH_LAP_EVENTS_CCC_HANDLE,
+    STOPWATCH_LAP_EVENTS_CHARACTERISTICS_NAME_HANDLE,
+
+    STOPWATCH_SESSION_CHARACTERISTICS_HANDLE,
+    STOPWATCH_SESSION_VALUE_HANDLE,
+    STOPWATCH_SESSION_CCC_HANDLE,
+    STOPWATCH_SESSION_CHARACTERISTICS_NAME_HANDLE,
+
+    STOPWATCH_LAP_STATS_CHARACTERISTICS_HANDLE,
+    STOPWATCH_LAP_STATS_VALUE_HANDLE,
+    STOPWATCH_LAP_STATS_CHARACTERISTICS_NAME_HANDLE,
+
     STOPWATCH_LAST_HANDLE
 };
 
@@ -175,6 +322,14 @@ static uint8_t stopwatchElapsedCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATC
 static uint8_t stopwatchLapsCountCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_LAPS_COUNT_CHARACTERISTICS_GUID};
 static uint8_t stopwatchLapSelectCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_LAP_SELECT_CHARACTERISTICS_GUID};
 static uint8_t stopwatchLapTimeCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_LAP_TIME_CHARACTERISTICS_GUID};
+static uint8_t stopwatchEnergyCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_ENERGY_CHARACTERISTICS_GUID};
+static uint8_t stopwatchDiagnosticsCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_DIAGNOSTICS_CHARACTERISTICS_GUID};
+static uint8_t stopwatchTraceCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_TRACE_CHARACTERISTICS_GUID};
+static uint8_t stopwatchTimeSyncCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_TIME_SYNC_CHARACTERISTICS_GUID};
+static uint8_t stopwatchControlCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_CONTROL_CHARACTERISTICS_GUID};
+static uint8_t stopwatchLapEventsCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_LAP_EVENTS_CHARACTERISTICS_GUID};
+static uint8_t stopwatchSessionCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_SESSION_CHARACTERISTICS_GUID};
+static uint8_t stopwatchLapStatsCharacteristicsGuid[ATT_128_UUID_LEN] = {STOPWATCH_LAP_STATS_CHARACTERISTICS_GUID};
 
 static uint16_t stopwatchServiceGuidLength = sizeof(stopwatchServiceGuid);
 
@@ -193,6 +348,30 @@ static uint16_t stopwatchLapSelectNameLength = sizeof(stopwatchLapSelectName);
 static uint8_t stopwatchLapTimeName[] = {'L', 'a', 'p', ' ', 'T', 'i', 'm', 'e'};
 static uint16_t stopwatchLapTimeNameLength = sizeof(stopwatchLapTimeName);
 
+static uint8_t stopwatchEnergyName[] = {'E', 'n', 'e', 'r', 'g', 'y'};
+static uint16_t stopwatchEnergyNameLength = sizeof(stopwatchEnergyName);
+
+static uint8_t stopwatchDiagnosticsName[] = {'D', 'i', 'a', 'g', 'n', 'o', 's', 't', 'i', 'c', 's'};
+static uint16_t stopwatchDiagnosticsNameLength = sizeof(stopwatchDiagnosticsName);
+
+static uint8_t stopwatchTraceName[] = {'T', 'r', 'a', 'c', 'e'};
+static uint16_t stopwatchTraceNameLength = sizeof(stopwatchTraceName);
+
+static uint8_t stopwatchTimeSyncName[] = {'T', 'i', 'm', 'e', ' ', 'S', 'y', 'n', 'c'};
+static uint16_t stopwatchTimeSyncNameLength = sizeof(stopwatchTimeSyncName);
+
+static uint8_t stopwatchControlName[] = {'C', 'o', 'n', 't', 'r', 'o', 'l'};
+static uint16_t stopwatchControlNameLength = sizeof(stopwatchControlName);
+
+static uint8_t stopwatchLapEventsName[] = {'L', 'a', 'p', ' ', 'E', 'v', 'e', 'n', 't', 's'};
+static uint16_t stopwatchLapEventsNameLength = sizeof(stopwatchLapEventsName);
+
+static uint8_t stopwatchSessionName[] = {'S', 'e', 's', 's', 'i', 'o', 'n'};
+static uint16_t stopwatchSessionNameLength = sizeof(stopwatchSessionName);
+
+static uint8_t stopwatchLapStatsName[] = {'L', 'a', 'p', ' ', 'S', 't', 'a', 't', 's'};
+static uint16_t stopwatchLapStatsNameLength = sizeof(stopwatchLapStatsName);
+
 static uint8_t stopwatchStatusCharacteristicsValue[] = {
     ATT_PROP_READ | ATT_PROP_NOTIFY,
     UINT16_TO_BYTES(STOPWATCH_STATUS_VALUE_HANDLE),
@@ -242,6 +421,84 @@ static uint16_t stopwatchLapTimeCharacteristicsValueLength = sizeof(stopwatchLap
 static uint32_t stopwatchLapTime = 0;
 static uint16_t stopwatchLapTimeLength = sizeof(stopwatchLapTime);
 
+static uint8_t stopwatchEnergyCharacteristicsValue[] = {
+    ATT_PROP_READ,
+    UINT16_TO_BYTES(STOPWATCH_ENERGY_VALUE_HANDLE),
+    STOPWATCH_ENERGY_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchEnergyCharacteristicsValueLength = sizeof(stopwatchEnergyCharacteristicsValue);
+static uint8_t stopwatchEnergy[ENERGY_REPORT_LEN] = {0};
+static uint16_t stopwatchEnergyLength = sizeof(stopwatchEnergy);
+
+static uint8_t stopwatchDiagnosticsCharacteristicsValue[] = {
+    ATT_PROP_READ | ATT_PROP_WRITE,
+    UINT16_TO_BYTES(STOPWATCH_DIAGNOSTICS_VALUE_HANDLE),
+    STOPWATCH_DIAGNOSTICS_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchDiagnosticsCharacteristicsValueLength = sizeof(stopwatchDiagnosticsCharacteristicsValue);
+static uint8_t stopwatchDiagnostics[PROFILE_REPORT_MAX_LEN] = {0};
+static uint16_t stopwatchDiagnosticsLength = 0;
+
+static uint8_t stopwatchTraceCharacteristicsValue[] = {
+    ATT_PROP_READ,
+    UINT16_TO_BYTES(STOPWATCH_TRACE_VALUE_HANDLE),
+    STOPWATCH_TRACE_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchTraceCharacteristicsValueLength = sizeof(stopwatchTraceCharacteristicsValue);
+static uint8_t stopwatchTrace[STOPWATCH_TRACE_READ_RECORDS * TRACE_RECORD_LEN] = {0};
+static uint16_t stopwatchTraceLength = 0;
+
+static uint8_t stopwatchTimeSyncCharacteristicsValue[] = {
+    ATT_PROP_READ | ATT_PROP_WRITE | ATT_PROP_WRITE_NO_RSP | ATT_PROP_NOTIFY,
+    UINT16_TO_BYTES(STOPWATCH_TIME_SYNC_VALUE_HANDLE),
+    STOPWATCH_TIME_SYNC_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchTimeSyncCharacteristicsValueLength = sizeof(stopwatchTimeSyncCharacteristicsValue);
+static uint8_t stopwatchTimeSync[BLE_TIME_SYNC_MAX_LEN] = {0};
+static uint16_t stopwatchTimeSyncLength = 0;
+static uint8_t stopwatchTimeSyncCcc[] = {UINT16_TO_BYTES(0x0000)};
+static uint16_t stopwatchTimeSyncCccLength = sizeof(stopwatchTimeSyncCcc);
+
+static uint8_t stopwatchControlCharacteristicsValue[] = {
+    ATT_PROP_WRITE | ATT_PROP_WRITE_NO_RSP,
+    UINT16_TO_BYTES(STOPWATCH_CONTROL_VALUE_HANDLE),
+    STOPWATCH_CONTROL_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchControlCharacteristicsValueLength = sizeof(stopwatchControlCharacteristicsValue);
+static uint8_t stopwatchControl[BLE_CONTROL_TIMESTAMPED_COMMAND_LEN] = {0};
+static uint16_t stopwatchControlLength = 0;
+
+static uint8_t stopwatchLapEventsCharacteristicsValue[] = {
+    ATT_PROP_READ | ATT_PROP_WRITE | ATT_PROP_NOTIFY,
+    UINT16_TO_BYTES(STOPWATCH_LAP_EVENTS_VALUE_HANDLE),
+    STOPWATCH_LAP_EVENTS_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchLapEventsCharacteristicsValueLength = sizeof(stopwatchLapEventsCharacteristicsValue);
+static uint8_t stopwatchLapEvents[BLE_LAP_EVENTS_STATUS_LEN] = {0};
+static uint16_t stopwatchLapEventsLength = 0;
+static uint8_t stopwatchLapEventsCcc[] = {UINT16_TO_BYTES(0x0000)};
+static uint16_t stopwatchLapEventsCccLength = sizeof(stopwatchLapEventsCcc);
+
+static uint8_t stopwatchSessionCharacteristicsValue[] = {
+    ATT_PROP_WRITE | ATT_PROP_NOTIFY,
+    UINT16_TO_BYTES(STOPWATCH_SESSION_VALUE_HANDLE),
+    STOPWATCH_SESSION_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchSessionCharacteristicsValueLength = sizeof(stopwatchSessionCharacteristicsValue);
+static uint8_t stopwatchSession[BLE_SESSION_START_LEN] = {0};
+static uint16_t stopwatchSessionLength = 0;
+static uint8_t stopwatchSessionCcc[] = {UINT16_TO_BYTES(0x0000)};
+static uint16_t stopwatchSessionCccLength = sizeof(stopwatchSessionCcc);
+
+static uint8_t stopwatchLapStatsCharacteristicsValue[] = {
+    ATT_PROP_READ,
+    UINT16_TO_BYTES(STOPWATCH_LAP_STATS_VALUE_HANDLE),
+    STOPWATCH_LAP_STATS_CHARACTERISTICS_GUID,
+};
+static uint16_t stopwatchLapStatsCharacteristicsValueLength = sizeof(stopwatchLapStatsCharacteristicsValue);
+static uint8_t stopwatchLapStats[LAP_STATS_REPORT_LEN] = {0};
+static uint16_t stopwatchLapStatsLength = sizeof(stopwatchLapStats);
+
 static attsAttr_t stopwatchAttributes[] = {
     /* Service */
     {
@@ -301,7 +558,7 @@ static attsAttr_t stopwatchAttributes[] = {
         .pValue = (uint8_t *)&stopwatchElapsed,
         .pLen = &stopwatchElapsedLength,
         .maxLen = sizeof(stopwatchElapsed),
-        .settings = 0,
+        .settings = ATTS_SET_READ_CBACK,
         .permissions = ATTS_PERMIT_READ,
     },
     {
@@ -398,12 +655,244 @@ static attsAttr_t stopwatchAttributes[] = {
         .settings = 0,
         .permissions = ATTS_PERMIT_READ,
     },
+
+    /* Energy characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchEnergyCharacteristicsValue,
+        .pLen = &stopwatchEnergyCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchEnergyCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchEnergyCharacteristicsGuid,
+        .pValue = stopwatchEnergy,
+        .pLen = &stopwatchEnergyLength,
+        .maxLen = sizeof(stopwatchEnergy),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchEnergyName,
+        .pLen = &stopwatchEnergyNameLength,
+        .maxLen = sizeof(stopwatchEnergyName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+
+    /* Diagnostics characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchDiagnosticsCharacteristicsValue,
+        .pLen = &stopwatchDiagnosticsCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchDiagnosticsCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchDiagnosticsCharacteristicsGuid,
+        .pValue = stopwatchDiagnostics,
+        .pLen = &stopwatchDiagnosticsLength,
+        .maxLen = sizeof(stopwatchDiagnostics),
+        .settings = ATTS_SET_VARIABLE_LEN | ATTS_SET_READ_CBACK | ATTS_SET_WRITE_CBACK,
+        .permissions = ATTS_PERMIT_READ | ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchDiagnosticsName,
+        .pLen = &stopwatchDiagnosticsNameLength,
+        .maxLen = sizeof(stopwatchDiagnosticsName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+
+    /* Trace characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchTraceCharacteristicsValue,
+        .pLen = &stopwatchTraceCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchTraceCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchTraceCharacteristicsGuid,
+        .pValue = stopwatchTrace,
+        .pLen = &stopwatchTraceLength,
+        .maxLen = sizeof(stopwatchTrace),
+        .settings = ATTS_SET_VARIABLE_LEN | ATTS_SET_READ_CBACK,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchTraceName,
+        .pLen = &stopwatchTraceNameLength,
+        .maxLen = sizeof(stopwatchTraceName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+
+    /* Time Sync characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchTimeSyncCharacteristicsValue,
+        .pLen = &stopwatchTimeSyncCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchTimeSyncCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchTimeSyncCharacteristicsGuid,
+        .pValue = stopwatchTimeSync,
+        .pLen = &stopwatchTimeSyncLength,
+        .maxLen = sizeof(stopwatchTimeSync),
+        .settings = ATTS_SET_VARIABLE_LEN | ATTS_SET_READ_CBACK | ATTS_SET_WRITE_CBACK,
+        .permissions = ATTS_PERMIT_READ | ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attCliChCfgUuid,
+        .pValue = stopwatchTimeSyncCcc,
+        .pLen = &stopwatchTimeSyncCccLength,
+        .maxLen = sizeof(stopwatchTimeSyncCcc),
+        .settings = ATTS_SET_CCC,
+        .permissions = ATTS_PERMIT_READ | ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchTimeSyncName,
+        .pLen = &stopwatchTimeSyncNameLength,
+        .maxLen = sizeof(stopwatchTimeSyncName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+
+    /* Control characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchControlCharacteristicsValue,
+        .pLen = &stopwatchControlCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchControlCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchControlCharacteristicsGuid,
+        .pValue = stopwatchControl,
+        .pLen = &stopwatchControlLength,
+        .maxLen = sizeof(stopwatchControl),
+        .settings = ATTS_SET_VARIABLE_LEN | ATTS_SET_WRITE_CBACK,
+        .permissions = ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchControlName,
+        .pLen = &stopwatchControlNameLength,
+        .maxLen = sizeof(stopwatchControlName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+
+    /* Lap Events characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchLapEventsCharacteristicsValue,
+        .pLen = &stopwatchLapEventsCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchLapEventsCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchLapEventsCharacteristicsGuid,
+        .pValue = stopwatchLapEvents,
+        .pLen = &stopwatchLapEventsLength,
+        .maxLen = sizeof(stopwatchLapEvents),
+        .settings = ATTS_SET_VARIABLE_LEN | ATTS_SET_READ_CBACK | ATTS_SET_WRITE_CBACK,
+        .permissions = ATTS_PERMIT_READ | ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attCliChCfgUuid,
+        .pValue = stopwatchLapEventsCcc,
+        .pLen = &stopwatchLapEventsCccLength,
+        .maxLen = sizeof(stopwatchLapEventsCcc),
+        .settings = ATTS_SET_CCC,
+        .permissions = ATTS_PERMIT_READ | ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchLapEventsName,
+        .pLen = &stopwatchLapEventsNameLength,
+        .maxLen = sizeof(stopwatchLapEventsName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+
+    /* Session characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchSessionCharacteristicsValue,
+        .pLen = &stopwatchSessionCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchSessionCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchSessionCharacteristicsGuid,
+        .pValue = stopwatchSession,
+        .pLen = &stopwatchSessionLength,
+        .maxLen = sizeof(stopwatchSession),
+        .settings = ATTS_SET_VARIABLE_LEN | ATTS_SET_WRITE_CBACK,
+        .permissions = ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attCliChCfgUuid,
+        .pValue = stopwatchSessionCcc,
+        .pLen = &stopwatchSessionCccLength,
+        .maxLen = sizeof(stopwatchSessionCcc),
+        .settings = ATTS_SET_CCC,
+        .permissions = ATTS_PERMIT_READ | ATTS_PERMIT_WRITE,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchSessionName,
+        .pLen = &stopwatchSessionNameLength,
+        .maxLen = sizeof(stopwatchSessionName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+
+    /* Lap stats characteristics */
+    {
+        .pUuid = attChUuid,
+        .pValue = stopwatchLapStatsCharacteristicsValue,
+        .pLen = &stopwatchLapStatsCharacteristicsValueLength,
+        .maxLen = sizeof(stopwatchLapStatsCharacteristicsValue),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = stopwatchLapStatsCharacteristicsGuid,
+        .pValue = stopwatchLapStats,
+        .pLen = &stopwatchLapStatsLength,
+        .maxLen = sizeof(stopwatchLapStats),
+        .settings = ATTS_SET_READ_CBACK,
+        .permissions = ATTS_PERMIT_READ,
+    },
+    {
+        .pUuid = attChUserDescUuid,
+        .pValue = stopwatchLapStatsName,
+        .pLen = &stopwatchLapStatsNameLength,
+        .maxLen = sizeof(stopwatchLapStatsName),
+        .settings = 0,
+        .permissions = ATTS_PERMIT_READ,
+    },
 };
 
 static attsGroup_t stopwatchGroup = {
     .pNext = NULL,
     .pAttr = stopwatchAttributes,
-    .readCback = NULL,
+    .readCback = BLE_StopwatchReadCallback,
     .writeCback = BLE_StopwatchWriteCallback,
     .startHandle = STOPWATCH_HANDLE_OFFSET,
     .endHandle = STOPWATCH_LAST_HANDLE - 1,
@@ -413,9 +902,23 @@ enum {
     GATT_SC_CCC_IDX,
     STOPWATCH_STATUS_IDX,
     STOPWATCH_LAPS_COUNT_IDX,
+    STOPWATCH_TIME_SYNC_IDX,
+    STOPWATCH_LAP_EVENTS_IDX,
+    STOPWATCH_SESSION_IDX,
     NUM_CCC_IDX
 };
 
+typedef struct {
+    uint16_t handle;
+    uint8_t *pValue;
+    uint16_t len;
+} BLE_NotificationSource;
+
+static const BLE_NotificationSource notificationSources[NUM_CCC_IDX] = {
+    [STOPWATCH_STATUS_IDX] = {STOPWATCH_STATUS_VALUE_HANDLE, &stopwatchStatus, sizeof(stopwatchStatus)},
+    [STOPWATCH_LAPS_COUNT_IDX] = {STOPWATCH_LAPS_COUNT_VALUE_HANDLE, &stopwatchLapsCount, sizeof(stopwatchLapsCount)},
+};
+
 static const attsCccSet_t cccSet[NUM_CCC_IDX] = {
     {
         .handle = GATT_SC_CH_CCC_HDL,
@@ -432,11 +935,78 @@ static const attsCccSet_t cccSet[NUM_CCC_IDX] = {
         .valueRange = ATT_CLIENT_CFG_NOTIFY,
         .secLevel = DM_SEC_LEVEL_NONE,
     },
+    {
+        .handle = STOPWATCH_TIME_SYNC_CCC_HANDLE,
+        .valueRange = ATT_CLIENT_CFG_NOTIFY,
+        .secLevel = DM_SEC_LEVEL_NONE,
+    },
+    {
+        .handle = STOPWATCH_LAP_EVENTS_CCC_HANDLE,
+        .valueRange = ATT_CLIENT_CFG_NOTIFY,
+        .secLevel = DM_SEC_LEVEL_NONE,
+    },
+    {
+        .handle = STOPWATCH_SESSION_CCC_HANDLE,
+        .valueRange = ATT_CLIENT_CFG_NOTIFY,
+        .secLevel = DM_SEC_LEVEL_NONE,
+    },
 };
 
 static LlRtCfg_t mainLlRtCfg;
 static volatile int wutTrimComplete;
 
+// radio events are estimated from time spent advertising or connected and the interval in use
+static uint32_t radioEventCount = 0;
+static uint32_t advRadioIntervalTicks = 0;
+static uint32_t advRadioAccountTime;
+static uint32_t connRadioIntervalTicks[DM_CONN_MAX + 1];
+static uint32_t connRadioAccountTime[DM_CONN_MAX + 1];
+
+static uint8_t isTimeSyncIntervalRequested[DM_CONN_MAX + 1];
+
+static int connectionsCount = 0;
+static uint8_t txCredits[DM_CONN_MAX + 1];
+
+// bitmask of CCC indexes, latest value is sent when credit returns so bursts are coalesced
+static uint32_t pendingNotifications[DM_CONN_MAX + 1];
+
+typedef struct {
+    uint8_t event;
+    uint8_t lapIndex;
+    uint32_t tick;
+    uint32_t delta;
+} BLE_LapEvent;
+
+// sequence number of event is its position in stream since boot, each connection has own replay cursor
+#define BLE_LAP_EVENTS_MASK (BLE_LAP_EVENTS_MAX - 1)
+static BLE_LapEvent lapEvents[BLE_LAP_EVENTS_MAX];
+static uint32_t lapEventsHead = 0;
+static uint32_t lapEventsCursor[DM_CONN_MAX + 1];
+
+// random per boot, client seeing different ID knows sequence numbers started over
+static uint32_t lapEventsStreamId = 0;
+
+// reconnection latency, ticks since connection open until encryption, enabled notifications and first one sent
+static uint32_t connOpenTime[DM_CONN_MAX + 1];
+static uint8_t isNotifyReadyTraced[DM_CONN_MAX + 1];
+static uint8_t isFirstNotificationTraced[DM_CONN_MAX + 1];
+
+// key of finished pairing is replaced only once no link is open, so generation never delays a connection
+static int isEccKeyStale = 0;
+
+// session export of each connection, chunks are encoded only when credit is available to send them
+static Session_Encoder sessionEncoders[DM_CONN_MAX + 1];
+static uint8_t isSessionExporting[DM_CONN_MAX + 1];
+static bdAddr_t deviceAddress;
+
+static appDbHdl_t resolvingListRestoreHdl = APP_DB_HDL_NONE;
+
+static wsfTimer_t broadcastTimer;
+static uint8_t broadcastSequence = 0;
+static int isBroadcastEnabled = 0;
+static int isAdvertising = 0;
+static int isAdvertisingRestartPending = 0;
+
 wsfHandlerId_t bleHandlerId;
 
 static void BLE_InitWsf(void) {
@@ -458,6 +1028,8 @@ static void BLE_InitWsf(void) {
 
     WsfOsInit();
     WsfTimerInit();
+    // bonds and CCC values of bonded clients survive reset, reconnection skips pairing
+    WsfNvmInit();
 #if (WSF_TOKEN_ENABLED == TRUE) || (WSF_TRACE_ENABLED == TRUE)
     WsfTraceRegisterHandler(WsfBufIoWrite);
     WsfTraceEnable(TRUE);
@@ -506,7 +1078,7 @@ void BLE_InitStack() {
     handlerId = WsfOsSetNextHandler(AppHandler);
     AppHandlerInit(handlerId);
 
-    handlerId = WsfOsSetNextHandler(BLE_Handler);
+    handlerId = Profile_SetNextHandler(BLE_Handler, "BLE");
     BLE_HandlerInit(handlerId);
 }
 
@@ -529,6 +1101,7 @@ void BLE_Init() {
     mainBbRtCfg.clkPpm = 20;
 
     mainLlRtCfg.defTxPwrLvl = 0;
+    mainLlRtCfg.maxConn = BLE_CONN_MAX;
 
     uint32_t memUsed;
     memUsed = WsfBufIoUartInit(WsfHeapGetFreeStartAddress(), 2048);
@@ -548,9 +1121,8 @@ void BLE_Init() {
     memUsed = LlInit(&llCfg);
     WsfHeapAlloc(memUsed);
 
-    bdAddr_t bdAddr;
-    PalCfgLoadData(PAL_CFG_ID_BD_ADDR, bdAddr, sizeof(bdAddr_t));
-    LlSetBdAddr((uint8_t *)&bdAddr);
+    PalCfgLoadData(PAL_CFG_ID_BD_ADDR, deviceAddress, sizeof(bdAddr_t));
+    LlSetBdAddr((uint8_t *)&deviceAddress);
 
     PalBbEnable();
 
@@ -573,6 +1145,12 @@ static void BLE_HandlerInit(wsfHandlerId_t handlerId) {
     bleHandlerId = handlerId;
 
     pAppAdvCfg = (appAdvCfg_t *)&advertisignConfig;
+
+    broadcastTimer.handlerId = handlerId;
+    broadcastTimer.msg.event = BLE_BROADCAST_TIMER_EVENT;
+    broadcastTimer.msg.param = 0;
+    broadcastTimer.msg.status = 0;
+
     pAppSlaveCfg = (appSlaveCfg_t *)&slaveConfig;
     pAppSecCfg = (appSecCfg_t *)&securityConfig;
     pAppUpdateCfg = (appUpdateCfg_t *)&updateConfig;
@@ -594,6 +1172,10 @@ static void BLE_Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
             AppSlaveSecProcDmMsg((dmEvt_t *)pMsg);
         }
 
+        if (pMsg->event == BLE_BROADCAST_TIMER_EVENT) {
+            BLE_UpdateBroadcast();
+        }
+
         BLE_ProcessMessage(pMsg);
     }
 }
@@ -660,6 +1242,7 @@ static void BLE_CccCallback(attsCccEvt_t *pEvt) {
         ((dbHdl = AppDbGetHdl((dmConnId_t)pEvt->hdr.param)) != APP_DB_HDL_NONE) &&
         AppCheckBonded((dmConnId_t)pEvt->hdr.param)) {
         AppDbSetCccTblValue(dbHdl, pEvt->idx, pEvt->value);
+        AppDbNvmStoreCccTbl(dbHdl);
     }
 
     if ((pMsg = WsfMsgAlloc(sizeof(attsCccEvt_t))) != NULL) {
@@ -668,6 +1251,201 @@ static void BLE_CccCallback(attsCccEvt_t *pEvt) {
     }
 }
 
+static void BLE_AccountRadioEvents(uint32_t intervalTicks, uint32_t *accountTime, uint32_t now) {
+    if (intervalTicks == 0) {
+        return;
+    }
+
+    uint32_t events = (now - *accountTime) / intervalTicks;
+    radioEventCount += events;
+    *accountTime += events * intervalTicks;
+}
+
+// radio keeps its schedule in deep sleep where TIME_TIMER stops, so events are counted on WUT,
+// it runs at the same 32 kHz rate, interval in TIME_TIMER ticks applies to it
+static void BLE_AccountAllRadioEvents() {
+    uint32_t now = Power_GetTime();
+
+    BLE_AccountRadioEvents(advRadioIntervalTicks, &advRadioAccountTime, now);
+    for (int i = 1; i <= DM_CONN_MAX; i++) {
+        BLE_AccountRadioEvents(connRadioIntervalTicks[i], &connRadioAccountTime[i], now);
+    }
+}
+
+// interval is in 0.625 ms units for advertising and 1.25 ms units for connections
+static uint32_t BLE_IntervalToTicks(uint32_t interval, uint32_t unitUs) {
+    return (uint32_t)((uint64_t)interval * unitUs * TIME_TICK_PER_SEC / 1000000);
+}
+
+static void BLE_SetAdvRadioInterval(uint32_t intervalTicks) {
+    BLE_AccountAllRadioEvents();
+    advRadioIntervalTicks = intervalTicks;
+    advRadioAccountTime = Power_GetTime();
+}
+
+static void BLE_SetConnRadioInterval(dmConnId_t connId, uint32_t intervalTicks) {
+    if (connId < 1 || connId > DM_CONN_MAX) {
+        return;
+    }
+
+    BLE_AccountAllRadioEvents();
+    connRadioIntervalTicks[connId] = intervalTicks;
+    connRadioAccountTime[connId] = Power_GetTime();
+}
+
+uint32_t BLE_GetRadioEventCount() {
+    BLE_AccountAllRadioEvents();
+    return radioEventCount;
+}
+
+static void BLE_SendNotification(dmConnId_t connId, int cccIdx) {
+    if (!AttsCccEnabled(connId, cccIdx)) {
+        return;
+    }
+
+    if (txCredits[connId] == 0) {
+        pendingNotifications[connId] |= 1 << cccIdx;
+        return;
+    }
+
+    const BLE_NotificationSource *source = &notificationSources[cccIdx];
+
+    txCredits[connId]--;
+    AttsHandleValueNtf(connId, source->handle, source->len, source->pValue);
+}
+
+static void BLE_Notify(int cccIdx) {
+    dmConnId_t connIds[DM_CONN_MAX];
+    uint8_t count = AppConnOpenList(connIds);
+
+    for (int i = 0; i < count; i++) {
+        BLE_SendNotification(connIds[i], cccIdx);
+    }
+}
+
+static uint32_t BLE_GetOldestLapEvent() {
+    return lapEventsHead > BLE_LAP_EVENTS_MAX ? lapEventsHead - BLE_LAP_EVENTS_MAX : 0;
+}
+
+// events are sent while credits last, rest continues when credit returns, so nothing is dropped
+static void BLE_SendLapEvents(dmConnId_t connId) {
+    uint8_t record[BLE_LAP_EVENT_LEN];
+
+    if (!AttsCccEnabled(connId, STOPWATCH_LAP_EVENTS_IDX)) {
+        return;
+    }
+
+    uint32_t oldest = BLE_GetOldestLapEvent();
+    if (lapEventsCursor[connId] < oldest) {
+        lapEventsCursor[connId] = oldest;
+    }
+
+    while (txCredits[connId] > 0 && lapEventsCursor[connId] != lapEventsHead) {
+        uint32_t sequence = lapEventsCursor[connId];
+        BLE_LapEvent *e = &lapEvents[sequence & BLE_LAP_EVENTS_MASK];
+
+        uint8_t *p = record;
+        UINT32_TO_BSTREAM(p, sequence);
+        UINT8_TO_BSTREAM(p, e->event);
+        UINT8_TO_BSTREAM(p, e->lapIndex);
+        UINT32_TO_BSTREAM(p, e->tick);
+        UINT32_TO_BSTREAM(p, e->delta);
+
+        txCredits[connId]--;
+        AttsHandleValueNtf(connId, STOPWATCH_LAP_EVENTS_VALUE_HANDLE, BLE_LAP_EVENT_LEN, record);
+        lapEventsCursor[connId]++;
+    }
+}
+
+// replay is allowed only from sequence still held, otherwise client must reload laps
+static uint8_t BLE_LapEventsWrite(dmConnId_t connId, uint16_t len, uint8_t *pValue) {
+    uint32_t sequence;
+
+    if (len != BLE_LAP_EVENTS_RESYNC_LEN) {
+        return ATT_ERR_LENGTH;
+    }
+
+    BYTES_TO_UINT32(sequence, pValue);
+    if (sequence < BLE_GetOldestLapEvent() || sequence > lapEventsHead) {
+        return ATT_ERR_RANGE;
+    }
+
+    lapEventsCursor[connId] = sequence;
+    BLE_SendLapEvents(connId);
+    return ATT_SUCCESS;
+}
+
+static void BLE_SendSession(dmConnId_t connId) {
+    uint8_t chunk[BLE_SESSION_CHUNK_MAX];
+
+    if (!AttsCccEnabled(connId, STOPWATCH_SESSION_IDX)) {
+        return;
+    }
+
+    int chunkLen = AttGetMtu(connId) - ATT_VALUE_NTF_LEN;
+    if (chunkLen > BLE_SESSION_CHUNK_MAX) {
+        chunkLen = BLE_SESSION_CHUNK_MAX;
+    }
+
+    while (txCredits[connId] > 0 && isSessionExporting[connId]) {
+        Session_Encoder *encoder = &sessionEncoders[connId];
+        uint16_t offset = encoder->offset;
+
+        int len = Session_Read(encoder, chunk + BLE_SESSION_OFFSET_LEN, chunkLen - BLE_SESSION_OFFSET_LEN);
+        if (len == 0) {
+            isSessionExporting[connId] = 0;
+            break;
+        }
+        if (len < 0) {
+            // client starts over with new snapshot
+            isSessionExporting[connId] = 0;
+            offset = BLE_SESSION_ABORTED;
+            len = 0;
+        }
+
+        uint8_t *p = chunk;
+        UINT16_TO_BSTREAM(p, offset);
+
+        txCredits[connId]--;
+        AttsHandleValueNtf(connId, STOPWATCH_SESSION_VALUE_HANDLE, BLE_SESSION_OFFSET_LEN + len, chunk);
+    }
+}
+
+// session is at most ~1.3 kB, so interrupted export is simply started again
+static uint8_t BLE_SessionWrite(dmConnId_t connId, uint16_t len) {
+    if (len != BLE_SESSION_START_LEN) {
+        return ATT_ERR_LENGTH;
+    }
+
+    Session_Begin(&sessionEncoders[connId], deviceAddress);
+    isSessionExporting[connId] = 1;
+    BLE_SendSession(connId);
+    return ATT_SUCCESS;
+}
+
+static void BLE_ReturnTxCredit(dmConnId_t connId) {
+    if (connId < 1 || connId > DM_CONN_MAX) {
+        return;
+    }
+
+    // confirmations of indications sent by stack (service changed) also end here
+    if (txCredits[connId] < BLE_TX_CREDITS) {
+        txCredits[connId]++;
+    }
+
+    uint32_t pending = pendingNotifications[connId];
+    pendingNotifications[connId] = 0;
+
+    for (int i = 0; i < NUM_CCC_IDX; i++) {
+        if (pending & (1 << i)) {
+            BLE_SendNotification(connId, i);
+        }
+    }
+
+    BLE_SendLapEvents(connId);
+    BLE_SendSession(connId);
+}
+
 static void BLE_SetupAdvertising() {
     AppAdvSetData(APP_ADV_DATA_DISCOVERABLE, sizeof(avertisignData), (uint8_t *)avertisignData);
     AppAdvSetData(APP_SCAN_DATA_DISCOVERABLE, sizeof(scanData), (uint8_t *)scanData);
@@ -678,42 +1456,240 @@ static void BLE_SetupAdvertising() {
     AppAdvStart(APP_MODE_AUTO_INIT);
 }
 
+static void BLE_TraceLink(dmConnId_t connId, uint8_t linkEvent) {
+    Trace_Event(TRACE_EVENT_BLE_LINK, (connId << 8) | linkEvent, TIME_TIMER->cnt - connOpenTime[connId]);
+}
+
+// bonded client has CCC restored from flash on connection, new client enables it by write
+static void BLE_TraceNotifyReady(dmConnId_t connId) {
+    if (connId < 1 || connId > DM_CONN_MAX || isNotifyReadyTraced[connId]) {
+        return;
+    }
+
+    if (AttsCccEnabled(connId, STOPWATCH_STATUS_IDX) || AttsCccEnabled(connId, STOPWATCH_LAPS_COUNT_IDX)) {
+        isNotifyReadyTraced[connId] = 1;
+        BLE_TraceLink(connId, TRACE_BLE_LINK_NOTIFY_READY);
+    }
+}
+
+static void BLE_TraceFirstNotification(dmConnId_t connId) {
+    if (connId < 1 || connId > DM_CONN_MAX || isFirstNotificationTraced[connId]) {
+        return;
+    }
+
+    isFirstNotificationTraced[connId] = 1;
+    BLE_TraceLink(connId, TRACE_BLE_LINK_FIRST_NOTIFICATION);
+}
+
+// pairing that starts before stale key is replaced uses it once more, like Cordio samples do with key from reset
+static void BLE_GenerateEccKeyWhenIdle() {
+    isEccKeyStale = 1;
+    if (connectionsCount == 0) {
+        isEccKeyStale = 0;
+        DmSecGenerateEccKeyReq();
+    }
+}
+
+// controller resolves bonded hosts' private addresses, devices are added one by one as each add completes
+static void BLE_RestoreResolvingList() {
+    resolvingListRestoreHdl = AppAddNextDevToResList(APP_DB_HDL_NONE);
+    if (resolvingListRestoreHdl == APP_DB_HDL_NONE) {
+        BLE_SetupAdvertising();
+    }
+}
+
+// failed add only leaves that host unresolved, restore goes on so device always ends up advertising
+static void BLE_ResolvingListDeviceAdded(wsfMsgHdr_t *pMsg) {
+    if (resolvingListRestoreHdl == APP_DB_HDL_NONE) {
+        return;
+    }
+
+    if (pMsg->status != HCI_SUCCESS) {
+        APP_TRACE_WARN1("Add to resolving list status 0x%02x", pMsg->status);
+    }
+
+    resolvingListRestoreHdl = AppAddNextDevToResList(resolvingListRestoreHdl);
+    if (resolvingListRestoreHdl == APP_DB_HDL_NONE) {
+        DmPrivSetAddrResEnable(TRUE);
+        BLE_SetupAdvertising();
+    }
+}
+
+// stored hash differs after firmware update changed the database, all bonded clients must rediscover
+static void BLE_DatabaseHashCalculated(attEvt_t *pEvt) {
+    if (pEvt->valueLen != ATT_DATABASE_HASH_LEN || memcmp(AppDbGetDbHash(), pEvt->pValue, ATT_DATABASE_HASH_LEN) == 0) {
+        return;
+    }
+
+    APP_TRACE_INFO0("GATT database changed, bonded clients are change unaware");
+    AppDbSetDbHash(pEvt->pValue);
+    AppDbSetClientsChangeAwareState(APP_DB_HDL_NONE, ATTS_CLIENT_CHANGE_UNAWARE);
+
+    // state is only set in RAM, every bond record is stored so clients stay change unaware after reset
+    for (appDbHdl_t dbHdl = AppDbGetNextRecord(APP_DB_HDL_NONE); dbHdl != APP_DB_HDL_NONE; dbHdl = AppDbGetNextRecord(dbHdl)) {
+        AppDbNvmStoreCsfRecord(dbHdl);
+    }
+}
+
+// change unaware state is kept in bond record, so indication is sent even after later resets
+static void BLE_SendServiceChanged(dmConnId_t connId) {
+    appDbHdl_t dbHdl = AppDbGetHdl(connId);
+    uint8_t changeAwareState;
+    uint8_t *pCsf;
+
+    if (dbHdl == APP_DB_HDL_NONE || !AttsCccEnabled(connId, GATT_SC_CCC_IDX)) {
+        return;
+    }
+
+    AppDbGetCsfRecord(dbHdl, &changeAwareState, &pCsf);
+    if (changeAwareState == ATTS_CLIENT_CHANGE_UNAWARE) {
+        GattSendServiceChangedInd(connId, ATT_HANDLE_START, ATT_HANDLE_MAX);
+    }
+}
+
+static void BLE_ServiceChangedConfirmed(dmConnId_t connId) {
+    appDbHdl_t dbHdl = AppDbGetHdl(connId);
+    uint8_t changeAwareState;
+    uint8_t *pCsf;
+
+    if (dbHdl == APP_DB_HDL_NONE) {
+        return;
+    }
+
+    AppDbGetCsfRecord(dbHdl, &changeAwareState, &pCsf);
+    AppDbSetCsfRecord(dbHdl, ATTS_CLIENT_CHANGE_AWARE, pCsf);
+    AppDbNvmStoreCsfRecord(dbHdl);
+}
+
 static void BLE_ProcessMessage(wsfMsgHdr_t *pMsg) {
     switch (pMsg->event) {
         case ATTS_CCC_STATE_IND: {
             attsCccEvt_t *cccEvent = (attsCccEvt_t *)pMsg;
             APP_TRACE_INFO3("CCC (id=%d, handle=%d) changed state to 0x%02x", cccEvent->idx, cccEvent->handle, cccEvent->value);
+            BLE_TraceNotifyReady((dmConnId_t)pMsg->param);
+
+            // newly subscribed client gets only new events, older are requested by resync write
+            if (cccEvent->idx == STOPWATCH_LAP_EVENTS_IDX) {
+                lapEventsCursor[(dmConnId_t)pMsg->param] = lapEventsHead;
+            }
             break;
         }
 
+        case ATTS_HANDLE_VALUE_CNF:
+            if (((attEvt_t *)pMsg)->handle == GATT_SC_CH_HDL && pMsg->status == ATT_SUCCESS) {
+                BLE_ServiceChangedConfirmed((dmConnId_t)pMsg->param);
+            } else if (pMsg->status == ATT_SUCCESS) {
+                BLE_TraceFirstNotification((dmConnId_t)pMsg->param);
+            }
+            BLE_ReturnTxCredit((dmConnId_t)pMsg->param);
+            break;
+
+        case ATTS_DB_HASH_CALC_CMPL_IND:
+            BLE_DatabaseHashCalculated((attEvt_t *)pMsg);
+            break;
+
         case DM_RESET_CMPL_IND:
+            // stored hash must be loaded before new one is compared with it
+            AppDbNvmReadAll();
             AttsCalculateDbHash();
-            DmSecGenerateEccKeyReq();
-            BLE_SetupAdvertising();
+            BLE_GenerateEccKeyWhenIdle();
+            if (lapEventsStreamId == 0) {
+                SecRand((uint8_t *)&lapEventsStreamId, sizeof(lapEventsStreamId));
+            }
+            BLE_RestoreResolvingList();
+            break;
+
+        case DM_PRIV_ADD_DEV_TO_RES_LIST_IND:
+            BLE_ResolvingListDeviceAdded(pMsg);
             break;
 
         case DM_ADV_START_IND:
+            isAdvertising = 1;
+            BLE_SetAdvRadioInterval(BLE_IntervalToTicks(pAppAdvCfg->advInterval[0], 625));
+            BLE_UpdateBroadcast();
             GUI_SetBleAdvertisignStatus(1);
             break;
 
         case DM_ADV_STOP_IND:
+            isAdvertising = 0;
+            BLE_SetAdvRadioInterval(0);
+            if (isAdvertisingRestartPending) {
+                isAdvertisingRestartPending = 0;
+                AppAdvStart(APP_MODE_AUTO_INIT);
+            }
             GUI_SetBleAdvertisignStatus(0);
             break;
 
-        case DM_CONN_OPEN_IND:
-            GUI_SetBleConnectionStatus(1);
+        case DM_CONN_OPEN_IND: {
+            dmEvt_t *dme = (dmEvt_t *)pMsg;
+            dmConnId_t connId = (dmConnId_t)pMsg->param;
+
+            txCredits[connId] = BLE_TX_CREDITS;
+            pendingNotifications[connId] = 0;
+            connectionsCount++;
+
+            connOpenTime[connId] = TIME_TIMER->cnt;
+            isNotifyReadyTraced[connId] = 0;
+            isFirstNotificationTraced[connId] = 0;
+            lapEventsCursor[connId] = lapEventsHead;
+            isSessionExporting[connId] = 0;
+            isTimeSyncIntervalRequested[connId] = 0;
+
+            BLE_SetConnRadioInterval(connId, BLE_IntervalToTicks(dme->connOpen.connInterval, 1250));
+            Trace_Event(TRACE_EVENT_BLE_CONNECTION, connId, 1);
+
+            // connectable advertising ends by connection without stop indication, keep it going for other centrals
+            isAdvertising = 0;
+            BLE_SetAdvRadioInterval(0);
+            if (connectionsCount < BLE_CONN_MAX) {
+                AppAdvStart(APP_MODE_AUTO_INIT);
+            }
+
+            GUI_SetBleConnectionStatus(connectionsCount);
             break;
+        }
 
-        case DM_CONN_CLOSE_IND:
-            GUI_SetBleConnectionStatus(0);
+        case DM_CONN_UPDATE_IND: {
+            dmEvt_t *dme = (dmEvt_t *)pMsg;
+            if (dme->connUpdate.status == 0) {
+                BLE_SetConnRadioInterval((dmConnId_t)pMsg->param, BLE_IntervalToTicks(dme->connUpdate.connInterval, 1250));
+            }
             break;
+        }
+
+        case DM_CONN_CLOSE_IND: {
+            dmConnId_t connId = (dmConnId_t)pMsg->param;
+
+            txCredits[connId] = 0;
+            pendingNotifications[connId] = 0;
+            if (connectionsCount > 0) {
+                connectionsCount--;
+            }
+
+            BLE_SetConnRadioInterval(connId, 0);
+            Trace_Event(TRACE_EVENT_BLE_CONNECTION, connId, 0);
+            GUI_SetBleConnectionStatus(connectionsCount);
+
+            if (isEccKeyStale) {
+                BLE_GenerateEccKeyWhenIdle();
+            }
+            break;
+        }
 
         case DM_SEC_PAIR_CMPL_IND:
-            DmSecGenerateEccKeyReq();
+            AppDbNvmStoreBond(AppDbGetHdl((dmConnId_t)pMsg->param));
+            BLE_TraceLink((dmConnId_t)pMsg->param, TRACE_BLE_LINK_PAIRED);
+            BLE_GenerateEccKeyWhenIdle();
             break;
 
         case DM_SEC_PAIR_FAIL_IND:
-            DmSecGenerateEccKeyReq();
+            BLE_GenerateEccKeyWhenIdle();
+            break;
+
+        case DM_SEC_ENCRYPT_IND:
+            BLE_TraceLink((dmConnId_t)pMsg->param, TRACE_BLE_LINK_ENCRYPTED);
+            BLE_TraceNotifyReady((dmConnId_t)pMsg->param);
+            BLE_SendServiceChanged((dmConnId_t)pMsg->param);
             break;
 
         case DM_SEC_AUTH_REQ_IND: {
@@ -740,6 +1716,145 @@ static void BLE_ProcessMessage(wsfMsgHdr_t *pMsg) {
     }
 }
 
+static void BLE_RequestConnInterval(dmConnId_t connId, uint16_t intervalMin, uint16_t intervalMax) {
+    hciConnSpec_t connSpec = {
+        .connIntervalMin = intervalMin,
+        .connIntervalMax = intervalMax,
+        .connLatency = 0,
+        .supTimeout = updateConfig.supTimeout,
+        .minCeLen = 0,
+        .maxCeLen = 0xFFFF,
+    };
+
+    DmConnUpdate(connId, &connSpec);
+}
+
+static uint8_t BLE_TimeSyncWrite(dmConnId_t connId, uint16_t len, uint8_t *pValue) {
+    // receive tick is captured before anything else to keep host round trip estimate tight
+    uint32_t receiveTick = TIME_TIMER->cnt;
+
+    if (len < 1) {
+        return ATT_ERR_LENGTH;
+    }
+
+    if (pValue[0] == BLE_TIME_SYNC_OP_PING) {
+        if (len != BLE_TIME_SYNC_PING_LEN) {
+            return ATT_ERR_LENGTH;
+        }
+
+        // lost pong is not retransmitted, host times out and sends new ping with fresh t1
+        if (!AttsCccEnabled(connId, STOPWATCH_TIME_SYNC_IDX) || txCredits[connId] == 0) {
+            return ATT_SUCCESS;
+        }
+
+        uint8_t pong[BLE_TIME_SYNC_PONG_LEN];
+        uint8_t *p = pong;
+        memcpy(p, pValue, BLE_TIME_SYNC_PING_LEN);
+        p += BLE_TIME_SYNC_PING_LEN;
+        UINT32_TO_BSTREAM(p, receiveTick);
+        uint8_t *replyTickField = p;
+        p += 4;
+        UINT32_TO_BSTREAM(p, connRadioIntervalTicks[connId]);
+
+        txCredits[connId]--;
+
+        // reply tick is captured last, just before notification is handed to stack
+        uint32_t replyTick = TIME_TIMER->cnt;
+        UINT32_TO_BSTREAM(replyTickField, replyTick);
+        AttsHandleValueNtf(connId, STOPWATCH_TIME_SYNC_VALUE_HANDLE, sizeof(pong), pong);
+
+        if (!isTimeSyncIntervalRequested[connId] && connRadioIntervalTicks[connId] > BLE_IntervalToTicks(BLE_TIME_SYNC_CONN_INTERVAL_MAX, 1250)) {
+            isTimeSyncIntervalRequested[connId] = 1;
+            BLE_RequestConnInterval(connId, BLE_TIME_SYNC_CONN_INTERVAL_MIN, BLE_TIME_SYNC_CONN_INTERVAL_MAX);
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (pValue[0] == BLE_TIME_SYNC_OP_SET_MAPPING) {
+        if (len != BLE_TIME_SYNC_SET_MAPPING_LEN) {
+            return ATT_ERR_LENGTH;
+        }
+
+        uint8_t *p = pValue + 1;
+        uint64_t hostTime;
+        uint32_t deviceTick;
+        int32_t drift;
+        BSTREAM_TO_UINT64(hostTime, p);
+        BSTREAM_TO_UINT32(deviceTick, p);
+        BSTREAM_TO_UINT32(drift, p);
+
+        TimeSync_SetMapping(hostTime, deviceTick, drift);
+
+        if (isTimeSyncIntervalRequested[connId]) {
+            isTimeSyncIntervalRequested[connId] = 0;
+            BLE_RequestConnInterval(connId, updateConfig.connIntervalMin, updateConfig.connIntervalMax);
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (pValue[0] == BLE_TIME_SYNC_OP_START_AT) {
+        if (len != BLE_TIME_SYNC_START_AT_LEN) {
+            return ATT_ERR_LENGTH;
+        }
+
+        if (!TimeSync_IsSynchronized()) {
+            return BLE_ATT_ERR_NOT_SYNCHRONIZED;
+        }
+
+        uint8_t *p = pValue + 1;
+        uint64_t hostTime;
+        BSTREAM_TO_UINT64(hostTime, p);
+
+        // every device of fleet latches its own tick of the same host time
+        if (GUI_ScheduleStart(TimeSync_HostToDeviceTick(hostTime))) {
+            return ATT_ERR_RANGE;
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (pValue[0] == BLE_TIME_SYNC_OP_CANCEL_START) {
+        GUI_CancelScheduledStart();
+        return ATT_SUCCESS;
+    }
+
+    return ATT_ERR_RANGE;
+}
+
+static uint8_t BLE_ControlWrite(uint16_t len, uint8_t *pValue) {
+    uint32_t receiveTick = TIME_TIMER->cnt;
+    uint32_t commandTick = receiveTick;
+
+    if (len == BLE_CONTROL_TIMESTAMPED_COMMAND_LEN) {
+        if (!TimeSync_IsSynchronized()) {
+            return BLE_ATT_ERR_NOT_SYNCHRONIZED;
+        }
+
+        uint8_t *p = pValue + 1;
+        uint64_t hostTime;
+        BSTREAM_TO_UINT64(hostTime, p);
+
+        // applied retroactively at the moment operator clicked, not when connection event delivered it
+        commandTick = TimeSync_HostToDeviceTick(hostTime);
+
+        int32_t age = (int32_t)(receiveTick - commandTick);
+        if (age > BLE_CONTROL_MAX_AGE_TICKS) {
+            return ATT_ERR_RANGE;
+        }
+    } else if (len != BLE_CONTROL_COMMAND_LEN) {
+        return ATT_ERR_LENGTH;
+    }
+
+    if (pValue[0] >= GUI_COMMAND_COUNT) {
+        return ATT_ERR_RANGE;
+    }
+
+    if (GUI_ExecuteCommand(pValue[0], commandTick)) {
+        return BLE_ATT_ERR_BAD_STATE;
+    }
+
+    return ATT_SUCCESS;
+}
+
 static uint8_t BLE_StopwatchWriteCallback(dmConnId_t connId, uint16_t handle, uint8_t operation, uint16_t offset, uint16_t len, uint8_t *pValue, attsAttr_t *pAttr) {
     uint8_t status;
 
@@ -765,51 +1880,219 @@ static uint8_t BLE_StopwatchWriteCallback(dmConnId_t connId, uint16_t handle, ui
         return ATT_SUCCESS;
     }
 
+    if (handle == STOPWATCH_DIAGNOSTICS_VALUE_HANDLE) {
+        // any write resets collected statistics
+        Profile_ResetStats();
+        return ATT_SUCCESS;
+    }
+
+    if (handle == STOPWATCH_TIME_SYNC_VALUE_HANDLE) {
+        return BLE_TimeSyncWrite(connId, len, pValue);
+    }
+
+    if (handle == STOPWATCH_CONTROL_VALUE_HANDLE) {
+        return BLE_ControlWrite(len, pValue);
+    }
+
+    if (handle == STOPWATCH_LAP_EVENTS_VALUE_HANDLE) {
+        return BLE_LapEventsWrite(connId, len, pValue);
+    }
+
+    if (handle == STOPWATCH_SESSION_VALUE_HANDLE) {
+        return BLE_SessionWrite(connId, len);
+    }
+
+    return ATT_ERR_NOT_FOUND;
+}
+
+static uint8_t BLE_StopwatchReadCallback(dmConnId_t connId, uint16_t handle, uint8_t operation, uint16_t offset, attsAttr_t *pAttr) {
+    if (handle == STOPWATCH_ELAPSED_VALUE_HANDLE) {
+        // computed at read time, so value is exact and nothing is done while nobody reads
+        if (offset == 0) {
+            stopwatchElapsed = GUI_GetElapsedTime();
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (handle == STOPWATCH_DIAGNOSTICS_VALUE_HANDLE) {
+        // long read continues with snapshot taken at offset 0
+        if (offset == 0) {
+            *pAttr->pLen = Profile_GetReport(pAttr->pValue, pAttr->maxLen);
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (handle == STOPWATCH_LAP_STATS_VALUE_HANDLE) {
+        // statistics are maintained as laps are added, so summary costs one read regardless of laps count
+        if (offset == 0) {
+            LapStats_GetReport(pAttr->pValue, pAttr->maxLen);
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (handle == STOPWATCH_TRACE_VALUE_HANDLE) {
+        // records are dropped from trace buffer only when last part of long read is sent,
+        // aborted or repeated read starts again at offset 0 and gets the same records
+        if (offset == 0) {
+            *pAttr->pLen = Trace_Peek(pAttr->pValue, pAttr->maxLen);
+        }
+        if (offset + AttGetMtu(connId) - 1 >= *pAttr->pLen) {
+            Trace_ConsumePeeked();
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (handle == STOPWATCH_TIME_SYNC_VALUE_HANDLE) {
+        if (offset == 0) {
+            uint8_t flags = 0;
+            if (stopwatchStatus) {
+                flags |= BLE_TIME_SYNC_FLAG_RUNNING;
+            }
+            if (TimeSync_IsSynchronized()) {
+                flags |= BLE_TIME_SYNC_FLAG_SYNCHRONIZED;
+            }
+            if (GUI_IsStartScheduled()) {
+                flags |= BLE_TIME_SYNC_FLAG_START_SCHEDULED;
+            }
+
+            uint32_t startTick = GUI_GetStartTick();
+            uint8_t *p = pAttr->pValue;
+            UINT32_TO_BSTREAM(p, startTick);
+            UINT8_TO_BSTREAM(p, flags);
+            *pAttr->pLen = BLE_TIME_SYNC_STATUS_LEN;
+        }
+        return ATT_SUCCESS;
+    }
+
+    if (handle == STOPWATCH_LAP_EVENTS_VALUE_HANDLE) {
+        if (offset == 0) {
+            uint32_t oldest = BLE_GetOldestLapEvent();
+            uint8_t *p = pAttr->pValue;
+            UINT32_TO_BSTREAM(p, lapEventsHead);
+            UINT32_TO_BSTREAM(p, oldest);
+            UINT32_TO_BSTREAM(p, lapEventsStreamId);
+            *pAttr->pLen = BLE_LAP_EVENTS_STATUS_LEN;
+        }
+        return ATT_SUCCESS;
+    }
+
     return ATT_ERR_NOT_FOUND;
 }
 
+void BLE_AddLapEvent(uint8_t event, uint8_t lapIndex, uint32_t tick, uint32_t delta) {
+    BLE_LapEvent *e = &lapEvents[lapEventsHead & BLE_LAP_EVENTS_MASK];
+    e->event = event;
+    e->lapIndex = lapIndex;
+    e->tick = tick;
+    e->delta = delta;
+    lapEventsHead++;
+
+    for (dmConnId_t connId = 1; connId <= DM_CONN_MAX; connId++) {
+        BLE_SendLapEvents(connId);
+    }
+}
+
 void BLE_LapCountChanged(uint8_t newLapsCount) {
     uint8_t status;
 
-    status = AttsSetAttr(STOPWATCH_STATUS_VALUE_HANDLE, sizeof(newLapsCount), (uint8_t *)&newLapsCount);
+    int isChanged = stopwatchLapsCount != newLapsCount;
+
+    status = AttsSetAttr(STOPWATCH_LAPS_COUNT_VALUE_HANDLE, sizeof(newLapsCount), (uint8_t *)&newLapsCount);
     if (status) {
         APP_TRACE_ERR1("Error while laps count value. Status 0x%02x", status);
         return;
     }
 
-    dmConnId_t connId = AppConnIsOpen();
-    if (stopwatchLapsCount != newLapsCount && connId != DM_CONN_ID_NONE && AttsCccEnabled(connId, STOPWATCH_LAPS_COUNT_IDX)) {
-        AttsHandleValueNtf(connId, STOPWATCH_LAPS_COUNT_VALUE_HANDLE, sizeof(newLapsCount), (uint8_t *)&newLapsCount);
+    stopwatchLapsCount = newLapsCount;
+
+    if (isChanged) {
+        BLE_Notify(STOPWATCH_LAPS_COUNT_IDX);
     }
 
-    stopwatchLapsCount = newLapsCount;
+    BLE_UpdateBroadcast();
 }
 
-void BLE_SetCurrentTime(uint32_t time) {
+void BLE_SetStatus(uint8_t newStatus) {
     uint8_t status;
 
-    status = AttsSetAttr(STOPWATCH_ELAPSED_VALUE_HANDLE, sizeof(time), (uint8_t *)&time);
+    status = AttsSetAttr(STOPWATCH_STATUS_VALUE_HANDLE, sizeof(newStatus), &newStatus);
     if (status) {
-        APP_TRACE_ERR1("Error while setting current elapsed time. Status 0x%02x", status);
+        APP_TRACE_ERR1("Error while setting status value. Status 0x%02x", status);
         return;
     }
 
-    stopwatchElapsed = time;
+    stopwatchStatus = newStatus;
+    BLE_Notify(STOPWATCH_STATUS_IDX);
+
+    BLE_UpdateBroadcast();
 }
 
-void BLE_SetStatus(uint8_t newStatus) {
+void BLE_SetEnergyReport(uint8_t *report, uint16_t len) {
     uint8_t status;
 
-    status = AttsSetAttr(STOPWATCH_STATUS_VALUE_HANDLE, sizeof(newStatus), &newStatus);
+    status = AttsSetAttr(STOPWATCH_ENERGY_VALUE_HANDLE, len, report);
     if (status) {
-        APP_TRACE_ERR1("Error while setting status value. Status 0x%02x", status);
+        APP_TRACE_ERR1("Error while setting energy report. Status 0x%02x", status);
         return;
     }
+}
+
+static void BLE_WriteUint32(uint8_t *p, uint32_t value) {
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+// listeners extrapolate elapsed time while running flag is set, so periodic refresh only corrects drift
+static void BLE_UpdateBroadcast() {
+    uint8_t *p = avertisignData + BLE_BROADCAST_PAYLOAD_OFFSET;
+    uint8_t isRunning = stopwatchStatus == 0x01;
+
+    p[0] = BLE_BROADCAST_VERSION;
+    p[1] = isRunning ? BLE_BROADCAST_FLAG_RUNNING : 0;
+    p[2] = ++broadcastSequence;
+    BLE_WriteUint32(p + 3, GUI_GetElapsedTime());
+    p[7] = stopwatchLapsCount;
+    BLE_WriteUint32(p + 8, stopwatchLapsCount ? GUI_GetLapTime(stopwatchLapsCount - 1) : 0);
 
-    dmConnId_t connId = AppConnIsOpen();
-    if (connId != DM_CONN_ID_NONE && AttsCccEnabled(connId, STOPWATCH_STATUS_IDX)) {
-        AttsHandleValueNtf(connId, STOPWATCH_STATUS_VALUE_HANDLE, sizeof(newStatus), (uint8_t *)&newStatus);
+    if (isAdvertising) {
+        DmAdvSetData(DM_ADV_HANDLE_DEFAULT, HCI_ADV_DATA_OP_COMP_FRAG, DM_DATA_LOC_ADV, sizeof(avertisignData), avertisignData);
     }
 
-    stopwatchStatus = newStatus;
+    if (isAdvertising && isRunning) {
+        Profile_TimerStartMs(&broadcastTimer, BLE_BROADCAST_UPDATE_PERIOD);
+    } else {
+        Profile_TimerStop(&broadcastTimer);
+    }
+}
+
+void BLE_SetBroadcastEnabled(int isEnabled) {
+    isBroadcastEnabled = isEnabled;
+    pAppAdvCfg = (appAdvCfg_t *)(isEnabled ? &broadcastAdvertisignConfig : &advertisignConfig);
+
+    // new advertising parameters are applied on next advertising start
+    if (isAdvertising) {
+        isAdvertisingRestartPending = 1;
+        AppAdvStop();
+    } else if (isEnabled && connectionsCount < BLE_CONN_MAX) {
+        AppAdvStart(APP_MODE_AUTO_INIT);
+    }
+}
+
+int BLE_IsBroadcastEnabled() {
+    return isBroadcastEnabled;
+}
+
+int BLE_GetConnectionsCount() {
+    return connectionsCount;
+}
+
+void BLE_DisconnectAll() {
+    dmConnId_t connIds[DM_CONN_MAX];
+    uint8_t count = AppConnOpenList(connIds);
+
+    for (int i = 0; i < count; i++) {
+        AppConnClose(connIds[i]);
+    }
 }
\ No newline at end of file
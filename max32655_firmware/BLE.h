@@ -3,9 +3,23 @@
 
 #include <stdint.h>
 
+// keep in sync with LapEventKind in windows app
+enum {
+    BLE_LAP_EVENT_START,
+    BLE_LAP_EVENT_LAP,
+    BLE_LAP_EVENT_STOP,
+    BLE_LAP_EVENT_RESET,
+};
+
 void BLE_Init();
 void BLE_LapCountChanged(uint8_t newLapsCount);
-void BLE_SetCurrentTime(uint32_t currentTime);
+void BLE_AddLapEvent(uint8_t event, uint8_t lapIndex, uint32_t tick, uint32_t delta);
 void BLE_SetStatus(uint8_t status);
+void BLE_SetEnergyReport(uint8_t *report, uint16_t len);
+uint32_t BLE_GetRadioEventCount();
+void BLE_SetBroadcastEnabled(int isEnabled);
+int BLE_IsBroadcastEnabled();
+int BLE_GetConnectionsCount();
+void BLE_DisconnectAll();
 
 #endif
\ No newline at end of file
@@ -3,18 +3,24 @@
 
 /* project */
 #include "GUI.h"
+#include "Profile.h"
 #include "Time.h"
+#include "Trace.h"
 
 /* max32625 + cordio */
 #include <gpio.h>
 #include <max32655.h>
 #include <nvic_table.h>
+#include <wsf_os.h>
 #include <wsf_timer.h>
 #include <wsf_trace.h>
 
 static wsfTimer_t timer;
 static wsfHandlerId_t timerHandler;
 
+static int isPolling = 0;
+static int idlePollsCount = 0;
+
 static volatile int isEvent = 0;
 static volatile uint32_t lastEventTime;
 static volatile uint32_t lastEventMask;
@@ -28,18 +34,20 @@ static uint32_t firstTransitionChange[BUTTON_COUNT];
 // 30 ms @ 32 MHz
 #define BUTTON_DEBOUNCE_TIME_TICK (BUTTON_DEBOUNCE_TIME_MS * TIME_TICK_PER_MSEC)
 
+// polling continues for a while after release so release bounces are not taken as presses
+#define BUTTON_IDLE_POLLS_MAX 3
+
+#define BUTTON_GPIO_EVENT_MASK 0x0001
+
 void Button_GpioInterruptHandler() {
     isEvent = 1;
     lastEventTime = TIME_TIMER->cnt;
     lastEventMask = MXC_GPIO_GetFlags(BUTTON_GPIO);
     MXC_GPIO_ClearFlags(BUTTON_GPIO, lastEventMask);
+    WsfSetEvent(timerHandler, BUTTON_GPIO_EVENT_MASK);
 }
 
-void Button_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
-    if (pMsg == NULL || pMsg->event != BUTTON_TIMER_TICK_EVENT) {
-        return;
-    }
-
+static void Button_Poll() {
     NVIC_DisableIRQ(BUTTON_IRQn);
     int isEventLocal = isEvent;
     uint32_t lastEventTimeLocal = lastEventTime;
@@ -47,6 +55,8 @@ void Button_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
     isEvent = 0;
     NVIC_EnableIRQ(BUTTON_IRQn);
 
+    int isAnyPressed = 0;
+
     for (size_t i = 0; i < BUTTON_COUNT; i++) {
         if (isEventLocal) {
             if (lastEventMaskLocal & buttonMask[i]) {
@@ -62,13 +72,37 @@ void Button_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
 
         /* && (now - firstTransitionChange[i]) < BUTTON_DEBOUNCE_TIME_MS */
         if (prevButtonState[i] == 1 && currentBtnState == 0) {
+            Trace_Event(TRACE_EVENT_BUTTON_PRESS, i, firstTransitionChange[i]);
             GUI_HandleButtonPress(i, firstTransitionChange[i]);
         }
 
         prevButtonState[i] = currentBtnState;
+
+        if (currentBtnState == 0) {
+            isAnyPressed = 1;
+        }
+    }
+
+    if (isAnyPressed || isEventLocal) {
+        idlePollsCount = 0;
+    } else {
+        idlePollsCount++;
+    }
+
+    if (idlePollsCount < BUTTON_IDLE_POLLS_MAX) {
+        isPolling = 1;
+        Profile_TimerStartMs(&timer, BUTTON_DEBOUNCE_TIME_MS);
+    } else {
+        isPolling = 0;
     }
+}
 
-    WsfTimerStartMs(&timer, BUTTON_DEBOUNCE_TIME_MS);
+void Button_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    if (pMsg != NULL && pMsg->event == BUTTON_TIMER_TICK_EVENT) {
+        Button_Poll();
+    } else if (pMsg == NULL && (event & BUTTON_GPIO_EVENT_MASK) && !isPolling) {
+        Button_Poll();
+    }
 }
 
 void Button_Init() {
@@ -99,11 +133,11 @@ void Button_Init() {
 
     MXC_GPIO_EnableInt(BUTTON_GPIO, btn.mask);
 
-    timerHandler = WsfOsSetNextHandler(Button_TimerHandler);
+    timerHandler = Profile_SetNextHandler(Button_TimerHandler, "Btn");
 
     timer.handlerId = timerHandler;
     timer.msg.event = BUTTON_TIMER_TICK_EVENT;
     timer.msg.param = 0;
     timer.msg.status = 0;
-    WsfTimerStartMs(&timer, 1);
+    Profile_TimerStartMs(&timer, 1);
 }
\ No newline at end of file
@@ -1,55 +1,52 @@
 /* project */
 #include "Display.h"
+#include "DisplayBus.h"
+#include "FontData.h"
+#include "Profile.h"
+#include "Raster.h"
+#include "Time.h"
+#include "Trace.h"
 
 /* stdlib */
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* max32655 + cordio */
-#include <i2c.h>
 #include <wsf_timer.h>
-#include <wsf_trace.h>
 
-#define DISPLAY_I2C_ADDRESS 0x3C
-#define DISPLAY_I2C MXC_I2C2
-#define DISPLAY_I2C_IRQn I2C2_IRQn
-#define DISPLAY_I2C_SDA_GPIO MXC_GPIO0
-#define DISPLAY_I2C_SDA_GPIO_PIN MXC_GPIO_PIN_31
-#define DISPLAY_I2C_SCL_GPIO MXC_GPIO0
-#define DISPLAY_I2C_SCL_GPIO_PIN MXC_GPIO_PIN_30
+// first column of panel in controller RAM, 64x48 panel shows middle of 128 columns, SH1106 has 132 of them
+#if DISPLAY_PANEL == DISPLAY_PANEL_SSD1306_64X48
+#define DISPLAY_COLUMN_OFFSET 32
+#elif DISPLAY_PANEL == DISPLAY_PANEL_SH1106_128X64
+#define DISPLAY_COLUMN_OFFSET 2
+#else
+#define DISPLAY_COLUMN_OFFSET 0
+#endif
 
 #define DISPLAY_TIMER_TICK_EVENT 0xFA
-
-static uint8_t fontDefinition[] = {
-    0x0e, 0x11, 0x11, 0x0e, 0x12, 0x1f, 0x10, 0x12, 0x19, 0x15, 0x12, 0x11, 0x15, 0x15, 0x0a, 0x0c,
-    0x0a, 0x09, 0x1f, 0x17, 0x15, 0x15, 0x0d, 0x0e, 0x15, 0x15, 0x08, 0x01, 0x01, 0x1d, 0x03, 0x0a,
-    0x15, 0x15, 0x0a, 0x02, 0x15, 0x15, 0x0e, 0x1e, 0x05, 0x05, 0x1e, 0x1f, 0x15, 0x15, 0x0a, 0x0e,
-    0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x0e, 0x1f, 0x15, 0x15, 0x1f, 0x05, 0x05, 0x0e, 0x11, 0x15,
-    0x1d, 0x1f, 0x04, 0x04, 0x1f, 0x1f, 0x08, 0x10, 0x10, 0x0f, 0x1f, 0x04, 0x0a, 0x11, 0x1f, 0x10,
-    0x10, 0x1f, 0x02, 0x04, 0x02, 0x1f, 0x1f, 0x02, 0x04, 0x1f, 0x0e, 0x11, 0x11, 0x0e, 0x1f, 0x05,
-    0x05, 0x02, 0x0e, 0x11, 0x09, 0x16, 0x1f, 0x05, 0x0d, 0x12, 0x12, 0x15, 0x15, 0x09, 0x01, 0x01,
-    0x1f, 0x01, 0x01, 0x0f, 0x10, 0x10, 0x0f, 0x03, 0x0c, 0x10, 0x0c, 0x03, 0x07, 0x18, 0x07, 0x18,
-    0x07, 0x1b, 0x04, 0x04, 0x1b, 0x17, 0x14, 0x14, 0x0f, 0x19, 0x15, 0x15, 0x13};
-
-static uint8_t fondIndexTable[] = {
-    0x00, 0x04, 0x07, 0x0b, 0x0f, 0x13, 0x17, 0x1b, 0x1f, 0x23, 0x27, 0x27, 0x27, 0x27, 0x27, 0x27,
-    0x27, 0x27, 0x2b, 0x2f, 0x33, 0x37, 0x3a, 0x3d, 0x41, 0x45, 0x46, 0x4a, 0x4e, 0x51, 0x56, 0x5a,
-    0x5e, 0x62, 0x66, 0x6a, 0x6e, 0x73, 0x77, 0x7c, 0x81, 0x85, 0x89, sizeof(fontDefinition)};
+#define DISPLAY_RETRY_DELAY 100
 
 static uint8_t configCommands[] = {
+    0x00,  // Co = 0, D/C = 0: rest of the transfer are commands
     // from display datasheet:
     0xAE,  // Display Off
     0xD5,  // SET DISPLAY CLOCK
     0x80,  // 105HZ
     0xA8,  // Select Multiplex Ratio
-    47,
+    DISPLAY_LINES * 8 - 1,
     0xD3,  // Setting Display Offset
     0x00,  // 00H Reset, set common start
     0x40,  // Set Display Start Line
+#if DISPLAY_PANEL == DISPLAY_PANEL_SH1106_128X64
+    0xAD,  // Set DC-DC
+    0x8B,  // Enable DC-DC
+#else
     0x8D,  // Set Charge Pump
     0x14,  // Endable Charge Pump
-    0x20,
-    0x00,
+    0x20,  // Set Memory Addressing Mode
+    0x02,  // Page addressing, the only one SH1106 has
+#endif
     // Set Segment Re-Map Default
     // 0xA0 (0x00) => column Address 0 mapped to 127
     // 0xA1 (0x01) => Column Address 127 mapped to 0
@@ -67,34 +64,71 @@ static uint8_t configCommands[] = {
     0xA6,  // Set Normal Display
     0xAF,  // Display ON
 };
-static uint8_t *configCommandsEnd = configCommands + sizeof(configCommands);
-static uint8_t *configCommandsToExecute = configCommands;
 
-static uint8_t sendBufferCommands[] = {
-    0x22,
-    0,
-    6,
-    0x21,
-    32,
-    95,
+// page address is filled in for every page sent, column is where panel starts in controller RAM
+static uint8_t pageCommands[] = {
+    0x00,
+    0xB0,
+    0x00 | (DISPLAY_COLUMN_OFFSET & 0x0F),
+    0x10 | (DISPLAY_COLUMN_OFFSET >> 4),
 };
-static uint8_t *sendBufferCommandsEnd = sendBufferCommands + sizeof(sendBufferCommands);
-static uint8_t *sendBufferCommandToExecute = sendBufferCommands;
 
-static uint8_t commandBuffer[2] = {};
+#define DISPLAY_PAGE_ADDRESS_COMMAND 0xB0
+#define DISPLAY_ALL_ROWS ((1 << DISPLAY_LINES) - 1)
+
+// controller has 8 pages of GDDRAM, panel shows DISPLAY_LINES of them from start line on, wrapping at the end
+#define DISPLAY_RAM_PAGES 8
+#define DISPLAY_START_LINE_COMMAND 0x40
 
-static uint8_t buffer1[1 + DISPLAY_WIDTH * DISPLAY_LINES] = {0x40};
-static uint8_t buffer2[1 + DISPLAY_WIDTH * DISPLAY_LINES] = {0x40};
-static uint8_t buffer3[1 + DISPLAY_WIDTH * DISPLAY_LINES] = {0x40};
+static uint8_t startLineCommands[] = {
+    0x00,
+    DISPLAY_START_LINE_COMMAND,
+};
+
+static uint8_t offCommands[] = {
+    0x00,
+    0xAE,
+};
 
-static uint8_t *workingBuffer = buffer1 + 1;
-static uint8_t *readyBuffer = buffer2 + 1;
-static uint8_t *transmitBuffer = buffer3 + 1;
+static uint8_t frameBuffer[DISPLAY_WIDTH * DISPLAY_LINES];
 
 static int isTransmitRequested = 0;
-static int isIdle = 1;
 
-static mxc_i2c_req_t i2cRequest;
+// rows changed in frame buffer since last show
+static uint8_t dirtyRows = 0;
+
+// Copy of controller GDDRAM, pages are valid once written after configuration. Each frame uses start page under
+// which most of its rows are already in GDDRAM, so content scrolled by whole rows is moved by single command
+// and only rows that scrolled in are sent.
+static uint8_t gddram[DISPLAY_RAM_PAGES * DISPLAY_WIDTH];
+static uint8_t validPages = 0;
+static int startPage = 0;
+
+// Frame is sent page by page, each page is copied just before its transfer, so drawing goes on meanwhile
+// and a single frame buffer is enough. Page drawn again during transfer is sent by following frame.
+static uint8_t pageData[1 + DISPLAY_WIDTH] = {0x40};
+static int isStartLinePending = 0;
+static int frameNextPage = 0;
+static uint8_t framePages = 0;
+static int framePagesCount = 0;
+static int frameBytesCount = 0;
+
+// Show not yet on glass and show of frame in transmission, frame pending after failed transmission or show
+// that came before previous frame started keeps its older time
+static int isShowPending = 0;
+static uint32_t pendingShowTime = 0;
+static int isFrameShown = 0;
+static uint32_t frameShowTime = 0;
+
+// frame requested while previous one is in transmission is rendered once it ends, so it goes out right away
+static Display_FrameCallback frameCallback = NULL;
+
+static const uint32_t latencyBucketLimits[DISPLAY_LATENCY_BUCKETS - 1] = DISPLAY_LATENCY_BUCKET_LIMITS_MS;
+static Display_Stats stats;
+
+static DisplayBus_Transfer configTransfer;
+static DisplayBus_Transfer frameTransfer;
+static DisplayBus_Transfer offTransfer;
 
 static wsfHandlerId_t displayOpTimerHandler;
 static wsfTimer_t displayOpTimer;
@@ -102,99 +136,212 @@ static wsfTimer_t displayOpTimer;
 static enum {
     DISPLAY_STATE_UNINITIALIZED,
     DISPLAY_STATE_INIT_COMMANDS,
-    DISPLAY_STATE_SEND_BUFFER_COMMANDS,
     DISPLAY_STATE_SEND_BUFFER,
     DISPLAY_STATE_IDLE,
-    DISPLAY_STATE_OFF_REQUEST,
     DISPLAY_STATE_OFF
 } currentState = DISPLAY_STATE_UNINITIALIZED;
 
-static int isI2CActive = 0;
-static int lastTransactionStatus = 0;
+static void Display_TransferCompleted(DisplayBus_Transfer *transfer, int result);
 
-// The same I2C2_IRQHandler is defined in BLE stack (pal_twi.c)
-// void I2C2_IRQHandler() {
-//     MXC_I2C_AsyncHandler(DISPLAY_I2C);
-// }
+static void Display_AddSegment(DisplayBus_Transfer *transfer, uint8_t *data, unsigned int len) {
+    transfer->segments[transfer->segmentsCount] = data;
+    transfer->lengths[transfer->segmentsCount] = len;
+    transfer->segmentsCount++;
+}
 
-static void Display_InitI2C();
-static void Display_TransmitNextConfigCommand();
-static void Display_TransmitNextSendBufferCommand();
-static void Display_TransmitScreenData();
+static void Display_InitTransfer(DisplayBus_Transfer *transfer, int isUrgent) {
+    transfer->segmentsCount = 0;
+    transfer->isUrgent = isUrgent;
+    transfer->isFrameEnd = 0;
+    transfer->callback = Display_TransferCompleted;
+}
 
-static void Display_SwapBuffers(uint8_t **b1, uint8_t **b2) {
-    uint8_t *temp = *b1;
-    *b1 = *b2;
-    *b2 = temp;
+static void Display_Submit(DisplayBus_Transfer *transfer) {
+    int status;
+
+    status = DisplayBus_Submit(transfer);
+    if (status) {
+        TRACE_ERROR(TRACE_MODULE_DISPLAY, status);
+    }
 }
 
-static void Display_CompletionCallback(mxc_i2c_req_t *req, int result) {
-    lastTransactionStatus = result;
-    isI2CActive = 0;
+static void Display_TransmitConfigCommands() {
+    // configuration resets start line, GDDRAM content is not trusted after failure
+    validPages = 0;
+    startPage = 0;
+
+    currentState = DISPLAY_STATE_INIT_COMMANDS;
+    Display_Submit(&configTransfer);
 }
 
-static void Display_TransmitNextConfigCommand() {
-    int status;
+static int Display_IsPageInRam(const uint8_t *row, int ramPage) {
+    return (validPages & (1 << ramPage)) && memcmp(row, gddram + ramPage * DISPLAY_WIDTH, DISPLAY_WIDTH) == 0;
+}
 
-    commandBuffer[0] = 0x00;
-    commandBuffer[1] = *configCommandsToExecute;
+static int Display_CountChangedPages(int base) {
+    int count = 0;
 
-    i2cRequest.tx_buf = commandBuffer;
-    i2cRequest.tx_len = sizeof(commandBuffer);
+    for (int i = 0; i < DISPLAY_LINES; i++) {
+        if (!Display_IsPageInRam(frameBuffer + i * DISPLAY_WIDTH, (base + i) % DISPLAY_RAM_PAGES)) {
+            count++;
+        }
+    }
+    return count;
+}
 
-    isI2CActive = 1;
+// current start page wins ties, so frames without scrolling never move it
+static int Display_ChooseStartPage() {
+    int best = startPage;
+    int bestCount = Display_CountChangedPages(startPage);
+    for (int base = 0; base < DISPLAY_RAM_PAGES && bestCount > 0; base++) {
+        int count = Display_CountChangedPages(base);
+        if (count < bestCount) {
+            best = base;
+            bestCount = count;
+        }
+    }
+    return best;
+}
 
-    status = MXC_I2C_MasterTransactionAsync(&i2cRequest);
-    if (status) {
-        APP_TRACE_ERR1("Display_TransmitNextConfigCommand: MXC_I2C_MasterTransactionAsync failed=%d", status);
+static void Display_TransmitNextFrame();
+
+static uint32_t Display_RecordFrameEnd() {
+    if (!isFrameShown) {
+        return 0;
     }
+
+    isFrameShown = 0;
+    stats.framesTransmitted++;
+
+    uint32_t latency = TIME_TIMER->cnt - frameShowTime;
+    if (latency > stats.maxLatencyTicks) {
+        stats.maxLatencyTicks = latency;
+    }
+
+    int bucket = 0;
+    while (bucket < DISPLAY_LATENCY_BUCKETS - 1 && latency >= latencyBucketLimits[bucket] * TIME_TICK_PER_SEC / 1000) {
+        bucket++;
+    }
+
+    if (stats.latency[bucket] < UINT16_MAX) {
+        stats.latency[bucket]++;
+    }
+
+    return latency;
 }
 
-static void Display_TransmitOffCommand() {
-    int status;
+// Start line command goes with first page of frame, or alone when scrolled rows are all in controller RAM. Pages
+// to send are chosen at frame start, so transport knows which transfer ends the frame.
+static void Display_TransmitNextPage() {
+    frameTransfer.segmentsCount = 0;
 
-    commandBuffer[0] = 0x00;
-    commandBuffer[1] = 0xAE;
+    if (isStartLinePending) {
+        Display_AddSegment(&frameTransfer, startLineCommands, sizeof(startLineCommands));
+        frameBytesCount += sizeof(startLineCommands);
+        isStartLinePending = 0;
+    }
 
-    i2cRequest.tx_buf = commandBuffer;
-    i2cRequest.tx_len = sizeof(commandBuffer);
+    while (frameNextPage < DISPLAY_LINES) {
+        int ramPage = (startPage + frameNextPage) % DISPLAY_RAM_PAGES;
+        uint8_t *row = frameBuffer + frameNextPage * DISPLAY_WIDTH;
+        frameNextPage++;
 
-    isI2CActive = 1;
+        if (!(framePages & (1 << (frameNextPage - 1)))) {
+            continue;
+        }
 
-    status = MXC_I2C_MasterTransactionAsync(&i2cRequest);
-    if (status) {
-        APP_TRACE_ERR1("Display_TransmitOffCommand: MXC_I2C_MasterTransactionAsync failed=%d", status);
+        memcpy(gddram + ramPage * DISPLAY_WIDTH, row, DISPLAY_WIDTH);
+        validPages |= 1 << ramPage;
+        memcpy(pageData + 1, row, DISPLAY_WIDTH);
+        pageCommands[1] = DISPLAY_PAGE_ADDRESS_COMMAND | ramPage;
+
+        Display_AddSegment(&frameTransfer, pageCommands, sizeof(pageCommands));
+        Display_AddSegment(&frameTransfer, pageData, sizeof(pageData));
+        frameBytesCount += sizeof(pageCommands) + sizeof(pageData);
+        framePagesCount++;
+        break;
     }
+
+    if (frameTransfer.segmentsCount == 0) {
+        uint32_t latencyMs = Display_RecordFrameEnd() * 1000 / TIME_TICK_PER_SEC;
+        if (frameBytesCount) {
+            Trace_Event(TRACE_EVENT_DISPLAY_FRAME, (startPage << 8) | framePagesCount, ((latencyMs < 0xFFFF ? latencyMs : 0xFFFF) << 16) | frameBytesCount);
+        }
+        Display_TransmitNextFrame();
+        return;
+    }
+
+    frameTransfer.isFrameEnd = (framePages >> frameNextPage) == 0;
+    Display_Submit(&frameTransfer);
 }
 
-static void Display_TransmitNextSendBufferCommand() {
-    int status;
+static void Display_TransmitNextFrame() {
+    if (!isTransmitRequested) {
+        currentState = DISPLAY_STATE_IDLE;
 
-    commandBuffer[0] = 0x00;
-    commandBuffer[1] = *sendBufferCommandToExecute;
+        if (frameCallback) {
+            Display_FrameCallback callback = frameCallback;
+            frameCallback = NULL;
+            callback();
+        }
+        return;
+    }
 
-    i2cRequest.tx_buf = commandBuffer;
-    i2cRequest.tx_len = sizeof(commandBuffer);
+    isTransmitRequested = 0;
 
-    isI2CActive = 1;
+    isFrameShown = isShowPending;
+    frameShowTime = pendingShowTime;
+    isShowPending = 0;
 
-    status = MXC_I2C_MasterTransactionAsync(&i2cRequest);
-    if (status) {
-        APP_TRACE_ERR1("Display_TransmitNextSendBufferCommand: MXC_I2C_MasterTransactionAsync failed=%d", status);
+    int base = Display_ChooseStartPage();
+    isStartLinePending = base != startPage || !validPages;
+    startLineCommands[1] = DISPLAY_START_LINE_COMMAND | (base * 8);
+    startPage = base;
+
+    framePages = 0;
+    for (int i = 0; i < DISPLAY_LINES; i++) {
+        if (!Display_IsPageInRam(frameBuffer + i * DISPLAY_WIDTH, (base + i) % DISPLAY_RAM_PAGES)) {
+            framePages |= 1 << i;
+        }
     }
+
+    frameNextPage = 0;
+    framePagesCount = 0;
+    frameBytesCount = 0;
+
+    currentState = DISPLAY_STATE_SEND_BUFFER;
+    Display_TransmitNextPage();
 }
 
-static void Display_TransmitScreenData() {
-    int status;
+static void Display_TransferCompleted(DisplayBus_Transfer *transfer, int result) {
+    if (currentState == DISPLAY_STATE_OFF) {
+        return;
+    }
 
-    i2cRequest.tx_buf = transmitBuffer - 1;
-    i2cRequest.tx_len = sizeof(buffer1);
+    if (result) {
+        TRACE_ERROR(TRACE_MODULE_DISPLAY, result);
 
-    isI2CActive = 1;
+        // display is configured again, so whole frame is sent
+        isTransmitRequested = 1;
 
-    status = MXC_I2C_MasterTransactionAsync(&i2cRequest);
-    if (status) {
-        APP_TRACE_ERR1("Display_TransmitScreenData: MXC_I2C_MasterTransactionAsync failed=%d", status);
+        if (isFrameShown) {
+            if (isShowPending) {
+                stats.framesDropped++;
+            }
+            isShowPending = 1;
+            pendingShowTime = frameShowTime;
+            isFrameShown = 0;
+        }
+
+        currentState = DISPLAY_STATE_INIT_COMMANDS;
+        Profile_TimerStartMs(&displayOpTimer, DISPLAY_RETRY_DELAY);
+        return;
+    }
+
+    if (transfer == &frameTransfer) {
+        Display_TransmitNextPage();
+    } else {
+        Display_TransmitNextFrame();
     }
 }
 
@@ -204,245 +351,284 @@ static void Display_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
     }
 
     if (currentState == DISPLAY_STATE_UNINITIALIZED) {
-        Display_InitI2C();
-    } else if (currentState == DISPLAY_STATE_INIT_COMMANDS && !isI2CActive) {
-        if (lastTransactionStatus == 0) {
-            if (configCommandsToExecute < configCommandsEnd) {
-                Display_TransmitNextConfigCommand();
-                configCommandsToExecute++;
-            } else {
-                if (isTransmitRequested) {
-                    isTransmitRequested = 0;
-                    Display_SwapBuffers(&transmitBuffer, &readyBuffer);
-                    sendBufferCommandToExecute = sendBufferCommands;
-                    currentState = DISPLAY_STATE_SEND_BUFFER_COMMANDS;
-                } else {
-                    currentState = DISPLAY_STATE_IDLE;
-                }
-            }
-        } else {
-            configCommandsToExecute = configCommands;
-            currentState = DISPLAY_STATE_INIT_COMMANDS;
+        if (DisplayBus_Configure()) {
+            Profile_TimerStartMs(&displayOpTimer, DISPLAY_RETRY_DELAY);
+            return;
         }
-    } else if (currentState == DISPLAY_STATE_SEND_BUFFER_COMMANDS && !isI2CActive) {
-        if (lastTransactionStatus == 0) {
-            if (sendBufferCommandToExecute < sendBufferCommandsEnd) {
-                Display_TransmitNextSendBufferCommand();
-                sendBufferCommandToExecute++;
-            } else {
-                currentState = DISPLAY_STATE_SEND_BUFFER;
-                Display_TransmitScreenData();
-            }
-        } else {
-            configCommandsToExecute = configCommands;
-            currentState = DISPLAY_STATE_INIT_COMMANDS;
-        }
-    } else if (currentState == DISPLAY_STATE_SEND_BUFFER && !isI2CActive) {
-        if (lastTransactionStatus == 0) {
-            if (isTransmitRequested) {
-                isTransmitRequested = 0;
-                Display_SwapBuffers(&transmitBuffer, &readyBuffer);
-                sendBufferCommandToExecute = sendBufferCommands;
-                currentState = DISPLAY_STATE_SEND_BUFFER_COMMANDS;
-            } else {
-                currentState = DISPLAY_STATE_IDLE;
-            }
-        } else {
-            configCommandsToExecute = configCommands;
-            currentState = DISPLAY_STATE_INIT_COMMANDS;
-        }
-    } else if (currentState == DISPLAY_STATE_IDLE) {
-        if (isTransmitRequested) {
-            isTransmitRequested = 0;
-            Display_SwapBuffers(&transmitBuffer, &readyBuffer);
-            sendBufferCommandToExecute = sendBufferCommands;
-            currentState = DISPLAY_STATE_SEND_BUFFER_COMMANDS;
-        }
-    } else if (currentState == DISPLAY_STATE_OFF_REQUEST && !isI2CActive) {
-        Display_TransmitOffCommand();
-        currentState = DISPLAY_STATE_OFF;
-    } else if (currentState == DISPLAY_STATE_OFF && !isI2CActive) {
-        currentState = DISPLAY_STATE_OFF_REQUEST;
+        Display_TransmitConfigCommands();
+    } else if (currentState == DISPLAY_STATE_INIT_COMMANDS) {
+        Display_TransmitConfigCommands();
     }
-
-    WsfTimerStartMs(&displayOpTimer, 1);
 }
 
 void Display_Init() {
-    displayOpTimerHandler = WsfOsSetNextHandler(Display_TimerHandler);
+    Display_InitTransfer(&configTransfer, 0);
+    Display_AddSegment(&configTransfer, configCommands, sizeof(configCommands));
+
+    Display_InitTransfer(&frameTransfer, 0);
+
+    Display_InitTransfer(&offTransfer, 1);
+    Display_AddSegment(&offTransfer, offCommands, sizeof(offCommands));
+
+    DisplayBus_Init();
+
+    stats.statsStartTime = TIME_TIMER->cnt;
+
+    displayOpTimerHandler = Profile_SetNextHandler(Display_TimerHandler, "Dsp");
     displayOpTimer.handlerId = displayOpTimerHandler;
     displayOpTimer.msg.event = DISPLAY_TIMER_TICK_EVENT;
     displayOpTimer.msg.param = 0;
     displayOpTimer.msg.status = 0;
-    WsfTimerStartMs(&displayOpTimer, 250);
+    Profile_TimerStartMs(&displayOpTimer, 250);
 }
 
-static void Display_InitI2C() {
-    int status;
+void Display_Off() {
+    int isInitialized = currentState != DISPLAY_STATE_UNINITIALIZED;
 
-    i2cRequest.addr = DISPLAY_I2C_ADDRESS;
-    i2cRequest.i2c = DISPLAY_I2C;
-    i2cRequest.restart = 0;
-    i2cRequest.rx_buf = NULL;
-    i2cRequest.rx_len = 0;
-    i2cRequest.callback = Display_CompletionCallback;
+    currentState = DISPLAY_STATE_OFF;
+    frameCallback = NULL;
+    Profile_TimerStop(&displayOpTimer);
 
-    isIdle = 0;
+    if (isInitialized) {
+        Display_Submit(&offTransfer);
+    }
+}
 
-    status = MXC_I2C_Init(DISPLAY_I2C, 1, 0);
-    if (status) {
-        APP_TRACE_ERR1("Display_InitI2C: MXC_I2C_Init failed=%d", status);
+// frame buffer keeps the frame, so callers only draw what changed, and only changed rows are transmitted
+void Display_Show() {
+    if (!dirtyRows) {
         return;
     }
 
-    MXC_GPIO_SetVSSEL(DISPLAY_I2C_SDA_GPIO, MXC_GPIO_VSSEL_VDDIOH, DISPLAY_I2C_SDA_GPIO_PIN);
-    MXC_GPIO_SetVSSEL(DISPLAY_I2C_SCL_GPIO, MXC_GPIO_VSSEL_VDDIOH, DISPLAY_I2C_SCL_GPIO_PIN);
+    dirtyRows = 0;
+    isTransmitRequested = 1;
 
-    status = MXC_I2C_SetFrequency(DISPLAY_I2C, 100000);
-    if (status < 0) {
-        APP_TRACE_ERR1("Display_InitI2C: MXC_I2C_SetFrequency failed=%d", status);
-        return;
+    stats.framesRendered++;
+    if (isShowPending) {
+        stats.framesDropped++;
+    } else {
+        isShowPending = 1;
+        pendingShowTime = TIME_TIMER->cnt;
     }
 
-    isI2CActive = 0;
-    configCommandsToExecute = configCommands;
-    currentState = DISPLAY_STATE_INIT_COMMANDS;
+    if (currentState == DISPLAY_STATE_IDLE) {
+        Display_TransmitNextFrame();
+    }
+}
 
-    NVIC_SetPriority(DISPLAY_I2C_IRQn, 3);
-    NVIC_ClearPendingIRQ(DISPLAY_I2C_IRQn);
-    NVIC_EnableIRQ(DISPLAY_I2C_IRQn);
+// callback is called when display can send next frame, right away unless a frame is in transmission
+void Display_RequestFrame(Display_FrameCallback callback) {
+    if (currentState == DISPLAY_STATE_SEND_BUFFER) {
+        frameCallback = callback;
+        return;
+    }
+
+    frameCallback = NULL;
+    callback();
 }
 
-void Display_Off() {
-    currentState = DISPLAY_STATE_OFF_REQUEST;
+void Display_GetStats(Display_Stats *displayStats) {
+    *displayStats = stats;
 }
 
-void Display_Show() {
-    Display_SwapBuffers(&workingBuffer, &readyBuffer);
-    isTransmitRequested = 1;
+void Display_ResetStats() {
+    stats = (Display_Stats){0};
+    stats.statsStartTime = TIME_TIMER->cnt;
 }
 
 void Display_Clear() {
-    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_LINES; i++) {
-        workingBuffer[i] = 0x00;
-    }
+    memset(frameBuffer, 0, DISPLAY_WIDTH * DISPLAY_LINES);
+    dirtyRows = DISPLAY_ALL_ROWS;
 }
 
 void Display_SetPixelBuffer(int x, int row, uint8_t value) {
     if (x >= DISPLAY_WIDTH || row >= DISPLAY_LINES) {
         return;
     }
-    workingBuffer[row * DISPLAY_WIDTH + x] = value;
+    frameBuffer[row * DISPLAY_WIDTH + x] = value;
+    dirtyRows |= 1 << row;
 }
 
 void Display_OrPixelBuffer(int x, int row, uint8_t value) {
-    workingBuffer[row * DISPLAY_WIDTH + x] |= value;
+    frameBuffer[row * DISPLAY_WIDTH + x] |= value;
+    dirtyRows |= 1 << row;
 }
 
 void Display_InvertPixelBuffer(int x, int row) {
-    workingBuffer[row * DISPLAY_WIDTH + x] ^= 0xFF;
+    frameBuffer[row * DISPLAY_WIDTH + x] ^= 0xFF;
+    dirtyRows |= 1 << row;
 }
 
 void Display_ShiftLeftPixelBuffer(int x, int row, int shift) {
-    workingBuffer[row * DISPLAY_WIDTH + x] <<= shift;
+    frameBuffer[row * DISPLAY_WIDTH + x] <<= shift;
+    dirtyRows |= 1 << row;
 }
 
 void Display_ShiftRightPixelBuffer(int x, int row, int shift) {
-    workingBuffer[row * DISPLAY_WIDTH + x] >>= shift;
+    frameBuffer[row * DISPLAY_WIDTH + x] >>= shift;
+    dirtyRows |= 1 << row;
 }
 
-int Display_PrintChar(int x, int row, char ch) {
-    if (ch == ':') {
-        Display_SetPixelBuffer(x, row, 0x0A);
-        Display_SetPixelBuffer(x + 1, row, 0);
-        return x + 2;
-    } else if (ch == '.') {
-        Display_SetPixelBuffer(x, row, 0x10);
-        Display_SetPixelBuffer(x + 1, row, 0);
-        return x + 2;
-    } else if (ch == '*') {
-        Display_SetPixelBuffer(x + 0, row, 0b00000010);
-        Display_SetPixelBuffer(x + 1, row, 0b00000100);
-        Display_SetPixelBuffer(x + 2, row, 0b00001000);
-        Display_SetPixelBuffer(x + 3, row, 0b00000100);
-        Display_SetPixelBuffer(x + 4, row, 0b00000010);
-        Display_SetPixelBuffer(x + 5, row, 0);
-        return x + 6;
-    } else if (ch == ' ') {
-        Display_SetPixelBuffer(x, row, 0);
-        Display_SetPixelBuffer(x + 1, row, 0);
-        return x + 2;
-    } else if (ch == '%') {
-        Display_SetPixelBuffer(x + 0, row, 0b00010011);
-        Display_SetPixelBuffer(x + 1, row, 0b00001011);
-        Display_SetPixelBuffer(x + 2, row, 0b00000100);
-        Display_SetPixelBuffer(x + 3, row, 0b00011010);
-        Display_SetPixelBuffer(x + 4, row, 0b00011001);
-        Display_SetPixelBuffer(x + 5, row, 0);
-        return x + 6;
-    }
-
-    if (ch >= 'a' && ch <= 'z') {
-        ch -= 32;
-    }
-
-    if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z')) {
-        ch -= 48;
-
-        size_t startIndex = fondIndexTable[(unsigned char)ch];
-        size_t endIndex = fondIndexTable[ch + 1];
-
-        for (size_t i = startIndex; i < endIndex; i++) {
-            Display_SetPixelBuffer(x++, row, fontDefinition[i]);
-        }
-        Display_SetPixelBuffer(x++, row, 0x00);
+// whole row of DISPLAY_WIDTH columns, lets callers cache rendered rows instead of drawing them again
+void Display_GetRowBuffer(int row, uint8_t *pixels) {
+    memcpy(pixels, frameBuffer + row * DISPLAY_WIDTH, DISPLAY_WIDTH);
+}
+
+void Display_SetRowBuffer(int row, const uint8_t *pixels) {
+    Display_CopyRect(0, row, DISPLAY_WIDTH, 1, pixels, DISPLAY_WIDTH);
+}
+
+// moves rows firstRow to lastRow up by delta rows (down when negative), uncovered rows are cleared
+void Display_ScrollRows(int firstRow, int lastRow, int delta) {
+    int rows = lastRow - firstRow + 1;
+    int shift = delta > 0 ? delta : -delta;
+    if (shift > rows) {
+        shift = rows;
+    }
+    int moved = rows - shift;
+
+    uint8_t *first = frameBuffer + firstRow * DISPLAY_WIDTH;
+    if (delta > 0) {
+        memmove(first, first + shift * DISPLAY_WIDTH, moved * DISPLAY_WIDTH);
+        memset(first + moved * DISPLAY_WIDTH, 0, shift * DISPLAY_WIDTH);
+    } else {
+        memmove(first + shift * DISPLAY_WIDTH, first, moved * DISPLAY_WIDTH);
+        memset(first, 0, shift * DISPLAY_WIDTH);
     }
 
-    return x;
+    dirtyRows |= ((1 << rows) - 1) << firstRow;
 }
 
-int Display_GetCharLength(char ch) {
-    if (ch == ':') {
-        return 2;
-    } else if (ch == '.') {
-        return 2;
-    } else if (ch == '*') {
-        return 6;
-    } else if (ch == ' ') {
-        return 2;
-    } else if (ch == '%') {
-        return 6;
+// span functions work on columns [x0, x1) of row, clipped to display, whole words at a time
+static uint8_t *Display_ClipSpan(int *x0, int *x1, int row) {
+    if (*x0 < 0) {
+        *x0 = 0;
+    }
+    if (*x1 > DISPLAY_WIDTH) {
+        *x1 = DISPLAY_WIDTH;
+    }
+    if (row < 0 || row >= DISPLAY_LINES || *x0 >= *x1) {
+        return NULL;
     }
 
-    if (ch >= 'a' && ch <= 'z') {
-        ch -= 32;
+    dirtyRows |= 1 << row;
+    return frameBuffer + row * DISPLAY_WIDTH + *x0;
+}
+
+void Display_FillSpan(int x0, int x1, int row, uint8_t value) {
+    uint8_t *p = Display_ClipSpan(&x0, &x1, row);
+    if (p) {
+        Raster_Rop(p, x1 - x0, 0x00, value);
     }
+}
 
-    if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z')) {
-        ch -= 48;
+void Display_OrSpan(int x0, int x1, int row, uint8_t value) {
+    uint8_t *p = Display_ClipSpan(&x0, &x1, row);
+    if (p) {
+        Raster_Rop(p, x1 - x0, ~value, value);
+    }
+}
 
-        size_t startIndex = fondIndexTable[(unsigned char)ch];
-        size_t endIndex = fondIndexTable[ch + 1];
+void Display_InvertSpan(int x0, int x1, int row) {
+    uint8_t *p = Display_ClipSpan(&x0, &x1, row);
+    if (p) {
+        Raster_Rop(p, x1 - x0, 0xFF, 0xFF);
+    }
+}
 
-        return endIndex - startIndex + 1;
+void Display_ShiftLeftSpan(int x0, int x1, int row, int shift) {
+    uint8_t *p = Display_ClipSpan(&x0, &x1, row);
+    if (p) {
+        Raster_ShiftLeft(p, x1 - x0, shift);
     }
+}
 
-    return 0;
+void Display_BlitMasked(int x, int row, const uint8_t *pixels, const uint8_t *mask, int len) {
+    int x1 = x + len;
+    int x0 = x;
+    uint8_t *p = Display_ClipSpan(&x0, &x1, row);
+    if (p) {
+        Raster_BlitMasked(p, pixels + (x0 - x), mask + (x0 - x), x1 - x0);
+    }
 }
 
-int Display_PrintString(int x, int row, char *str) {
+// rows of source are stride bytes apart, parts outside of display are skipped
+void Display_CopyRect(int x, int row, int width, int height, const uint8_t *pixels, int stride) {
+    for (int i = 0; i < height; i++) {
+        int x0 = x;
+        int x1 = x + width;
+        uint8_t *p = Display_ClipSpan(&x0, &x1, row + i);
+        if (p) {
+            memcpy(p, pixels + i * stride + (x0 - x), x1 - x0);
+        }
+    }
+}
+
+// lowercase is drawn with uppercase glyphs by fonts that have no lowercase
+static int Display_GetGlyph(const Font *font, char ch, const uint8_t **glyph) {
+    unsigned char c = ch;
+
+    if (c >= 'a' && c <= 'z' && font->last < 'a') {
+        c -= 32;
+    }
+    if (c < font->first || c > font->last) {
+        return 0;
+    }
+
+    c -= font->first;
+    *glyph = font->glyphs + font->offsets[c] * font->height;
+    return font->offsets[c + 1] - font->offsets[c];
+}
+
+int Display_PrintFontChar(const Font *font, int x, int row, char ch) {
+    const uint8_t *glyph;
+    int width = Display_GetGlyph(font, ch, &glyph);
+    if (width == 0) {
+        return x;
+    }
+
+    Display_CopyRect(x, row, width, font->height, glyph, width);
+    for (int i = 0; i < font->height; i++) {
+        Display_FillSpan(x + width, x + width + font->spacing, row + i, 0);
+    }
+    return x + width + font->spacing;
+}
+
+int Display_GetFontCharLength(const Font *font, char ch) {
+    const uint8_t *glyph;
+    int width = Display_GetGlyph(font, ch, &glyph);
+    return width ? width + font->spacing : 0;
+}
+
+int Display_PrintFontString(const Font *font, int x, int row, const char *str) {
     while (*str) {
-        x = Display_PrintChar(x, row, *str);
+        x = Display_PrintFontChar(font, x, row, *str);
         str++;
     }
     return x;
 }
 
-int Display_GetStringLength(char *str) {
+int Display_GetFontStringLength(const Font *font, const char *str) {
     int len = 0;
     while (*str) {
-        len += Display_GetCharLength(*str);
+        len += Display_GetFontCharLength(font, *str);
         str++;
     }
     return len;
+}
+
+int Display_PrintChar(int x, int row, char ch) {
+    return Display_PrintFontChar(&Font_Small, x, row, ch);
+}
+
+int Display_GetCharLength(char ch) {
+    return Display_GetFontCharLength(&Font_Small, ch);
+}
+
+int Display_PrintString(int x, int row, char *str) {
+    return Display_PrintFontString(&Font_Small, x, row, str);
+}
+
+int Display_GetStringLength(char *str) {
+    return Display_GetFontStringLength(&Font_Small, str);
 }
\ No newline at end of file
@@ -1,10 +1,43 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+#include "Font.h"
+
 #include <stdint.h>
 
+// panel is selected in project.mk, e.g. PROJ_CFLAGS += -DDISPLAY_PANEL=DISPLAY_PANEL_SH1106_128X64
+#define DISPLAY_PANEL_SSD1306_64X48 0
+#define DISPLAY_PANEL_SSD1306_128X64 1
+#define DISPLAY_PANEL_SH1106_128X64 2
+
+#ifndef DISPLAY_PANEL
+#define DISPLAY_PANEL DISPLAY_PANEL_SSD1306_64X48
+#endif
+
+#if DISPLAY_PANEL == DISPLAY_PANEL_SSD1306_64X48
 #define DISPLAY_WIDTH 64
 #define DISPLAY_LINES 6
+#else
+#define DISPLAY_WIDTH 128
+#define DISPLAY_LINES 8
+#endif
+
+// show-to-glass latency buckets upper bounds in ms, last bucket is open
+#define DISPLAY_LATENCY_BUCKETS 6
+#define DISPLAY_LATENCY_BUCKET_LIMITS_MS {10, 20, 50, 100, 200}
+
+// Every shown frame is either transmitted, dropped when next show comes before its transmission started, or still
+// pending. Latency is measured from the oldest show not yet on glass to the end of transmission.
+typedef struct {
+    uint32_t framesRendered;
+    uint32_t framesTransmitted;
+    uint32_t framesDropped;
+    uint32_t maxLatencyTicks;
+    uint16_t latency[DISPLAY_LATENCY_BUCKETS];
+    uint32_t statsStartTime;
+} Display_Stats;
+
+typedef void (*Display_FrameCallback)();
 
 void Display_Init();
 void Display_Off();
@@ -13,11 +46,27 @@ void Display_OrPixelBuffer(int x, int row, uint8_t value);
 void Display_InvertPixelBuffer(int x, int row);
 void Display_ShiftLeftPixelBuffer(int x, int row, int shift);
 void Display_ShiftRightPixelBuffer(int x, int row, int shift);
+void Display_GetRowBuffer(int row, uint8_t *pixels);
+void Display_SetRowBuffer(int row, const uint8_t *pixels);
+void Display_ScrollRows(int firstRow, int lastRow, int delta);
+void Display_FillSpan(int x0, int x1, int row, uint8_t value);
+void Display_OrSpan(int x0, int x1, int row, uint8_t value);
+void Display_InvertSpan(int x0, int x1, int row);
+void Display_ShiftLeftSpan(int x0, int x1, int row, int shift);
+void Display_BlitMasked(int x, int row, const uint8_t *pixels, const uint8_t *mask, int len);
+void Display_CopyRect(int x, int row, int width, int height, const uint8_t *pixels, int stride);
 void Display_Show();
+void Display_RequestFrame(Display_FrameCallback callback);
+void Display_GetStats(Display_Stats *stats);
+void Display_ResetStats();
 void Display_Clear();
 int Display_PrintChar(int x, int row, char ch);
 int Display_PrintString(int x, int row, char *str);
 int Display_GetCharLength(char ch);
 int Display_GetStringLength(char *str);
+int Display_PrintFontChar(const Font *font, int x, int row, char ch);
+int Display_PrintFontString(const Font *font, int x, int row, const char *str);
+int Display_GetFontCharLength(const Font *font, char ch);
+int Display_GetFontStringLength(const Font *font, const char *str);
 
 #endif
\ No newline at end of file
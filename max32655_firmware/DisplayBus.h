@@ -0,0 +1,48 @@
+#ifndef DISPLAY_BUS_H
+#define DISPLAY_BUS_H
+
+#include "I2CBus.h"
+
+#include <stdint.h>
+
+// transport is selected in project.mk, e.g. PROJ_CFLAGS += -DDISPLAY_TRANSPORT=DISPLAY_TRANSPORT_SPI
+#define DISPLAY_TRANSPORT_I2C 0
+#define DISPLAY_TRANSPORT_SPI 1
+#define DISPLAY_TRANSPORT_SIM 2
+
+#ifndef DISPLAY_TRANSPORT
+#define DISPLAY_TRANSPORT DISPLAY_TRANSPORT_I2C
+#endif
+
+#define DISPLAY_BUS_MAX_SEGMENTS 3
+
+#define DISPLAY_BUS_CONTROL_COMMANDS 0x00
+#define DISPLAY_BUS_CONTROL_DATA 0x40
+
+typedef struct DisplayBus_Transfer DisplayBus_Transfer;
+typedef void (*DisplayBus_CompletionCallback)(DisplayBus_Transfer *transfer, int result);
+
+// Segments keep SSD1306 I2C framing, control byte followed by commands or data. I2C sends them as they are,
+// SPI sends the rest with D/C pin set from control byte, so Display builds the same stream for every transport.
+// Callback is called from WSF handler, never from interrupt.
+struct DisplayBus_Transfer {
+    uint8_t *segments[DISPLAY_BUS_MAX_SEGMENTS];
+    unsigned int lengths[DISPLAY_BUS_MAX_SEGMENTS];
+    int segmentsCount;
+    int isUrgent;
+    int isFrameEnd;
+    DisplayBus_CompletionCallback callback;
+
+    // owned by transport while transfer is queued
+    DisplayBus_Transfer *next;
+    int currentSegment;
+    I2CBus_Transaction i2cTransaction;
+    mxc_i2c_req_t i2cSegments[DISPLAY_BUS_MAX_SEGMENTS];
+};
+
+void DisplayBus_Init();
+int DisplayBus_Configure();
+int DisplayBus_Submit(DisplayBus_Transfer *transfer);
+int DisplayBus_IsBusy();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+/* self */
+#include "DisplayBus.h"
+
+#if DISPLAY_TRANSPORT == DISPLAY_TRANSPORT_I2C
+
+/* project */
+#include "I2CBus.h"
+
+/* stdlib */
+#include <stddef.h>
+#include <stdint.h>
+
+/* max32655 + cordio */
+#include <gpio.h>
+#include <i2c.h>
+#include <wsf_trace.h>
+
+#define DISPLAY_I2C_ADDRESS 0x3C
+#define DISPLAY_I2C MXC_I2C2
+#define DISPLAY_I2C_IRQn I2C2_IRQn
+#define DISPLAY_I2C_FREQUENCY 100000
+#define DISPLAY_I2C_SDA_GPIO MXC_GPIO0
+#define DISPLAY_I2C_SDA_GPIO_PIN MXC_GPIO_PIN_31
+#define DISPLAY_I2C_SCL_GPIO MXC_GPIO0
+#define DISPLAY_I2C_SCL_GPIO_PIN MXC_GPIO_PIN_30
+
+// The same I2C2_IRQHandler is defined in BLE stack (pal_twi.c)
+// void I2C2_IRQHandler() {
+//     MXC_I2C_AsyncHandler(DISPLAY_I2C);
+// }
+
+static void DisplayBus_TransactionCompleted(I2CBus_Transaction *transaction, int result) {
+    DisplayBus_Transfer *transfer = (DisplayBus_Transfer *)((uint8_t *)transaction - offsetof(DisplayBus_Transfer, i2cTransaction));
+
+    if (transfer->callback) {
+        transfer->callback(transfer, result);
+    }
+}
+
+// I2CBus runs transactions from its own handler
+void DisplayBus_Init() {
+}
+
+int DisplayBus_Configure() {
+    int status;
+
+    status = I2CBus_ConfigureBus(DISPLAY_I2C, DISPLAY_I2C_FREQUENCY, DISPLAY_I2C_IRQn);
+    if (status) {
+        APP_TRACE_ERR1("DisplayBus_Configure: I2CBus_ConfigureBus failed=%d", status);
+        return status;
+    }
+
+    MXC_GPIO_SetVSSEL(DISPLAY_I2C_SDA_GPIO, MXC_GPIO_VSSEL_VDDIOH, DISPLAY_I2C_SDA_GPIO_PIN);
+    MXC_GPIO_SetVSSEL(DISPLAY_I2C_SCL_GPIO, MXC_GPIO_VSSEL_VDDIOH, DISPLAY_I2C_SCL_GPIO_PIN);
+
+    return 0;
+}
+
+// every segment is one I2C write, control byte is first byte after address as controller expects it
+int DisplayBus_Submit(DisplayBus_Transfer *transfer) {
+    for (int i = 0; i < transfer->segmentsCount; i++) {
+        mxc_i2c_req_t *segment = &transfer->i2cSegments[i];
+        segment->i2c = DISPLAY_I2C;
+        segment->addr = DISPLAY_I2C_ADDRESS;
+        segment->restart = 0;
+        segment->tx_buf = transfer->segments[i];
+        segment->tx_len = transfer->lengths[i];
+        segment->rx_buf = NULL;
+        segment->rx_len = 0;
+    }
+
+    I2CBus_Transaction *transaction = &transfer->i2cTransaction;
+    transaction->segments = transfer->i2cSegments;
+    transaction->segmentsCount = transfer->segmentsCount;
+    transaction->priority = transfer->isUrgent ? I2C_BUS_PRIORITY_HIGH : I2C_BUS_PRIORITY_NORMAL;
+    transaction->callback = DisplayBus_TransactionCompleted;
+
+    return I2CBus_Submit(transaction);
+}
+
+// I2CBus reports its own transactions to power management
+int DisplayBus_IsBusy() {
+    return 0;
+}
+
+#endif
\ No newline at end of file
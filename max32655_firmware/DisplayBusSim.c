@@ -0,0 +1,164 @@
+/* self */
+#include "DisplayBus.h"
+
+#if DISPLAY_TRANSPORT == DISPLAY_TRANSPORT_SIM
+
+/* project */
+#include "Profile.h"
+#include "Time.h"
+
+/* stdlib */
+#include <stddef.h>
+#include <stdint.h>
+
+/* max32655 + cordio */
+#include <mxc_errors.h>
+#include <wsf_os.h>
+#include <wsf_timer.h>
+#include <wsf_trace.h>
+
+// Simulated link without display attached, transfers take as long as they would on the wire, e.g. I2C at
+// 400 kHz is -DDISPLAY_SIM_BITRATE=400000 -DDISPLAY_SIM_BITS_PER_BYTE=9, default is SPI at 8 MHz.
+#ifndef DISPLAY_SIM_BITRATE
+#define DISPLAY_SIM_BITRATE 8000000
+#endif
+
+#ifndef DISPLAY_SIM_BITS_PER_BYTE
+#define DISPLAY_SIM_BITS_PER_BYTE 8
+#endif
+
+#define DISPLAY_BUS_TRANSFER_DONE_EVENT 0xE8
+#define DISPLAY_BUS_TRANSFER_DONE_EVENT_MASK 0x0001
+
+static wsfHandlerId_t busHandler;
+static wsfTimer_t transferTimer;
+
+static DisplayBus_Transfer *active = NULL;
+static DisplayBus_Transfer *queueHead = NULL;
+
+// WSF timer counts whole milliseconds, so end of modelled transfer is kept in TIME_TIMER ticks. Transfer that
+// completes late starts the next one at modelled time, so rounding does not lower throughput under load.
+static uint32_t busFreeTick = 0;
+
+static uint32_t reportStartTick = 0;
+static uint32_t reportFrames = 0;
+static uint32_t reportBytes = 0;
+static uint32_t reportBusyTicks = 0;
+
+static void DisplayBus_StartNextTransfer();
+
+static void DisplayBus_Report(uint32_t now) {
+    uint32_t elapsed = now - reportStartTick;
+    if (elapsed < TIME_TICK_PER_SEC) {
+        return;
+    }
+
+    APP_TRACE_INFO3("DisplayBus sim: %u fps, %u B/s, bus busy %u %%", (uint32_t)((uint64_t)reportFrames * TIME_TICK_PER_SEC / elapsed),
+                    (uint32_t)((uint64_t)reportBytes * TIME_TICK_PER_SEC / elapsed), (uint32_t)((uint64_t)reportBusyTicks * 100 / elapsed));
+
+    reportStartTick = now;
+    reportFrames = 0;
+    reportBytes = 0;
+    reportBusyTicks = 0;
+}
+
+static void DisplayBus_CompleteTransfer() {
+    DisplayBus_Transfer *transfer = active;
+    if (transfer == NULL) {
+        return;
+    }
+
+    active = NULL;
+    if (transfer->isFrameEnd) {
+        reportFrames++;
+    }
+    DisplayBus_Report(TIME_TIMER->cnt);
+
+    if (transfer->callback) {
+        transfer->callback(transfer, 0);
+    }
+
+    DisplayBus_StartNextTransfer();
+}
+
+static void DisplayBus_StartNextTransfer() {
+    if (active != NULL || queueHead == NULL) {
+        return;
+    }
+
+    active = queueHead;
+    queueHead = active->next;
+    active->next = NULL;
+
+    unsigned int bytes = 0;
+    for (int i = 0; i < active->segmentsCount; i++) {
+        bytes += active->lengths[i];
+    }
+
+    uint32_t duration = (uint64_t)bytes * DISPLAY_SIM_BITS_PER_BYTE * TIME_TICK_PER_SEC / DISPLAY_SIM_BITRATE;
+    uint32_t now = TIME_TIMER->cnt;
+    if ((int32_t)(busFreeTick - now) < 0 && now - busFreeTick > TIME_TICK_PER_SEC / 1000) {
+        busFreeTick = now;
+    }
+    busFreeTick += duration;
+
+    reportBytes += bytes;
+    reportBusyTicks += duration;
+
+    int32_t remaining = busFreeTick - now;
+    if (remaining <= 0) {
+        WsfSetEvent(busHandler, DISPLAY_BUS_TRANSFER_DONE_EVENT_MASK);
+    } else {
+        Profile_TimerStartMs(&transferTimer, (remaining * 1000 + TIME_TICK_PER_SEC - 1) / TIME_TICK_PER_SEC);
+    }
+}
+
+static void DisplayBus_Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    if (pMsg == NULL && !(event & DISPLAY_BUS_TRANSFER_DONE_EVENT_MASK)) {
+        return;
+    }
+    if (pMsg != NULL && pMsg->event != DISPLAY_BUS_TRANSFER_DONE_EVENT) {
+        return;
+    }
+
+    DisplayBus_CompleteTransfer();
+}
+
+void DisplayBus_Init() {
+    busHandler = Profile_SetNextHandler(DisplayBus_Handler, "DSim");
+    transferTimer.handlerId = busHandler;
+    transferTimer.msg.event = DISPLAY_BUS_TRANSFER_DONE_EVENT;
+    transferTimer.msg.param = 0;
+    transferTimer.msg.status = 0;
+}
+
+int DisplayBus_Configure() {
+    reportStartTick = TIME_TIMER->cnt;
+    busFreeTick = reportStartTick;
+    return 0;
+}
+
+int DisplayBus_Submit(DisplayBus_Transfer *transfer) {
+    if (transfer->segmentsCount < 1 || transfer->segmentsCount > DISPLAY_BUS_MAX_SEGMENTS) {
+        return E_BAD_PARAM;
+    }
+
+    DisplayBus_Transfer **insertAt = &queueHead;
+    while (*insertAt != NULL && (!transfer->isUrgent || (*insertAt)->isUrgent)) {
+        insertAt = &(*insertAt)->next;
+    }
+
+    transfer->next = *insertAt;
+    *insertAt = transfer;
+
+    DisplayBus_StartNextTransfer();
+
+    return E_NO_ERROR;
+}
+
+// simulated transfers are timed by WSF timers, which keep running in deep sleep
+int DisplayBus_IsBusy() {
+    return 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+/* self */
+#include "DisplayBus.h"
+
+#if DISPLAY_TRANSPORT == DISPLAY_TRANSPORT_SPI
+
+/* project */
+#include "Profile.h"
+#include "Trace.h"
+
+/* stdlib */
+#include <stddef.h>
+#include <stdint.h>
+
+/* max32655 + cordio */
+#include <dma.h>
+#include <gpio.h>
+#include <mxc_delay.h>
+#include <mxc_device.h>
+#include <nvic_table.h>
+#include <spi.h>
+#include <wsf_msg.h>
+#include <wsf_os.h>
+#include <wsf_trace.h>
+
+// SPI0 on P0.4 (CS), P0.5 (MOSI) and P0.7 (SCK), D/C and reset pins can be overridden from project.mk
+#define DISPLAY_SPI MXC_SPI0
+#define DISPLAY_SPI_SS_INDEX 0
+
+#ifndef DISPLAY_SPI_FREQUENCY
+#define DISPLAY_SPI_FREQUENCY 8000000
+#endif
+
+#ifndef DISPLAY_SPI_DC_PIN
+#define DISPLAY_SPI_DC_PIN MXC_GPIO_PIN_8
+#endif
+
+#ifndef DISPLAY_SPI_RESET_PIN
+#define DISPLAY_SPI_RESET_PIN MXC_GPIO_PIN_9
+#endif
+
+#define DISPLAY_SPI_GPIO MXC_GPIO0
+
+#define DISPLAY_BUS_SEGMENT_DONE_EVENT 0xE8
+#define DISPLAY_BUS_SEGMENT_DONE_EVENT_MASK 0x0001
+
+static wsfHandlerId_t busHandler;
+static int isConfigured = 0;
+
+static DisplayBus_Transfer *active = NULL;
+static DisplayBus_Transfer *queueHead = NULL;
+
+static mxc_spi_req_t request;
+static volatile int isSegmentDone = 0;
+static volatile int segmentResult = 0;
+
+static void DisplayBus_StartNextTransfer();
+
+// SPI driver calls it from DMA interrupt, rest of transfer continues in WSF handler
+static void DisplayBus_SpiCallback(void *req, int result) {
+    wsfMsgHdr_t *pMsg;
+
+    segmentResult = result;
+    isSegmentDone = 1;
+
+    if ((pMsg = WsfMsgAlloc(sizeof(wsfMsgHdr_t))) != NULL) {
+        pMsg->event = DISPLAY_BUS_SEGMENT_DONE_EVENT;
+        pMsg->param = 0;
+        pMsg->status = 0;
+        WsfMsgSend(busHandler, pMsg);
+    } else {
+        WsfSetEvent(busHandler, DISPLAY_BUS_SEGMENT_DONE_EVENT_MASK);
+    }
+}
+
+void DMA0_IRQHandler() {
+    MXC_DMA_Handler();
+}
+
+void DMA1_IRQHandler() {
+    MXC_DMA_Handler();
+}
+
+// D/C is sampled with last bit of every byte, so it changes only once previous segment has left shift register
+static void DisplayBus_StartSegment() {
+    uint8_t *segment = active->segments[active->currentSegment];
+    unsigned int len = active->lengths[active->currentSegment];
+
+    while (DISPLAY_SPI->stat & MXC_F_SPI_STAT_BUSY) {
+    }
+
+    if (segment[0] == DISPLAY_BUS_CONTROL_DATA) {
+        MXC_GPIO_OutSet(DISPLAY_SPI_GPIO, DISPLAY_SPI_DC_PIN);
+    } else {
+        MXC_GPIO_OutClr(DISPLAY_SPI_GPIO, DISPLAY_SPI_DC_PIN);
+    }
+
+    request.spi = DISPLAY_SPI;
+    request.txData = segment + 1;
+    request.txLen = len - 1;
+    request.rxData = NULL;
+    request.rxLen = 0;
+    request.ssIdx = DISPLAY_SPI_SS_INDEX;
+    request.ssDeassert = 1;
+    request.txCnt = 0;
+    request.rxCnt = 0;
+    request.completeCB = DisplayBus_SpiCallback;
+
+    isSegmentDone = 0;
+
+    int status = MXC_SPI_MasterTransactionDMA(&request);
+    if (status) {
+        TRACE_ERROR(TRACE_MODULE_DISPLAY, status);
+        DisplayBus_SpiCallback(&request, status);
+    }
+}
+
+static void DisplayBus_ProcessSegmentDone() {
+    DisplayBus_Transfer *transfer = active;
+    int result = segmentResult;
+
+    isSegmentDone = 0;
+
+    if (transfer == NULL) {
+        return;
+    }
+
+    if (result == 0 && ++transfer->currentSegment < transfer->segmentsCount) {
+        DisplayBus_StartSegment();
+        return;
+    }
+
+    active = NULL;
+
+    if (transfer->callback) {
+        transfer->callback(transfer, result);
+    }
+
+    DisplayBus_StartNextTransfer();
+}
+
+static void DisplayBus_StartNextTransfer() {
+    if (!isConfigured || active != NULL || queueHead == NULL) {
+        return;
+    }
+
+    active = queueHead;
+    queueHead = active->next;
+    active->next = NULL;
+    active->currentSegment = 0;
+
+    DisplayBus_StartSegment();
+}
+
+static void DisplayBus_Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    if (pMsg != NULL && pMsg->event != DISPLAY_BUS_SEGMENT_DONE_EVENT) {
+        return;
+    }
+
+    if (isSegmentDone) {
+        DisplayBus_ProcessSegmentDone();
+    }
+}
+
+void DisplayBus_Init() {
+    busHandler = Profile_SetNextHandler(DisplayBus_Handler, "DBus");
+}
+
+int DisplayBus_Configure() {
+    int status;
+
+    mxc_gpio_cfg_t pins;
+    pins.port = DISPLAY_SPI_GPIO;
+    pins.mask = DISPLAY_SPI_DC_PIN | DISPLAY_SPI_RESET_PIN;
+    pins.func = MXC_GPIO_FUNC_OUT;
+    pins.pad = MXC_GPIO_PAD_NONE;
+    pins.vssel = MXC_GPIO_VSSEL_VDDIOH;
+
+    status = MXC_GPIO_Config(&pins);
+    if (status) {
+        APP_TRACE_ERR1("DisplayBus_Configure: MXC_GPIO_Config failed=%d", status);
+        return status;
+    }
+
+    // I2C modules reset themselves at power up, SPI ones have reset pin that must be pulsed
+    MXC_GPIO_OutClr(DISPLAY_SPI_GPIO, DISPLAY_SPI_RESET_PIN);
+    MXC_Delay(MXC_DELAY_USEC(10));
+    MXC_GPIO_OutSet(DISPLAY_SPI_GPIO, DISPLAY_SPI_RESET_PIN);
+
+    status = MXC_SPI_Init(DISPLAY_SPI, 1, 0, 1, 0, DISPLAY_SPI_FREQUENCY);
+    if (status) {
+        APP_TRACE_ERR1("DisplayBus_Configure: MXC_SPI_Init failed=%d", status);
+        return status;
+    }
+
+    MXC_SPI_SetDataSize(DISPLAY_SPI, 8);
+    MXC_SPI_SetWidth(DISPLAY_SPI, SPI_WIDTH_STANDARD);
+    MXC_SPI_SetMode(DISPLAY_SPI, SPI_MODE_0);
+
+    status = MXC_DMA_Init();
+    if (status) {
+        APP_TRACE_ERR1("DisplayBus_Configure: MXC_DMA_Init failed=%d", status);
+        return status;
+    }
+
+    NVIC_EnableIRQ(DMA0_IRQn);
+    NVIC_EnableIRQ(DMA1_IRQn);
+
+    isConfigured = 1;
+    DisplayBus_StartNextTransfer();
+
+    return 0;
+}
+
+// urgent transfers go before queued ones, e.g. display off before pending frame
+int DisplayBus_Submit(DisplayBus_Transfer *transfer) {
+    if (transfer->segmentsCount < 1 || transfer->segmentsCount > DISPLAY_BUS_MAX_SEGMENTS) {
+        return E_BAD_PARAM;
+    }
+
+    DisplayBus_Transfer **insertAt = &queueHead;
+    while (*insertAt != NULL && (!transfer->isUrgent || (*insertAt)->isUrgent)) {
+        insertAt = &(*insertAt)->next;
+    }
+
+    transfer->next = *insertAt;
+    *insertAt = transfer;
+
+    DisplayBus_StartNextTransfer();
+
+    return E_NO_ERROR;
+}
+
+// DMA stops in deep sleep
+int DisplayBus_IsBusy() {
+    return active != NULL;
+}
+
+#endif
\ No newline at end of file
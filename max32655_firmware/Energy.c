@@ -0,0 +1,119 @@
+/* self */
+#include "Energy.h"
+
+/* project */
+#include "BLE.h"
+#include "FuelGauge.h"
+#include "I2CBus.h"
+#include "Power.h"
+#include "Profile.h"
+#include "Ws2812b.h"
+
+/* stdlib */
+#include <stdint.h>
+
+/* max32655 + cordio */
+#include <wsf_os.h>
+#include <wsf_timer.h>
+#include <wsf_trace.h>
+
+#define ENERGY_TIMER_TICK_EVENT 0xE8
+#define ENERGY_SAMPLE_PERIOD 10000
+
+#define ENERGY_DISPLAY_I2C MXC_I2C2
+#define ENERGY_FUEL_GAUGE_I2C MXC_I2C1
+
+static wsfTimer_t timer;
+static wsfHandlerId_t timerHandler;
+
+static EnergyModel_Counters lastCounters;
+static int subsystemCurrent[ENERGY_SUBSYSTEM_COUNT];
+static int isDisplayOn = 1;
+
+static void Energy_ReadCounters(EnergyModel_Counters *counters) {
+    I2CBus_Stats stats;
+
+    // window is on the same clock as residency, which counts deep sleep too
+    counters->time = Power_GetTime();
+
+    I2CBus_GetStats(ENERGY_DISPLAY_I2C, &stats);
+    counters->displayBytes = stats.bytesTransferred;
+
+    I2CBus_GetStats(ENERGY_FUEL_GAUGE_I2C, &stats);
+    counters->fuelGaugeBytes = stats.bytesTransferred;
+
+    counters->ledFrames = WS2812B_GetFrameCount();
+    counters->radioEvents = BLE_GetRadioEventCount();
+
+    for (int i = 0; i < POWER_STATE_COUNT; i++) {
+        counters->residency[i] = Power_GetResidency(i);
+    }
+}
+
+static void Energy_Sample() {
+    EnergyModel_Counters now;
+    Energy_ReadCounters(&now);
+
+    if (EnergyModel_GetCurrents(&lastCounters, &now, isDisplayOn, subsystemCurrent)) {
+        lastCounters = now;
+    }
+}
+
+static void Energy_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    if (pMsg == NULL || pMsg->event != ENERGY_TIMER_TICK_EVENT) {
+        return;
+    }
+
+    Energy_Sample();
+
+    uint8_t report[ENERGY_REPORT_LEN];
+    int len = Energy_GetReport(report, sizeof(report));
+    BLE_SetEnergyReport(report, len);
+
+    Profile_TimerStartMs(&timer, ENERGY_SAMPLE_PERIOD);
+}
+
+void Energy_Init() {
+    Energy_ReadCounters(&lastCounters);
+
+    timerHandler = Profile_SetNextHandler(Energy_TimerHandler, "Enr");
+
+    timer.handlerId = timerHandler;
+    timer.msg.event = ENERGY_TIMER_TICK_EVENT;
+    timer.msg.param = 0;
+    timer.msg.status = 0;
+    Profile_TimerStartMs(&timer, ENERGY_SAMPLE_PERIOD);
+}
+
+void Energy_SetDisplayOn(int isOn) {
+    isDisplayOn = isOn;
+}
+
+int Energy_GetSubsystemCurrent(int subsystem) {
+    if (subsystem < 0 || subsystem >= ENERGY_SUBSYSTEM_COUNT) {
+        return 0;
+    }
+    return subsystemCurrent[subsystem];
+}
+
+int Energy_GetTotalCurrent() {
+    return EnergyModel_GetTotalCurrent(subsystemCurrent);
+}
+
+// discharge rate reported by fuel gauge, 0 when charging or unknown
+int Energy_GetMeasuredCurrent() {
+    return EnergyModel_GetMeasuredCurrent(FuelGauge_GetChargeRate());
+}
+
+// minutes, estimate is used until fuel gauge measures discharge
+int Energy_GetRemainingRuntime() {
+    int current = Energy_GetMeasuredCurrent();
+    if (current == 0) {
+        current = Energy_GetTotalCurrent();
+    }
+    return EnergyModel_GetRemainingRuntime(current, FuelGauge_GetBatteryStatus(), FuelGauge_IsCharging());
+}
+
+int Energy_GetReport(uint8_t *report, int maxLen) {
+    return EnergyModel_GetReport(subsystemCurrent, Energy_GetMeasuredCurrent(), Energy_GetRemainingRuntime(), report, maxLen);
+}
\ No newline at end of file
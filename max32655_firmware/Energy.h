@@ -0,0 +1,16 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include "EnergyModel.h"
+
+#include <stdint.h>
+
+void Energy_Init();
+void Energy_SetDisplayOn(int isOn);
+int Energy_GetSubsystemCurrent(int subsystem);
+int Energy_GetTotalCurrent();
+int Energy_GetMeasuredCurrent();
+int Energy_GetRemainingRuntime();
+int Energy_GetReport(uint8_t *report, int maxLen);
+
+#endif
\ No newline at end of file
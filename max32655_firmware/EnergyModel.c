@@ -0,0 +1,100 @@
+/* self */
+#include "EnergyModel.h"
+
+/* project */
+#include "Power.h"
+
+/* stdlib */
+#include <stdint.h>
+
+// charge in nC spread over window in ms gives average current in uA
+static int EnergyModel_ChargeToCurrent(uint64_t chargeNc, uint32_t windowMs) {
+    return (int)(chargeNc / windowMs);
+}
+
+// returns 0 and leaves currents as they were when window is too short to tell
+int EnergyModel_GetCurrents(const EnergyModel_Counters *last, const EnergyModel_Counters *now, int isDisplayOn, int *subsystemCurrent) {
+    uint32_t windowTicks = now->time - last->time;
+    uint32_t windowMs = (uint32_t)((uint64_t)windowTicks * 1000 / POWER_TICK_PER_SEC);
+    if (windowMs == 0) {
+        return 0;
+    }
+
+    uint64_t displayCharge = (uint64_t)(now->displayBytes - last->displayBytes) * ENERGY_I2C_BYTE_NC;
+    subsystemCurrent[ENERGY_SUBSYSTEM_DISPLAY] = EnergyModel_ChargeToCurrent(displayCharge, windowMs) + (isDisplayOn ? ENERGY_DISPLAY_PANEL_UA : 0);
+
+    uint64_t fuelGaugeCharge = (uint64_t)(now->fuelGaugeBytes - last->fuelGaugeBytes) * ENERGY_I2C_BYTE_NC;
+    subsystemCurrent[ENERGY_SUBSYSTEM_FUEL_GAUGE] = EnergyModel_ChargeToCurrent(fuelGaugeCharge, windowMs);
+
+    uint64_t ledCharge = (uint64_t)(now->ledFrames - last->ledFrames) * ENERGY_LED_FRAME_NC;
+    subsystemCurrent[ENERGY_SUBSYSTEM_LED] = EnergyModel_ChargeToCurrent(ledCharge, windowMs);
+
+    uint64_t radioCharge = (uint64_t)(now->radioEvents - last->radioEvents) * ENERGY_RADIO_EVENT_NC;
+    subsystemCurrent[ENERGY_SUBSYSTEM_RADIO] = EnergyModel_ChargeToCurrent(radioCharge, windowMs);
+
+    static const int stateCurrent[POWER_STATE_COUNT] = {
+        [POWER_STATE_ACTIVE] = ENERGY_CPU_ACTIVE_UA,
+        [POWER_STATE_SLEEP] = ENERGY_CPU_SLEEP_UA,
+        [POWER_STATE_DEEPSLEEP] = ENERGY_CPU_DEEPSLEEP_UA,
+    };
+
+    uint64_t cpuCurrentTicks = 0;
+    for (int i = 0; i < POWER_STATE_COUNT; i++) {
+        cpuCurrentTicks += (uint64_t)(now->residency[i] - last->residency[i]) * stateCurrent[i];
+    }
+    subsystemCurrent[ENERGY_SUBSYSTEM_CPU] = (int)(cpuCurrentTicks / windowTicks);
+
+    return 1;
+}
+
+int EnergyModel_GetTotalCurrent(const int *subsystemCurrent) {
+    int total = 0;
+    for (int i = 0; i < ENERGY_SUBSYSTEM_COUNT; i++) {
+        total += subsystemCurrent[i];
+    }
+    return total;
+}
+
+// discharge rate reported by fuel gauge in 0.001 %/h, 0 when charging or unknown
+int EnergyModel_GetMeasuredCurrent(int chargeRate) {
+    if (chargeRate >= 0) {
+        return 0;
+    }
+
+    // 1 %/h of capacity in mAh is 10 * capacity uA
+    return (int)((int64_t)-chargeRate * ENERGY_BATTERY_CAPACITY_MAH * 10 / 1000);
+}
+
+// minutes
+int EnergyModel_GetRemainingRuntime(int current, int batteryPercent, int isCharging) {
+    if (current == 0 || isCharging) {
+        return 0;
+    }
+
+    // remaining capacity in uAh = percent * capacity mAh * 10
+    uint64_t remainingUah = (uint64_t)batteryPercent * ENERGY_BATTERY_CAPACITY_MAH * 10;
+    return (int)(remainingUah * 60 / current);
+}
+
+int EnergyModel_GetReport(const int *subsystemCurrent, int measuredCurrent, int remainingRuntime, uint8_t *report, int maxLen) {
+    if (maxLen < ENERGY_REPORT_LEN) {
+        return 0;
+    }
+
+    uint16_t values[ENERGY_REPORT_LEN / 2];
+    for (int i = 0; i < ENERGY_SUBSYSTEM_COUNT; i++) {
+        values[i] = subsystemCurrent[i] > UINT16_MAX ? UINT16_MAX : subsystemCurrent[i];
+    }
+
+    int total = EnergyModel_GetTotalCurrent(subsystemCurrent);
+    values[ENERGY_SUBSYSTEM_COUNT + 0] = total > UINT16_MAX ? UINT16_MAX : total;
+    values[ENERGY_SUBSYSTEM_COUNT + 1] = measuredCurrent > UINT16_MAX ? UINT16_MAX : measuredCurrent;
+    values[ENERGY_SUBSYSTEM_COUNT + 2] = remainingRuntime > UINT16_MAX ? UINT16_MAX : remainingRuntime;
+
+    for (int i = 0; i < ENERGY_REPORT_LEN / 2; i++) {
+        report[i * 2 + 0] = values[i] & 0xFF;
+        report[i * 2 + 1] = values[i] >> 8;
+    }
+
+    return ENERGY_REPORT_LEN;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include "Power.h"
+
+#include <stdint.h>
+
+// Current model turning activity counters into per-subsystem current. Needs no SDK, so the host simulator
+// compiles this same unit while Energy.c samples the counters on device.
+
+// current model, all values can be overridden from project.mk
+#ifndef ENERGY_BATTERY_CAPACITY_MAH
+#define ENERGY_BATTERY_CAPACITY_MAH 400
+#endif
+
+#ifndef ENERGY_CPU_ACTIVE_UA
+#define ENERGY_CPU_ACTIVE_UA 2600
+#endif
+
+#ifndef ENERGY_CPU_SLEEP_UA
+#define ENERGY_CPU_SLEEP_UA 900
+#endif
+
+#ifndef ENERGY_CPU_DEEPSLEEP_UA
+#define ENERGY_CPU_DEEPSLEEP_UA 30
+#endif
+
+#ifndef ENERGY_DISPLAY_PANEL_UA
+#define ENERGY_DISPLAY_PANEL_UA 4000
+#endif
+
+#ifndef ENERGY_I2C_BYTE_NC
+#define ENERGY_I2C_BYTE_NC 60
+#endif
+
+#ifndef ENERGY_LED_FRAME_NC
+#define ENERGY_LED_FRAME_NC 2500
+#endif
+
+#ifndef ENERGY_RADIO_EVENT_NC
+#define ENERGY_RADIO_EVENT_NC 6000
+#endif
+
+#define ENERGY_REPORT_LEN 16
+
+enum {
+    ENERGY_SUBSYSTEM_DISPLAY,
+    ENERGY_SUBSYSTEM_FUEL_GAUGE,
+    ENERGY_SUBSYSTEM_LED,
+    ENERGY_SUBSYSTEM_RADIO,
+    ENERGY_SUBSYSTEM_CPU,
+    ENERGY_SUBSYSTEM_COUNT
+};
+
+// counters only grow, currents are computed from difference of two samples, time and residency are on WUT ticks
+typedef struct {
+    uint32_t time;
+    uint32_t displayBytes;
+    uint32_t fuelGaugeBytes;
+    uint32_t ledFrames;
+    uint32_t radioEvents;
+    uint32_t residency[POWER_STATE_COUNT];
+} EnergyModel_Counters;
+
+int EnergyModel_GetCurrents(const EnergyModel_Counters *last, const EnergyModel_Counters *now, int isDisplayOn, int *subsystemCurrent);
+int EnergyModel_GetTotalCurrent(const int *subsystemCurrent);
+int EnergyModel_GetMeasuredCurrent(int chargeRate);
+int EnergyModel_GetRemainingRuntime(int current, int batteryPercent, int isCharging);
+int EnergyModel_GetReport(const int *subsystemCurrent, int measuredCurrent, int remainingRuntime, uint8_t *report, int maxLen);
+
+#endif
\ No newline at end of file
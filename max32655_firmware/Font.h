@@ -0,0 +1,18 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+// Glyph tables are generated by tools/font_compile from fonts/*.font. Glyph of width w in font of height h pages
+// is stored as h rows of w bytes, so it is drawn by one rectangle copy. Glyph of character c starts at column
+// offsets[c - first] and is followed by spacing blank columns, characters without glyph have zero width.
+typedef struct {
+    uint8_t height;
+    uint8_t spacing;
+    uint8_t first;
+    uint8_t last;
+    const uint16_t *offsets;
+    const uint8_t *glyphs;
+} Font;
+
+#endif
\ No newline at end of file
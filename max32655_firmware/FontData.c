@@ -0,0 +1,99 @@
+// Generated by tools/font_compile from fonts/*.font, do not edit.
+
+/* self */
+#include "FontData.h"
+
+/* stdlib */
+#include <stdint.h>
+
+// fonts/small.font
+static const uint8_t Font_SmallGlyphs[] = {
+    0x00, 0x13, 0x0b, 0x04, 0x1a, 0x19, 0x02, 0x04, 0x08, 0x04, 0x02, 0x10, 0x0e, 0x11, 0x11, 0x0e,
+    0x12, 0x1f, 0x10, 0x12, 0x19, 0x15, 0x12, 0x11, 0x15, 0x15, 0x0a, 0x0c, 0x0a, 0x09, 0x1f, 0x17,
+    0x15, 0x15, 0x0d, 0x0e, 0x15, 0x15, 0x08, 0x01, 0x01, 0x1d, 0x03, 0x0a, 0x15, 0x15, 0x0a, 0x02,
+    0x15, 0x15, 0x0e, 0x0a, 0x1e, 0x05, 0x05, 0x1e, 0x1f, 0x15, 0x15, 0x0a, 0x0e, 0x11, 0x11, 0x11,
+    0x1f, 0x11, 0x11, 0x0e, 0x1f, 0x15, 0x15, 0x1f, 0x05, 0x05, 0x0e, 0x11, 0x15, 0x1d, 0x1f, 0x04,
+    0x04, 0x1f, 0x1f, 0x08, 0x10, 0x10, 0x0f, 0x1f, 0x04, 0x0a, 0x11, 0x1f, 0x10, 0x10, 0x1f, 0x02,
+    0x04, 0x02, 0x1f, 0x1f, 0x02, 0x04, 0x1f, 0x0e, 0x11, 0x11, 0x0e, 0x1f, 0x05, 0x05, 0x02, 0x0e,
+    0x11, 0x09, 0x16, 0x1f, 0x05, 0x0d, 0x12, 0x12, 0x15, 0x15, 0x09, 0x01, 0x01, 0x1f, 0x01, 0x01,
+    0x0f, 0x10, 0x10, 0x0f, 0x03, 0x0c, 0x10, 0x0c, 0x03, 0x07, 0x18, 0x07, 0x18, 0x07, 0x1b, 0x04,
+    0x04, 0x1b, 0x17, 0x14, 0x14, 0x0f, 0x19, 0x15, 0x15, 0x13,
+};
+
+static const uint16_t Font_SmallOffsets[] = {
+    0, 1, 1, 1, 1, 1, 6, 6, 6, 6, 6, 11, 11, 11, 11, 12,
+    12, 16, 19, 23, 27, 31, 35, 39, 43, 47, 51, 52, 52, 52, 52, 52,
+    52, 52, 56, 60, 64, 68, 71, 74, 78, 82, 83, 87, 91, 94, 99, 103,
+    107, 111, 115, 119, 123, 128, 132, 137, 142, 146, 150, 154,
+};
+
+const Font Font_Small = {
+    .height = 1,
+    .spacing = 1,
+    .first = 32,
+    .last = 90,
+    .offsets = Font_SmallOffsets,
+    .glyphs = Font_SmallGlyphs,
+};
+
+// fonts/digits16.font
+static const uint8_t Font_Digits16Glyphs[] = {
+    0x00, 0x00, 0x60, 0x60, 0xfc, 0xfe, 0x06, 0x06, 0x06, 0xfe, 0xfc, 0x3f, 0x7f, 0x60, 0x60, 0x60,
+    0x7f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfc, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f,
+    0x00, 0x86, 0x86, 0x86, 0x86, 0xfe, 0xfc, 0x3e, 0x7f, 0x61, 0x61, 0x61, 0x61, 0x01, 0x00, 0x86,
+    0x86, 0x86, 0x86, 0xfe, 0xfc, 0x00, 0x61, 0x61, 0x61, 0x61, 0x7f, 0x3f, 0xfc, 0xfc, 0x80, 0x80,
+    0x80, 0xfc, 0xfc, 0x01, 0x01, 0x01, 0x01, 0x01, 0x3f, 0x3f, 0xfc, 0xfe, 0x86, 0x86, 0x86, 0x86,
+    0x00, 0x01, 0x61, 0x61, 0x61, 0x61, 0x7f, 0x3e, 0xfc, 0xfe, 0x86, 0x86, 0x86, 0x86, 0x00, 0x3f,
+    0x7f, 0x61, 0x61, 0x61, 0x7f, 0x3e, 0x00, 0x06, 0x06, 0x06, 0x06, 0xfe, 0xfc, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x3f, 0x3f, 0xfc, 0xfe, 0x86, 0x86, 0x86, 0xfe, 0xfc, 0x3f, 0x7f, 0x61, 0x61, 0x61,
+    0x7f, 0x3f, 0xfc, 0xfe, 0x86, 0x86, 0x86, 0xfe, 0xfc, 0x01, 0x61, 0x61, 0x61, 0x61, 0x7f, 0x3f,
+    0x60, 0x60, 0x06, 0x06,
+};
+
+static const uint16_t Font_Digits16Offsets[] = {
+    0, 2, 2, 9, 16, 23, 30, 37, 44, 51, 58, 65, 72, 74,
+};
+
+const Font Font_Digits16 = {
+    .height = 2,
+    .spacing = 1,
+    .first = 46,
+    .last = 58,
+    .offsets = Font_Digits16Offsets,
+    .glyphs = Font_Digits16Glyphs,
+};
+
+// fonts/digits24.font
+static const uint8_t Font_Digits24Glyphs[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x70, 0x70, 0xfc, 0xfe, 0xfe, 0x0e, 0x0e, 0x0e, 0xfe,
+    0xfe, 0xfc, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x3f, 0x7f, 0x7f, 0x70, 0x70,
+    0x70, 0x7f, 0x7f, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfc, 0xfc, 0xfc, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x3f, 0x00,
+    0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0xfe, 0xfe, 0xfc, 0xf0, 0xfc, 0xfc, 0x1c, 0x1c, 0x1c, 0x1f, 0x1f,
+    0x0f, 0x3f, 0x7f, 0x7f, 0x70, 0x70, 0x70, 0x70, 0x70, 0x00, 0x00, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e,
+    0xfe, 0xfe, 0xfc, 0x00, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0xff, 0xff, 0xff, 0x00, 0x70, 0x70, 0x70,
+    0x70, 0x70, 0x7f, 0x7f, 0x3f, 0xfc, 0xfc, 0xfc, 0x00, 0x00, 0x00, 0xfc, 0xfc, 0xfc, 0x0f, 0x1f,
+    0x1f, 0x1c, 0x1c, 0x1c, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f, 0x3f,
+    0xfc, 0xfe, 0xfe, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x00, 0x0f, 0x1f, 0x1f, 0x1c, 0x1c, 0x1c, 0xfc,
+    0xfc, 0xf0, 0x00, 0x70, 0x70, 0x70, 0x70, 0x70, 0x7f, 0x7f, 0x3f, 0xfc, 0xfe, 0xfe, 0x0e, 0x0e,
+    0x0e, 0x0e, 0x0e, 0x00, 0xff, 0xff, 0xff, 0x1c, 0x1c, 0x1c, 0xfc, 0xfc, 0xf0, 0x3f, 0x7f, 0x7f,
+    0x70, 0x70, 0x70, 0x7f, 0x7f, 0x3f, 0x00, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0xfe, 0xfe, 0xfc, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x3f,
+    0x3f, 0xfc, 0xfe, 0xfe, 0x0e, 0x0e, 0x0e, 0xfe, 0xfe, 0xfc, 0xff, 0xff, 0xff, 0x1c, 0x1c, 0x1c,
+    0xff, 0xff, 0xff, 0x3f, 0x7f, 0x7f, 0x70, 0x70, 0x70, 0x7f, 0x7f, 0x3f, 0xfc, 0xfe, 0xfe, 0x0e,
+    0x0e, 0x0e, 0xfe, 0xfe, 0xfc, 0x0f, 0x1f, 0x1f, 0x1c, 0x1c, 0x1c, 0xff, 0xff, 0xff, 0x00, 0x70,
+    0x70, 0x70, 0x70, 0x70, 0x7f, 0x7f, 0x3f, 0x80, 0x80, 0x80, 0xc3, 0xc3, 0xc3, 0x01, 0x01, 0x01,
+};
+
+static const uint16_t Font_Digits24Offsets[] = {
+    0, 3, 3, 12, 21, 30, 39, 48, 57, 66, 75, 84, 93, 96,
+};
+
+const Font Font_Digits24 = {
+    .height = 3,
+    .spacing = 1,
+    .first = 46,
+    .last = 58,
+    .offsets = Font_Digits24Offsets,
+    .glyphs = Font_Digits24Glyphs,
+};
@@ -0,0 +1,12 @@
+// Generated by tools/font_compile from fonts/*.font, do not edit.
+
+#ifndef FONT_DATA_H
+#define FONT_DATA_H
+
+#include "Font.h"
+
+extern const Font Font_Small;
+extern const Font Font_Digits16;
+extern const Font Font_Digits24;
+
+#endif
@@ -1,6 +1,11 @@
 /* self */
 #include "FuelGauge.h"
 
+/* project */
+#include "I2CBus.h"
+#include "Profile.h"
+#include "Trace.h"
+
 /* max32655 + cordio */
 #include <i2c.h>
 #include <wsf_timer.h>
@@ -19,30 +24,64 @@ static wsfTimer_t timer;
 static wsfHandlerId_t timerHandler;
 static int bateryStatus = 0;
 static int isCharging = 0;
+static int isBusConfigured = 0;
+static int chargeRate = 0;
 
 static uint8_t socRegAddr = 0x04;
 static uint8_t socValue[2];
 
+static uint8_t chargeRateRegAddr = 0x16;
+static uint8_t chargeRateValue[2];
+
 static uint8_t chargerStatusRegAddr = 0x06;
 static uint8_t chargerStatusValue;
 
-static mxc_i2c_req_t i2cReq;
+static mxc_i2c_req_t batteryLevelSegments[1];
+static I2CBus_Transaction batteryLevelTransaction;
+
+static mxc_i2c_req_t chargeRateSegments[1];
+static I2CBus_Transaction chargeRateTransaction;
+
+static mxc_i2c_req_t chargerStatusSegments[1];
+static I2CBus_Transaction chargerStatusTransaction;
 
 static int operationCounter = 0;
 
 static void FuelGauge_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg);
+static void FueldGauge_BatteryLevelCompletionCallback(I2CBus_Transaction *transaction, int result);
+static void FueldGauge_ChargeRateCompletionCallback(I2CBus_Transaction *transaction, int result);
+static void FueldGauge_ChargerStatusCompletionCallback(I2CBus_Transaction *transaction, int result);
+
+static void FuelGauge_InitReadTransaction(I2CBus_Transaction *transaction, mxc_i2c_req_t *segment, uint8_t addr, uint8_t *regAddr, uint8_t *value, unsigned int valueLen, I2CBus_CompletionCallback callback) {
+    segment->i2c = FUEL_GAUGE_I2C;
+    segment->addr = addr;
+    segment->restart = 0;
+    segment->tx_buf = regAddr;
+    segment->tx_len = 1;
+    segment->rx_buf = value;
+    segment->rx_len = valueLen;
+
+    transaction->segments = segment;
+    transaction->segmentsCount = 1;
+    transaction->priority = I2C_BUS_PRIORITY_LOW;
+    transaction->callback = callback;
+}
 
 void FuelGauge_Init() {
-    timerHandler = WsfOsSetNextHandler(FuelGauge_TimerHandler);
+    FuelGauge_InitReadTransaction(&batteryLevelTransaction, &batteryLevelSegments[0], FUEL_GAUGE_MAX17048_ADDR, &socRegAddr, socValue, sizeof(socValue), FueldGauge_BatteryLevelCompletionCallback);
+    FuelGauge_InitReadTransaction(&chargeRateTransaction, &chargeRateSegments[0], FUEL_GAUGE_MAX17048_ADDR, &chargeRateRegAddr, chargeRateValue, sizeof(chargeRateValue), FueldGauge_ChargeRateCompletionCallback);
+    FuelGauge_InitReadTransaction(&chargerStatusTransaction, &chargerStatusSegments[0], FUEL_GAUGE_MAX20303_ADDR, &chargerStatusRegAddr, &chargerStatusValue, sizeof(chargerStatusValue), FueldGauge_ChargerStatusCompletionCallback);
+
+    timerHandler = Profile_SetNextHandler(FuelGauge_TimerHandler, "FG");
 
     timer.handlerId = timerHandler;
     timer.msg.event = FUEL_GAUGE_TIMER_TICK_EVENT;
     timer.msg.param = 0;
     timer.msg.status = 0;
-    WsfTimerStartMs(&timer, 300);
+    Profile_TimerStartMs(&timer, 300);
 }
 
-void FueldGauge_BatteryLevelCompletionCallback(mxc_i2c_req_t *req, int result) {
+static void FueldGauge_BatteryLevelCompletionCallback(I2CBus_Transaction *transaction, int result) {
     if (result == 0) {
         uint16_t first_byte = socValue[0];
         uint16_t second_byte = socValue[1];
@@ -51,45 +90,38 @@ void FueldGauge_BatteryLevelCompletionCallback(mxc_i2c_req_t *req, int result) {
         bateryStatus = val / 256;
         // APP_TRACE_INFO2("Fuel Gauge SOC reading completed. Value: %d. Percent: %d", val, bateryStatus);
     } else {
-        APP_TRACE_ERR0("Fuel Gauge SOC reading failed");
+        TRACE_ERROR(TRACE_MODULE_FUEL_GAUGE, result);
         bateryStatus = 0;
+        isBusConfigured = 0;
     }
 }
 
-void FueldGauge_ChargerStatusCompletionCallback(mxc_i2c_req_t *req, int result) {
+static void FueldGauge_ChargeRateCompletionCallback(I2CBus_Transaction *transaction, int result) {
+    if (result == 0) {
+        int16_t val = (int16_t)((chargeRateValue[0] << 8) | chargeRateValue[1]);
+
+        // CRATE LSB is 0.208 %/h
+        chargeRate = val * 208;
+    } else {
+        TRACE_ERROR(TRACE_MODULE_FUEL_GAUGE, result);
+        chargeRate = 0;
+        isBusConfigured = 0;
+    }
+}
+
+static void FueldGauge_ChargerStatusCompletionCallback(I2CBus_Transaction *transaction, int result) {
     if (result == 0) {
         uint8_t val = chargerStatusValue & 0x7;
         isCharging = (val >= 2) && (val <= 6);
 
         // APP_TRACE_INFO2("PMIC Charger Status reading completed. Register value: %d. Is charging: %d", chargerStatusValue, isCharging);
     } else {
-        APP_TRACE_ERR0("PMIC Charger Status reading failed");
+        TRACE_ERROR(TRACE_MODULE_FUEL_GAUGE, result);
         isCharging = 0;
+        isBusConfigured = 0;
     }
 }
 
-static void FuelGauge_ReadBatteryLevel() {
-    i2cReq.i2c = FUEL_GAUGE_I2C;
-    i2cReq.addr = FUEL_GAUGE_MAX17048_ADDR;
-    i2cReq.callback = FueldGauge_BatteryLevelCompletionCallback;
-    i2cReq.restart = 0;
-    i2cReq.tx_buf = &socRegAddr;
-    i2cReq.tx_len = sizeof(socRegAddr);
-    i2cReq.rx_buf = socValue;
-    i2cReq.rx_len = sizeof(socValue);
-}
-
-static void FuelGauge_ReadChargerStatus() {
-    i2cReq.i2c = FUEL_GAUGE_I2C;
-    i2cReq.addr = FUEL_GAUGE_MAX20303_ADDR;
-    i2cReq.callback = FueldGauge_ChargerStatusCompletionCallback;
-    i2cReq.restart = 0;
-    i2cReq.tx_buf = &chargerStatusRegAddr;
-    i2cReq.tx_len = sizeof(socRegAddr);
-    i2cReq.rx_buf = &chargerStatusValue;
-    i2cReq.rx_len = sizeof(socValue);
-}
-
 static void FuelGauge_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
     int status;
 
@@ -97,39 +129,30 @@ static void FuelGauge_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
         return;
     }
 
-    status = MXC_I2C_Init(FUEL_GAUGE_I2C, 1, 0);
-    if (status) {
-        APP_TRACE_ERR1("Fuel Gauge Initialization failed. MXC_I2C_Init failed with status code %d", status);
-        WsfTimerStartMs(&timer, FUEL_GAUGE_TIMER_DELAY);
-        return;
-    }
+    Profile_TimerStartMs(&timer, FUEL_GAUGE_TIMER_DELAY);
 
-    status = MXC_I2C_SetFrequency(FUEL_GAUGE_I2C, 100000);
-    if (status < 0) {
-        APP_TRACE_ERR1("Fuel Gauge Initialization failed. MXC_I2C_SetFrequency failed with status code %d", status);
-        WsfTimerStartMs(&timer, FUEL_GAUGE_TIMER_DELAY);
-        return;
+    if (!isBusConfigured) {
+        status = I2CBus_ConfigureBus(FUEL_GAUGE_I2C, 100000, FUEL_GAUGE_I2C_I2C_IRQn);
+        if (status) {
+            TRACE_ERROR(TRACE_MODULE_FUEL_GAUGE, status);
+            return;
+        }
+        isBusConfigured = 1;
     }
 
-    NVIC_SetPriority(FUEL_GAUGE_I2C_I2C_IRQn, 3);
-    NVIC_ClearPendingIRQ(FUEL_GAUGE_I2C_I2C_IRQn);
-    NVIC_EnableIRQ(FUEL_GAUGE_I2C_I2C_IRQn);
-
     if (operationCounter++ == 3) {
-        FuelGauge_ReadBatteryLevel();
+        status = I2CBus_Submit(&batteryLevelTransaction);
+        if (status == 0) {
+            status = I2CBus_Submit(&chargeRateTransaction);
+        }
         operationCounter = 0;
     } else {
-        FuelGauge_ReadChargerStatus();
+        status = I2CBus_Submit(&chargerStatusTransaction);
     }
 
-    status = MXC_I2C_MasterTransactionAsync(&i2cReq);
     if (status) {
-        WsfTimerStartMs(&timer, FUEL_GAUGE_TIMER_DELAY);
-        APP_TRACE_ERR1("Fuel Gauge Initialization failed. MXC_I2C_MasterTransactionAsync failed with status code %d", status);
-        return;
+        TRACE_ERROR(TRACE_MODULE_FUEL_GAUGE, status);
     }
-
-    WsfTimerStartMs(&timer, FUEL_GAUGE_TIMER_DELAY);
 }
 
 int FuelGauge_GetBatteryStatus() {
@@ -138,4 +161,8 @@ int FuelGauge_GetBatteryStatus() {
 
 int FuelGauge_IsCharging() {
     return isCharging;
+}
+
+int FuelGauge_GetChargeRate() {
+    return chargeRate;
 }
\ No newline at end of file
@@ -4,5 +4,6 @@
 void FuelGauge_Init();
 int FuelGauge_GetBatteryStatus();
 int FuelGauge_IsCharging();
+int FuelGauge_GetChargeRate();
 
 #endif
\ No newline at end of file
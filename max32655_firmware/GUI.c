@@ -5,8 +5,15 @@
 #include "BLE.h"
 #include "Button.h"
 #include "Display.h"
+#include "Energy.h"
+#include "FontData.h"
 #include "FuelGauge.h"
+#include "LapStats.h"
+#include "Power.h"
+#include "Profile.h"
 #include "Time.h"
+#include "Trace.h"
+#include "Widget.h"
 #include "Ws2812b.h"
 
 /* sdtlib */
@@ -23,6 +30,11 @@
 #include <wut.h>
 
 #define GUI_TIMER_TICK_EVENT 0xfb
+#define GUI_TIMER_ACTIVE_PERIOD 50
+#define GUI_TIMER_IDLE_PERIOD 1000
+
+#define GUI_SCHEDULED_START_EVENT_MASK 0x0001
+#define GUI_SHUTDOWN_DELAY_TICKS 64000
 
 static wsfTimer_t guiTimer;
 static wsfHandlerId_t guiTimerHandler;
@@ -72,10 +84,15 @@ static const uint8_t closeIcon[] = {
 #define GUI_STATUS_POS (sizeof(menuIcon) + 2)
 #define GUI_BAT_POS (DISPLAY_WIDTH - sizeof(batIcon))
 #define GUI_BLE_POS (DISPLAY_WIDTH - sizeof(batIcon) - sizeof(bleIcon) - 4)
+#define GUI_BUTTON_WIDTH ((DISPLAY_WIDTH - 2) / 2)
+#define GUI_CONTENT_LINES (DISPLAY_LINES - 2)
 
 #define GUI_LED_BRIGHTNESS 3
 
 #define LAPS_MAX 256
+#define GUI_STATS_ITEMS 7
+#define GUI_LAP_LIST_ROWS GUI_CONTENT_LINES
+#define GUI_LAP_LIST_CACHE_ROWS (GUI_LAP_LIST_ROWS + 4)
 
 static void GUI_RenderScreen();
 static void GUI_StartClick(uint32_t pressTime);
@@ -88,14 +105,29 @@ static void GUI_SetReadyModeButtons();
 static void GUI_SetRunModeButtons();
 static void GUI_Menu_TurnOffClick();
 static void GUI_Menu_BluetoothClick();
+static void GUI_Menu_BroadcastClick();
+static void GUI_Menu_StatsClick();
+static void GUI_StatsCloseClick(uint32_t pressTime);
+static void GUI_StatsLeftClick(uint32_t pressTime);
+static void GUI_Menu_LapListClick();
+static void GUI_InvalidateLapList();
+static void GUI_InitWidgets();
+static void GUI_LapListCloseClick(uint32_t pressTime);
+static void GUI_LapListUpClick(uint32_t pressTime);
+static void GUI_LapListDownClick(uint32_t pressTime);
 
 static int isBleConnected = 0;
+static int bleConnectionsCount = 0;
 static int isBleAdvertisign = 0;
 static char *mainPageStatusString = "ready";
 static char *mainPageButtonText[BUTTON_COUNT];
 static void (*mainPageButtonHandlers[BUTTON_COUNT])(uint32_t pressTime);
 static char *menuButtonText[BUTTON_COUNT];
 static void (*menuButtonHandlers[BUTTON_COUNT])(uint32_t pressTime);
+static char *statsButtonText[BUTTON_COUNT];
+static void (*statsButtonHandlers[BUTTON_COUNT])(uint32_t pressTime);
+static char *lapListButtonText[BUTTON_COUNT];
+static void (*lapListButtonHandlers[BUTTON_COUNT])(uint32_t pressTime);
 
 static uint32_t stopwatchStartTime = 0;
 static uint32_t stopwatchStopTime = 0;
@@ -103,15 +135,44 @@ static int isStopwatchRunning = 0;
 static uint32_t totalTime = 0;
 static uint32_t lapOffsets[LAPS_MAX];
 static int lapCount = 0;
+static int isStartScheduled = 0;
+static uint32_t scheduledStartTime = 0;
 static char lapNomainPageStatusString[16];
 
 static uint32_t animationCounter = 0;
 
+static Widget menuIconWidget;
+static Widget statusWidget;
+static Widget bleWidget;
+static Widget batteryWidget;
+static Widget lineWidgets[GUI_CONTENT_LINES];
+static Widget leftButtonWidget;
+static Widget rightButtonWidget;
+
+// status bar, content lines and buttons, filled by GUI_InitWidgets as number of lines depends on panel
+static Widget *screenWidgets[4 + GUI_CONTENT_LINES + 2];
+
+static char bleMenuLabel[16] = {'\0'};
 static char batteryLevelMenuLabel[16] = {'\0'};
+static char sleepMenuLabel[16] = {'\0'};
+static char currentMenuLabel[16] = {'\0'};
+static char runtimeMenuLabel[16] = {'\0'};
+static char droppedMenuLabel[16] = {'\0'};
 
 static int isMenuOpen = 0;
 static int menuScroll = 0;
 static int menuSelectedItem = 0;
+static int isStatsOpen = 0;
+static int statsScroll = 0;
+static int isLapListOpen = 0;
+static int lapListScroll = 0;
+static int isLapListFollowing = 1;
+
+// rendered rows by lap index, laps never change once added, so rows are drawn once and copied while scrolling
+static struct GUI_LapListRow {
+    int lapIndex;
+    uint8_t pixels[DISPLAY_WIDTH];
+} lapListCache[GUI_LAP_LIST_CACHE_ROWS];
 static struct {
     char *itemName;
     char *itemValue;
@@ -124,12 +185,54 @@ static struct {
         .actionLabel = "change",
         .clickHandler = GUI_Menu_BluetoothClick,
     },
+    {
+        .itemName = "Broadcast",
+        .itemValue = "off",
+        .actionLabel = "change",
+        .clickHandler = GUI_Menu_BroadcastClick,
+    },
+    {
+        .itemName = "Lap stats",
+        .itemValue = "",
+        .actionLabel = "show",
+        .clickHandler = GUI_Menu_StatsClick,
+    },
+    {
+        .itemName = "Lap list",
+        .itemValue = "",
+        .actionLabel = "show",
+        .clickHandler = GUI_Menu_LapListClick,
+    },
     {
         .itemName = "Battery",
         .itemValue = batteryLevelMenuLabel,
         .actionLabel = "",
         .clickHandler = NULL,
     },
+    {
+        .itemName = "Sleep",
+        .itemValue = sleepMenuLabel,
+        .actionLabel = "",
+        .clickHandler = NULL,
+    },
+    {
+        .itemName = "Current",
+        .itemValue = currentMenuLabel,
+        .actionLabel = "",
+        .clickHandler = NULL,
+    },
+    {
+        .itemName = "Runtime",
+        .itemValue = runtimeMenuLabel,
+        .actionLabel = "",
+        .clickHandler = NULL,
+    },
+    {
+        .itemName = "Dropped",
+        .itemValue = droppedMenuLabel,
+        .actionLabel = "",
+        .clickHandler = NULL,
+    },
     {
         .itemName = "FW ver",
         .itemValue = "1.0",
@@ -144,7 +247,29 @@ static struct {
     },
 };
 
+static void GUI_RestartTimer() {
+    // 50 ms tick is only needed while something on screen or LED changes by itself
+    int isAnimating = isStopwatchRunning || isMenuOpen || (isBleAdvertisign && !isBleConnected) || FuelGauge_IsCharging();
+
+    Profile_TimerStartMs(&guiTimer, isAnimating ? GUI_TIMER_ACTIVE_PERIOD : GUI_TIMER_IDLE_PERIOD);
+}
+
+static void GUI_StartScheduled() {
+    if (!isStartScheduled) {
+        return;
+    }
+
+    // start time is the scheduled tick, not the moment this handler runs
+    isStartScheduled = 0;
+    GUI_StartClick(scheduledStartTime);
+}
+
 static void GUI_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    if (pMsg == NULL && (event & GUI_SCHEDULED_START_EVENT_MASK)) {
+        GUI_StartScheduled();
+        return;
+    }
+
     if (pMsg == NULL || pMsg->event != GUI_TIMER_TICK_EVENT) {
         return;
     }
@@ -153,17 +278,24 @@ static void GUI_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
 
     int isAnimationRenderNeeded = ((!isBleConnected && isBleAdvertisign) || FuelGauge_IsCharging()) && (animationCounter % 5 == 0);
 
+    // rendered when display has sent previous frame, so time on screen is current when it is sent
     if (isStopwatchRunning || isAnimationRenderNeeded || isMenuOpen) {
-        GUI_RenderScreen();
-    }
-
-    if (isStopwatchRunning) {
-        BLE_SetCurrentTime(TIME_TIMER->cnt - stopwatchStartTime);
+        Display_RequestFrame(GUI_RenderScreen);
     }
 
     snprintf(batteryLevelMenuLabel, sizeof(batteryLevelMenuLabel), "%d %%", FuelGauge_GetBatteryStatus());
-
-    if (isBleConnected) {
+    snprintf(sleepMenuLabel, sizeof(sleepMenuLabel), "%d %%", Power_GetResidencyPercent(POWER_STATE_DEEPSLEEP));
+    snprintf(currentMenuLabel, sizeof(currentMenuLabel), "%d uA", Energy_GetTotalCurrent());
+    snprintf(runtimeMenuLabel, sizeof(runtimeMenuLabel), "%d h", Energy_GetRemainingRuntime() / 60);
+
+    Display_Stats displayStats;
+    Display_GetStats(&displayStats);
+    snprintf(droppedMenuLabel, sizeof(droppedMenuLabel), "%d %%", displayStats.framesRendered ? (int)((uint64_t)displayStats.framesDropped * 100 / displayStats.framesRendered) : 0);
+
+    if (bleConnectionsCount > 1) {
+        snprintf(bleMenuLabel, sizeof(bleMenuLabel), "%d conn", bleConnectionsCount);
+        menuItems[0].itemValue = bleMenuLabel;
+    } else if (isBleConnected) {
         menuItems[0].itemValue = "connected";
     } else if (isBleAdvertisign) {
         menuItems[0].itemValue = "visible";
@@ -171,6 +303,8 @@ static void GUI_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
         menuItems[0].itemValue = "off";
     }
 
+    menuItems[1].itemValue = BLE_IsBroadcastEnabled() ? "on" : "off";
+
     if (isStopwatchRunning) {
         WS2812B_SetColor(0, 0, GUI_LED_BRIGHTNESS, 0);
     } else if (isBleAdvertisign && !isBleConnected) {
@@ -185,7 +319,7 @@ static void GUI_TimerHandler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
 
     WS2812B_Transmit();
 
-    WsfTimerStartMs(&guiTimer, 50);
+    GUI_RestartTimer();
 }
 
 void GUI_Init() {
@@ -201,19 +335,45 @@ void GUI_Init() {
     menuButtonText[BUTTON_BTNR_NO] = "";
     menuButtonHandlers[BUTTON_BTNR_NO] = GUI_MenuRightClick;
 
-    guiTimerHandler = WsfOsSetNextHandler(GUI_TimerHandler);
+    statsButtonText[BUTTON_BTNM_NO] = "";
+    statsButtonHandlers[BUTTON_BTNM_NO] = GUI_StatsCloseClick;
+    statsButtonText[BUTTON_BTNL_NO] = "*";
+    statsButtonHandlers[BUTTON_BTNL_NO] = GUI_StatsLeftClick;
+    statsButtonText[BUTTON_BTNR_NO] = "";
+    statsButtonHandlers[BUTTON_BTNR_NO] = NULL;
+
+    lapListButtonText[BUTTON_BTNM_NO] = "";
+    lapListButtonHandlers[BUTTON_BTNM_NO] = GUI_LapListCloseClick;
+    lapListButtonText[BUTTON_BTNL_NO] = "up";
+    lapListButtonHandlers[BUTTON_BTNL_NO] = GUI_LapListUpClick;
+    lapListButtonText[BUTTON_BTNR_NO] = "down";
+    lapListButtonHandlers[BUTTON_BTNR_NO] = GUI_LapListDownClick;
+
+    LapStats_Reset();
+    GUI_InvalidateLapList();
+    GUI_InitWidgets();
+
+    guiTimerHandler = Profile_SetNextHandler(GUI_TimerHandler, "GUI");
 
     guiTimer.handlerId = guiTimerHandler;
     guiTimer.msg.event = GUI_TIMER_TICK_EVENT;
     guiTimer.msg.param = 0;
     guiTimer.msg.status = 0;
-    WsfTimerStartMs(&guiTimer, 500);
+    Profile_TimerStartMs(&guiTimer, 500);
 
     GUI_RenderScreen();
 }
 
 void GUI_HandleButtonPress(int buttonNumber, uint32_t pressTime) {
-    if (isMenuOpen) {
+    if (isLapListOpen) {
+        if (lapListButtonHandlers[buttonNumber] != NULL) {
+            lapListButtonHandlers[buttonNumber](pressTime);
+        }
+    } else if (isStatsOpen) {
+        if (statsButtonHandlers[buttonNumber] != NULL) {
+            statsButtonHandlers[buttonNumber](pressTime);
+        }
+    } else if (isMenuOpen) {
         if (menuButtonHandlers[buttonNumber] != NULL) {
             menuButtonHandlers[buttonNumber](pressTime);
         }
@@ -224,11 +384,38 @@ void GUI_HandleButtonPress(int buttonNumber, uint32_t pressTime) {
     }
 }
 
-static void GUI_RenderBatteryIcon() {
-    for (int i = 0; i < sizeof(batIcon); i++) {
-        Display_SetPixelBuffer(GUI_BAT_POS + i, 0, batIcon[i]);
+static void GUI_InitWidgets() {
+    Widget_Init(&menuIconWidget, 0, GUI_MENU_POS, sizeof(closeIcon));
+    Widget_Init(&statusWidget, 0, GUI_STATUS_POS, GUI_BLE_POS - GUI_STATUS_POS);
+    Widget_Init(&bleWidget, 0, GUI_BLE_POS, sizeof(bleIcon));
+    Widget_Init(&batteryWidget, 0, GUI_BAT_POS, sizeof(batIcon));
+
+    for (int i = 0; i < GUI_CONTENT_LINES; i++) {
+        Widget_Init(&lineWidgets[i], 1 + i, 0, DISPLAY_WIDTH);
     }
 
+    // two columns between buttons stay blank as separator
+    Widget_Init(&leftButtonWidget, DISPLAY_LINES - 1, 0, GUI_BUTTON_WIDTH);
+    Widget_Init(&rightButtonWidget, DISPLAY_LINES - 1, GUI_BUTTON_WIDTH + 2, DISPLAY_WIDTH - GUI_BUTTON_WIDTH - 2);
+
+    int count = 0;
+    screenWidgets[count++] = &menuIconWidget;
+    screenWidgets[count++] = &statusWidget;
+    screenWidgets[count++] = &bleWidget;
+    screenWidgets[count++] = &batteryWidget;
+    for (int i = 0; i < GUI_CONTENT_LINES; i++) {
+        screenWidgets[count++] = &lineWidgets[i];
+    }
+    screenWidgets[count++] = &leftButtonWidget;
+    screenWidgets[count++] = &rightButtonWidget;
+}
+
+static void GUI_DrawBattery(Widget *widget) {
+    Display_CopyRect(widget->x, widget->row, sizeof(batIcon), 1, batIcon, sizeof(batIcon));
+    Display_OrSpan(widget->x + 1, widget->x + 3, widget->row, widget->content.key);
+}
+
+static void GUI_UpdateBatteryIcon() {
     uint8_t batteryFill;
     if (FuelGauge_IsCharging()) {
         batteryFill = batIconChargeFill[(animationCounter % 30) / 5];
@@ -248,75 +435,82 @@ static void GUI_RenderBatteryIcon() {
             batteryFill = batIconChargeFill[5];
         }
     }
-    Display_OrPixelBuffer(GUI_BAT_POS + 1, 0, batteryFill);
-    Display_OrPixelBuffer(GUI_BAT_POS + 2, 0, batteryFill);
+    Widget_SetCustom(&batteryWidget, GUI_DrawBattery, batteryFill);
 }
 
-static void GUI_RenderStatusBar() {
-    if (isMenuOpen) {
-        for (int i = 0; i < sizeof(closeIcon); i++) {
-            Display_SetPixelBuffer(i + GUI_MENU_POS, 0, closeIcon[i]);
-        }
+static void GUI_UpdateStatusBar() {
+    if (isMenuOpen || isStatsOpen || isLapListOpen) {
+        Widget_SetIcon(&menuIconWidget, closeIcon, sizeof(closeIcon));
     } else {
-        for (int i = 0; i < sizeof(menuIcon); i++) {
-            Display_SetPixelBuffer(i + GUI_MENU_POS, 0, menuIcon[i]);
-        }
+        Widget_SetIcon(&menuIconWidget, menuIcon, sizeof(menuIcon));
     }
 
-    if (isBleConnected) {
-        for (int i = 0; i < sizeof(bleIcon); i++) {
-            Display_SetPixelBuffer(i + GUI_BLE_POS, 0, bleIcon[i]);
-        }
-    } else if (isBleAdvertisign) {
-        if (animationCounter % 10 < 5) {
-            for (int i = 0; i < sizeof(bleIcon); i++) {
-                Display_SetPixelBuffer(i + GUI_BLE_POS, 0, bleIcon[i]);
-            }
-        }
+    if (isBleConnected || (isBleAdvertisign && animationCounter % 10 < 5)) {
+        Widget_SetIcon(&bleWidget, bleIcon, sizeof(bleIcon));
+    } else {
+        Widget_SetIcon(&bleWidget, NULL, 0);
     }
 
-    GUI_RenderBatteryIcon();
-
-    int mainPageStatusStringLen = Display_GetStringLength(mainPageStatusString);
-
-    int offset = GUI_STATUS_POS + (GUI_BLE_POS - GUI_STATUS_POS) / 2 - mainPageStatusStringLen / 2;
+    GUI_UpdateBatteryIcon();
 
-    Display_PrintString(offset, 0, mainPageStatusString);
-
-    for (int i = GUI_STATUS_POS; i < GUI_BLE_POS; i++) {
-        Display_ShiftLeftPixelBuffer(i, 0, 1);
-    }
+    Widget_SetText(&statusWidget, mainPageStatusString);
+    Widget_SetStyle(&statusWidget, WIDGET_ALIGN_CENTER, 1, 0);
 }
 
-static void GUI_RenderButtons() {
-    int buttonSize = (DISPLAY_WIDTH - 2) / 2;
-
-    int buttonOrderRemap[2] = {BUTTON_BTNL_NO, BUTTON_BTNR_NO};
+// button without label is left blank, drawing it inverted would show button that does nothing
+static void GUI_SetButton(Widget *widget, char *text) {
+    Widget_SetText(widget, text);
+    Widget_SetStyle(widget, WIDGET_ALIGN_CENTER, 2, text[0] != '\0');
+}
 
+static void GUI_UpdateButtons() {
     char **textSource;
-    if (isMenuOpen) {
+    if (isLapListOpen) {
+        textSource = lapListButtonText;
+    } else if (isStatsOpen) {
+        textSource = statsButtonText;
+    } else if (isMenuOpen) {
         textSource = menuButtonText;
     } else {
         textSource = mainPageButtonText;
     }
 
-    for (int i = 0; i < 2; i++) {
-        int textLen = Display_GetStringLength(textSource[buttonOrderRemap[i]]) - 1;
+    GUI_SetButton(&leftButtonWidget, textSource[BUTTON_BTNL_NO]);
+    GUI_SetButton(&rightButtonWidget, textSource[BUTTON_BTNR_NO]);
+}
 
-        int offset = i * (DISPLAY_WIDTH / 2) + buttonSize / 2 - textLen / 2;
+// content line 1 to 4, name on left and value on right
+static void GUI_SetLine(int line, char *text, char *value, int align, int shift, int isInverted) {
+    Widget *widget = &lineWidgets[line - 1];
 
-        Display_PrintString(offset, DISPLAY_LINES - 1, textSource[buttonOrderRemap[i]]);
-    }
-    for (int i = 0; i < DISPLAY_WIDTH; i++) {
-        Display_ShiftLeftPixelBuffer(i, DISPLAY_LINES - 1, 2);
-        Display_OrPixelBuffer(i, DISPLAY_LINES - 1, 0b00000001);
+    Widget_SetText(widget, text);
+    Widget_SetValue(widget, value);
+    Widget_SetStyle(widget, align, shift, isInverted);
+}
+
+// Pixels already on display move with content lines, so only lines that scrolled in are rasterised.
+// Display then finds moved rows in controller memory and sends only the new ones.
+static void GUI_ScrollLines(int delta) {
+    if (delta == 0 || delta >= GUI_CONTENT_LINES || delta <= -GUI_CONTENT_LINES) {
+        return;
     }
 
-    Display_SetPixelBuffer(buttonSize, DISPLAY_LINES - 1, 0xFF);
-    Display_SetPixelBuffer(buttonSize + 1, DISPLAY_LINES - 1, 0xFF);
+    Display_ScrollRows(1, GUI_CONTENT_LINES, delta);
 
-    for (int i = 0; i < DISPLAY_WIDTH; i++) {
-        Display_InvertPixelBuffer(i, DISPLAY_LINES - 1);
+    if (delta > 0) {
+        for (int i = 0; i < GUI_CONTENT_LINES - delta; i++) {
+            Widget_MoveDrawn(&lineWidgets[i], &lineWidgets[i + delta]);
+        }
+        for (int i = GUI_CONTENT_LINES - delta; i < GUI_CONTENT_LINES; i++) {
+            Widget_Invalidate(&lineWidgets[i]);
+        }
+    } else {
+        for (int i = GUI_CONTENT_LINES - 1; i >= -delta; i--) {
+            Widget_MoveDrawn(&lineWidgets[i], &lineWidgets[i + delta]);
+        }
+        for (int i = 0; i < -delta; i++) {
+            Widget_Invalidate(&lineWidgets[i]);
+        }
     }
 }
 
@@ -347,23 +541,48 @@ static void GUI_FormatTime(uint32_t time, char *timeBuffer, size_t timeBufferSiz
     }
 }
 
-static void GUI_PrintTime() {
-    uint32_t timeToRender;
+// large digits leave room for hours, minutes and seconds, fraction is shortened and dropped once hours are shown
+static void GUI_FormatTimeLarge(uint32_t time, char *timeBuffer, size_t timeBufferSize, int fractionDigits) {
+    int secTotal = time / TIME_TICK_PER_SEC;
 
-    if (!isStopwatchRunning) {
-        timeToRender = totalTime;
+    int hours = secTotal / 3600;
+    int minutes = secTotal / 60 % 60;
+    int sec = secTotal % 60;
+    int hundredths = (time % TIME_TICK_PER_SEC) * 100 / TIME_TICK_PER_SEC;
+
+    if (hours > 0) {
+        snprintf(timeBuffer, timeBufferSize, "%d:%02d:%02d", hours, minutes, sec);
+    } else if (fractionDigits == 1) {
+        snprintf(timeBuffer, timeBufferSize, "%02d:%02d.%d", minutes, sec, hundredths / 10);
     } else {
-        uint32_t now = TIME_TIMER->cnt;
-        timeToRender = now - stopwatchStartTime;
+        snprintf(timeBuffer, timeBufferSize, "%02d:%02d.%02d", minutes, sec, hundredths);
+    }
+}
+
+// text in font taller than one page covers lines below, their widgets are hidden
+static void GUI_SetLargeLine(int line, char *text, const Font *font) {
+    GUI_SetLine(line, text, "", WIDGET_ALIGN_CENTER, 0, 0);
+    Widget_SetFont(&lineWidgets[line - 1], font);
+
+    for (int i = 1; i < font->height && line - 1 + i < GUI_CONTENT_LINES; i++) {
+        Widget_Hide(&lineWidgets[line - 1 + i]);
     }
+}
 
+// time takes three lines until laps need the lower two, or while it is too wide for three page digits
+static void GUI_PrintTime() {
     char buff[32];
-    GUI_FormatTime(timeToRender, buff, sizeof(buff), 0);
 
-    int len = Display_GetStringLength(buff) - 1;
-    int offset = DISPLAY_WIDTH / 2 - len / 2;
+    if (lapCount == 0) {
+        GUI_FormatTimeLarge(GUI_GetElapsedTime(), buff, sizeof(buff), 1);
+        if (Display_GetFontStringLength(&Font_Digits24, buff) <= DISPLAY_WIDTH) {
+            GUI_SetLargeLine(1, buff, &Font_Digits24);
+            return;
+        }
+    }
 
-    Display_PrintString(offset, 2, buff);
+    GUI_FormatTimeLarge(GUI_GetElapsedTime(), buff, sizeof(buff), 2);
+    GUI_SetLargeLine(1, buff, &Font_Digits16);
 }
 
 static void GUI_PrintLaps() {
@@ -381,7 +600,7 @@ static void GUI_PrintLaps() {
     GUI_FormatTime(lapTime, time, sizeof(time), 1);
     snprintf(line, sizeof(line), "L%d: %s", lapCount, time);
 
-    Display_PrintString(0, 3, line);
+    GUI_SetLine(3, line, "", WIDGET_ALIGN_LEFT, 0, 0);
 
     if (isStopwatchRunning) {
         lapTime = TIME_TIMER->cnt - lapOffsets[lapCount - 1];
@@ -392,55 +611,148 @@ static void GUI_PrintLaps() {
     GUI_FormatTime(lapTime, time, sizeof(time), 1);
     snprintf(line, sizeof(line), "L%d: %s", lapCount + 1, time);
 
-    Display_PrintString(0, 4, line);
+    GUI_SetLine(4, line, "", WIDGET_ALIGN_LEFT, 0, 0);
 }
 
 static void GUI_RenderMenu() {
     for (int i = 0; i < sizeof(menuItems) / sizeof(*menuItems); i++) {
         int line = 1 + i - menuScroll;
-        if (line < 1 || line > 4) {
+        if (line < 1 || line > GUI_CONTENT_LINES) {
             continue;
         }
 
-        // display item name
-        Display_PrintString(1, line, menuItems[i].itemName);
-
-        // display item name
-        int valLen = Display_GetStringLength(menuItems[i].itemValue);
-        Display_PrintString(DISPLAY_WIDTH - valLen, line, menuItems[i].itemValue);
+        // selected item is highlighted
+        GUI_SetLine(line, menuItems[i].itemName, menuItems[i].itemValue, WIDGET_ALIGN_LEFT, 2, menuSelectedItem == i);
+    }
+}
 
-        for (int j = 0; j < DISPLAY_WIDTH; j++) {
-            Display_ShiftLeftPixelBuffer(j, line, 2);
+// statistics are kept up to date as laps are added, rendering only formats them
+static void GUI_RenderStats() {
+    static char *names[GUI_STATS_ITEMS] = {"Laps", "Best", "Worst", "Mean", "Std dev", "Median", "90 %"};
+    uint32_t values[GUI_STATS_ITEMS] = {
+        0,
+        LapStats_GetBest(),
+        LapStats_GetWorst(),
+        LapStats_GetMean(),
+        LapStats_GetStdDev(),
+        LapStats_GetMedian(),
+        LapStats_GetP90(),
+    };
+    char value[16];
+
+    for (int i = 0; i < GUI_STATS_ITEMS; i++) {
+        int line = 1 + i - statsScroll;
+        if (line < 1 || line > GUI_CONTENT_LINES) {
+            continue;
         }
 
-        // highlight selected item
-        if (menuSelectedItem == i) {
-            for (int j = 0; j < DISPLAY_WIDTH; j++) {
-                Display_OrPixelBuffer(j, line, 0b00000001);
-                Display_InvertPixelBuffer(j, line);
-            }
+        if (i == 0) {
+            snprintf(value, sizeof(value), "%d", LapStats_GetCount());
+        } else if (LapStats_GetCount() == 0) {
+            snprintf(value, sizeof(value), "-");
+        } else {
+            GUI_FormatTime(values[i], value, sizeof(value), 1);
         }
+
+        GUI_SetLine(line, names[i], value, WIDGET_ALIGN_LEFT, 2, 0);
+    }
+}
+
+// line widgets showing lap list keep lap index as key, after reset the same index means different lap
+static void GUI_InvalidateLapList() {
+    for (int i = 0; i < GUI_LAP_LIST_CACHE_ROWS; i++) {
+        lapListCache[i].lapIndex = -1;
+    }
+    lapListScroll = 0;
+
+    for (int i = 0; i < GUI_CONTENT_LINES; i++) {
+        Widget_Invalidate(&lineWidgets[i]);
+    }
+}
+
+static int GUI_GetLapListMaxScroll() {
+    return lapCount > GUI_LAP_LIST_ROWS ? lapCount - GUI_LAP_LIST_ROWS : 0;
+}
+
+static void GUI_DrawLapListRow(Widget *widget) {
+    int lapIndex = widget->content.key;
+    int line = widget->row;
+    char number[8];
+    char time[16];
+
+    // cache is direct mapped, visible rows never collide as it holds more rows than display shows
+    struct GUI_LapListRow *row = &lapListCache[lapIndex % GUI_LAP_LIST_CACHE_ROWS];
+    if (row->lapIndex == lapIndex) {
+        Display_SetRowBuffer(line, row->pixels);
+        return;
+    }
+
+    snprintf(number, sizeof(number), "%d", lapIndex + 1);
+    GUI_FormatTime(GUI_GetLapTime(lapIndex), time, sizeof(time), 1);
+
+    Display_PrintString(1, line, number);
+    Display_PrintString(DISPLAY_WIDTH - Display_GetStringLength(time), line, time);
+
+    Display_ShiftLeftSpan(0, DISPLAY_WIDTH, line, 2);
+
+    Display_GetRowBuffer(line, row->pixels);
+    row->lapIndex = lapIndex;
+}
+
+// only visible rows are rendered, so cost does not depend on number of laps
+static void GUI_RenderLapList() {
+    if (lapCount == 0) {
+        GUI_SetLine(2, "no laps", "", WIDGET_ALIGN_LEFT, 0, 0);
+        return;
+    }
+
+    if (isLapListFollowing && lapListScroll != GUI_GetLapListMaxScroll()) {
+        GUI_ScrollLines(GUI_GetLapListMaxScroll() - lapListScroll);
+        lapListScroll = GUI_GetLapListMaxScroll();
+    }
+
+    for (int i = 0; i < GUI_LAP_LIST_ROWS && lapListScroll + i < lapCount; i++) {
+        Widget_SetCustom(&lineWidgets[i], GUI_DrawLapListRow, lapListScroll + i);
     }
 }
 
 static void GUI_StartClick(uint32_t pressTime) {
+    Trace_Event(TRACE_EVENT_STOPWATCH, TRACE_STOPWATCH_START, pressTime);
+
+    // manual start overrides scheduled one
+    if (isStartScheduled) {
+        isStartScheduled = 0;
+        Time_StopAlarm();
+    }
+
     stopwatchStartTime = pressTime;
     isStopwatchRunning = 1;
     lapCount = 0;
+    LapStats_Reset();
+    GUI_InvalidateLapList();
 
+    // TIME_TIMER is not guaranteed to count in deep sleep
+    Power_SetDeepSleepAllowed(0);
+
+    BLE_AddLapEvent(BLE_LAP_EVENT_START, 0, pressTime, 0);
     BLE_LapCountChanged(lapCount);
     BLE_SetStatus(0x01);
 
     GUI_SetRunModeButtons();
     GUI_RenderScreen();
+    GUI_RestartTimer();
 }
 
 static void GUI_StopClick(uint32_t pressTime) {
+    Trace_Event(TRACE_EVENT_STOPWATCH, TRACE_STOPWATCH_STOP, pressTime);
+
     totalTime = pressTime - stopwatchStartTime;
     stopwatchStopTime = pressTime;
     isStopwatchRunning = 0;
 
-    BLE_SetCurrentTime(totalTime);
+    Power_SetDeepSleepAllowed(1);
+
+    BLE_AddLapEvent(BLE_LAP_EVENT_STOP, 0, pressTime, totalTime);
     BLE_SetStatus(0x00);
 
     GUI_SetReadyModeButtons();
@@ -448,8 +760,12 @@ static void GUI_StopClick(uint32_t pressTime) {
 }
 
 static void GUI_LapClick(uint32_t pressTime) {
+    Trace_Event(TRACE_EVENT_STOPWATCH, TRACE_STOPWATCH_LAP, pressTime);
+
     if (lapCount < LAPS_MAX) {
         lapOffsets[lapCount++] = pressTime;
+        LapStats_Add(GUI_GetLapTime(lapCount - 1));
+        BLE_AddLapEvent(BLE_LAP_EVENT_LAP, lapCount - 1, pressTime, GUI_GetLapTime(lapCount - 1));
     }
 
     BLE_LapCountChanged(lapCount);
@@ -458,6 +774,67 @@ static void GUI_LapClick(uint32_t pressTime) {
     GUI_RenderScreen();
 }
 
+static void GUI_Reset() {
+    Trace_Event(TRACE_EVENT_STOPWATCH, TRACE_STOPWATCH_RESET, TIME_TIMER->cnt);
+
+    isStopwatchRunning = 0;
+    totalTime = 0;
+    lapCount = 0;
+    LapStats_Reset();
+    GUI_InvalidateLapList();
+
+    if (!isStartScheduled) {
+        Power_SetDeepSleepAllowed(1);
+    }
+
+    BLE_AddLapEvent(BLE_LAP_EVENT_RESET, 0, TIME_TIMER->cnt, 0);
+    BLE_LapCountChanged(lapCount);
+    BLE_SetStatus(0x00);
+
+    GUI_SetReadyModeButtons();
+    GUI_RenderScreen();
+}
+
+// remote commands may carry time in past, it is kept between last stopwatch event and now
+int GUI_ExecuteCommand(int command, uint32_t time) {
+    uint32_t now = TIME_TIMER->cnt;
+    if ((int32_t)(time - now) > 0) {
+        time = now;
+    }
+
+    if (command == GUI_COMMAND_RESET) {
+        GUI_Reset();
+        return E_NO_ERROR;
+    }
+
+    if (command == GUI_COMMAND_START) {
+        if (isStopwatchRunning) {
+            return E_BAD_STATE;
+        }
+        GUI_StartClick(time);
+        return E_NO_ERROR;
+    }
+
+    if (!isStopwatchRunning) {
+        return E_BAD_STATE;
+    }
+
+    uint32_t lastEventTime = lapCount > 0 ? lapOffsets[lapCount - 1] : stopwatchStartTime;
+    if ((int32_t)(time - lastEventTime) < 0) {
+        time = lastEventTime;
+    }
+
+    if (command == GUI_COMMAND_STOP) {
+        GUI_StopClick(time);
+    } else if (command == GUI_COMMAND_LAP) {
+        GUI_LapClick(time);
+    } else {
+        return E_BAD_PARAM;
+    }
+
+    return E_NO_ERROR;
+}
+
 static void GUI_MenuClick(uint32_t pressTime) {
     if (isMenuOpen) {
         isMenuOpen = 0;
@@ -468,6 +845,7 @@ static void GUI_MenuClick(uint32_t pressTime) {
     }
 
     GUI_RenderScreen();
+    GUI_RestartTimer();
 }
 
 static void GUI_MenuLeftClick(uint32_t pressTime) {
@@ -478,8 +856,9 @@ static void GUI_MenuLeftClick(uint32_t pressTime) {
         menuScroll = 0;
     }
 
-    if (menuSelectedItem - menuScroll > 4) {
+    if (menuSelectedItem - menuScroll > GUI_CONTENT_LINES - 1) {
         menuScroll++;
+        GUI_ScrollLines(1);
     }
 
     menuButtonText[BUTTON_BTNR_NO] = menuItems[menuSelectedItem].actionLabel;
@@ -495,8 +874,67 @@ static void GUI_MenuRightClick(uint32_t pressTime) {
     GUI_RenderScreen();
 }
 
+static void GUI_Menu_StatsClick() {
+    isMenuOpen = 0;
+    isStatsOpen = 1;
+    statsScroll = 0;
+}
+
+static void GUI_StatsCloseClick(uint32_t pressTime) {
+    isStatsOpen = 0;
+
+    GUI_RenderScreen();
+    GUI_RestartTimer();
+}
+
+static void GUI_StatsLeftClick(uint32_t pressTime) {
+    statsScroll++;
+
+    if (statsScroll > GUI_STATS_ITEMS - GUI_CONTENT_LINES) {
+        statsScroll = 0;
+    } else {
+        GUI_ScrollLines(1);
+    }
+
+    GUI_RenderScreen();
+}
+
+static void GUI_Menu_LapListClick() {
+    isMenuOpen = 0;
+    isLapListOpen = 1;
+    isLapListFollowing = 1;
+}
+
+static void GUI_LapListCloseClick(uint32_t pressTime) {
+    isLapListOpen = 0;
+
+    GUI_RenderScreen();
+    GUI_RestartTimer();
+}
+
+static void GUI_LapListUpClick(uint32_t pressTime) {
+    if (lapListScroll > 0) {
+        lapListScroll--;
+        GUI_ScrollLines(-1);
+    }
+    isLapListFollowing = 0;
+
+    GUI_RenderScreen();
+}
+
+// list follows new laps again once it is scrolled to the end
+static void GUI_LapListDownClick(uint32_t pressTime) {
+    if (lapListScroll < GUI_GetLapListMaxScroll()) {
+        lapListScroll++;
+        GUI_ScrollLines(1);
+    }
+    isLapListFollowing = lapListScroll == GUI_GetLapListMaxScroll();
+
+    GUI_RenderScreen();
+}
+
 static void GUI_SetReadyModeButtons() {
-    mainPageStatusString = "ready";
+    mainPageStatusString = isStartScheduled ? "armed" : "ready";
 
     mainPageButtonText[BUTTON_BTNL_NO] = "start";
     mainPageButtonHandlers[BUTTON_BTNL_NO] = GUI_StartClick;
@@ -531,17 +969,29 @@ static void GUI_SetRunModeButtons() {
 void GUI_SetBleAdvertisignStatus(int isAdvertisign) {
     isBleAdvertisign = isAdvertisign;
     GUI_RenderScreen();
+    GUI_RestartTimer();
 }
 
-void GUI_SetBleConnectionStatus(int isConnected) {
-    isBleConnected = isConnected;
+void GUI_SetBleConnectionStatus(int connectionsCount) {
+    isBleConnected = connectionsCount > 0;
+    bleConnectionsCount = connectionsCount;
     GUI_RenderScreen();
+    GUI_RestartTimer();
 }
 
+// pages only set content of widgets, then widgets that differ from what is on display are drawn again
 static void GUI_RenderScreen() {
-    Display_Clear();
-    GUI_RenderStatusBar();
-    if (isMenuOpen) {
+    GUI_UpdateStatusBar();
+
+    for (int i = 0; i < GUI_CONTENT_LINES; i++) {
+        Widget_Clear(&lineWidgets[i]);
+    }
+
+    if (isLapListOpen) {
+        GUI_RenderLapList();
+    } else if (isStatsOpen) {
+        GUI_RenderStats();
+    } else if (isMenuOpen) {
         GUI_RenderMenu();
     } else {
         GUI_PrintTime();
@@ -549,8 +999,69 @@ static void GUI_RenderScreen() {
             GUI_PrintLaps();
         }
     }
-    GUI_RenderButtons();
-    Display_Show();
+    GUI_UpdateButtons();
+
+    int redrawn = Widget_RenderAll(screenWidgets, sizeof(screenWidgets) / sizeof(*screenWidgets));
+    if (redrawn) {
+        Trace_Event(TRACE_EVENT_GUI_FRAME, redrawn, sizeof(screenWidgets) / sizeof(*screenWidgets));
+        Display_Show();
+    }
+}
+
+uint32_t GUI_GetElapsedTime() {
+    if (isStopwatchRunning) {
+        return TIME_TIMER->cnt - stopwatchStartTime;
+    }
+    return totalTime;
+}
+
+uint32_t GUI_GetStartTick() {
+    return stopwatchStartTime;
+}
+
+static void GUI_ScheduledStartInterruptHandler() {
+    WsfSetEvent(guiTimerHandler, GUI_SCHEDULED_START_EVENT_MASK);
+}
+
+int GUI_ScheduleStart(uint32_t startTime) {
+    int status;
+
+    if (isStopwatchRunning) {
+        return E_BAD_STATE;
+    }
+
+    status = Time_StartAlarm(startTime, GUI_ScheduledStartInterruptHandler);
+    if (status) {
+        return status;
+    }
+
+    isStartScheduled = 1;
+    scheduledStartTime = startTime;
+
+    // TIME_TIMER and alarm must keep counting until start
+    Power_SetDeepSleepAllowed(0);
+
+    GUI_SetReadyModeButtons();
+    GUI_RenderScreen();
+
+    return E_NO_ERROR;
+}
+
+void GUI_CancelScheduledStart() {
+    if (!isStartScheduled) {
+        return;
+    }
+
+    isStartScheduled = 0;
+    Time_StopAlarm();
+    Power_SetDeepSleepAllowed(1);
+
+    GUI_SetReadyModeButtons();
+    GUI_RenderScreen();
+}
+
+int GUI_IsStartScheduled() {
+    return isStartScheduled;
 }
 
 uint32_t GUI_GetLapTime(uint8_t lapNumber) {
@@ -565,6 +1076,14 @@ uint32_t GUI_GetLapTime(uint8_t lapNumber) {
     }
 }
 
+int GUI_GetLapCount() {
+    return lapCount;
+}
+
+int GUI_IsRunning() {
+    return isStopwatchRunning;
+}
+
 static void GUI_ShutdownTimerHandler() {
     for (int i = 0; i < MXC_IRQ_COUNT; i++) {
         NVIC_DisableIRQ(i);
@@ -587,12 +1106,10 @@ static void GUI_ShutdownTimerHandler() {
 static void GUI_Menu_TurnOffClick() {
     int status;
 
-    dmConnId_t connId = AppConnIsOpen();
-    if (connId != DM_CONN_ID_NONE) {
-        AppConnClose(connId);
-    }
+    BLE_DisconnectAll();
 
     Display_Off();
+    Energy_SetDisplayOn(0);
 
     WS2812B_SetColor(0, 0, 0, 0);
     for (int i = 0; i < 3; i++) {
@@ -600,35 +1117,22 @@ static void GUI_Menu_TurnOffClick() {
     }
     WS2812B_Disable();
 
-    mxc_tmr_cfg_t shutdownTmr;
-    shutdownTmr.bitMode = TMR_BIT_MODE_32;
-    shutdownTmr.clock = MXC_TMR_32K_CLK;
-    shutdownTmr.cmp_cnt = 64000;
-    shutdownTmr.mode = TMR_MODE_ONESHOT;
-    shutdownTmr.pol = 0;
-    shutdownTmr.pres = TMR_PRES_1;
+    // alarm timer is shared with scheduled start which is dropped here
+    isStartScheduled = 0;
 
-    status = MXC_TMR_Init(MXC_TMR2, &shutdownTmr, false);
+    status = Time_StartAlarm(TIME_TIMER->cnt + GUI_SHUTDOWN_DELAY_TICKS, GUI_ShutdownTimerHandler);
     if (status) {
-        APP_TRACE_ERR1("Error while enabling shutdown timer. MXC_TMR_Init failed with status code %d", status);
+        TRACE_ERROR(TRACE_MODULE_GUI, status);
         return;
     }
 
-    MXC_NVIC_SetVector(TMR2_IRQn, GUI_ShutdownTimerHandler);
-    NVIC_SetPriority(TMR2_IRQn, 0);
-    NVIC_ClearPendingIRQ(TMR2_IRQn);
-    NVIC_EnableIRQ(TMR2_IRQn);
-
-    MXC_TMR_EnableInt(MXC_TMR2);
-
-    MXC_TMR_Start(MXC_TMR2);
+    NVIC_SetPriority(TIME_ALARM_IRQn, 0);
 }
 
 static void GUI_Menu_BluetoothClick() {
     if (isBleConnected) {
-        dmConnId_t connId = AppConnIsOpen();
-        if (connId != DM_CONN_ID_NONE) {
-            AppConnClose(connId);
+        if (BLE_GetConnectionsCount() > 0) {
+            BLE_DisconnectAll();
         } else {
             isBleConnected = 0;
             AppAdvStart(APP_MODE_AUTO_INIT);
@@ -638,4 +1142,9 @@ static void GUI_Menu_BluetoothClick() {
     } else {
         AppAdvStart(APP_MODE_AUTO_INIT);
     }
+}
+
+static void GUI_Menu_BroadcastClick() {
+    BLE_SetBroadcastEnabled(!BLE_IsBroadcastEnabled());
+    menuItems[1].itemValue = BLE_IsBroadcastEnabled() ? "on" : "off";
 }
\ No newline at end of file
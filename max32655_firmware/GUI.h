@@ -3,10 +3,27 @@
 
 #include <stdint.h>
 
+// keep in sync with StopwatchCommand in windows app
+enum {
+    GUI_COMMAND_START,
+    GUI_COMMAND_STOP,
+    GUI_COMMAND_LAP,
+    GUI_COMMAND_RESET,
+    GUI_COMMAND_COUNT
+};
+
 void GUI_Init();
 void GUI_HandleButtonPress(int buttonNumber, uint32_t pressTime);
 void GUI_SetBleAdvertisignStatus(int isAdvertisign);
-void GUI_SetBleConnectionStatus(int isConnected);
+void GUI_SetBleConnectionStatus(int connectionsCount);
+uint32_t GUI_GetElapsedTime();
+uint32_t GUI_GetStartTick();
+int GUI_ScheduleStart(uint32_t startTime);
+void GUI_CancelScheduledStart();
+int GUI_IsStartScheduled();
+int GUI_ExecuteCommand(int command, uint32_t time);
 uint32_t GUI_GetLapTime(uint8_t lapNumber);
+int GUI_GetLapCount();
+int GUI_IsRunning();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,290 @@
+/* self */
+#include "I2CBus.h"
+
+/* project */
+#include "Profile.h"
+#include "Time.h"
+#include "Trace.h"
+
+/* stdlib */
+#include <stdint.h>
+#include <stdlib.h>
+
+/* max32655 + cordio */
+#include <i2c.h>
+#include <max32655.h>
+#include <wsf_msg.h>
+#include <wsf_os.h>
+#include <wsf_trace.h>
+
+#define I2C_BUS_SEGMENT_DONE_EVENT 0xE0
+
+// fallback used when message could not be allocated in interrupt
+#define I2C_BUS_SEGMENT_DONE_EVENT_MASK 0x0001
+
+typedef struct {
+    mxc_i2c_regs_t *i2c;
+    int isConfigured;
+
+    I2CBus_Transaction *active;
+    I2CBus_Transaction *queueHead;
+
+    volatile int isSegmentDone;
+    volatile int segmentResult;
+    uint32_t segmentStartTime;
+    volatile uint32_t segmentEndTime;
+
+    I2CBus_Stats stats;
+} I2CBus_Bus;
+
+static I2CBus_Bus buses[I2C_BUS_COUNT];
+
+static wsfHandlerId_t busHandler;
+
+static void I2CBus_StartNextTransaction(I2CBus_Bus *bus);
+
+static I2CBus_Bus *I2CBus_GetBus(mxc_i2c_regs_t *i2c) {
+    int index = MXC_I2C_GET_IDX(i2c);
+    if (index < 0 || index >= I2C_BUS_COUNT) {
+        return NULL;
+    }
+    return &buses[index];
+}
+
+static void I2CBus_SignalSegmentDone(I2CBus_Bus *bus) {
+    wsfMsgHdr_t *pMsg;
+
+    bus->isSegmentDone = 1;
+
+    if ((pMsg = WsfMsgAlloc(sizeof(wsfMsgHdr_t))) != NULL) {
+        pMsg->event = I2C_BUS_SEGMENT_DONE_EVENT;
+        pMsg->param = bus - buses;
+        pMsg->status = 0;
+        WsfMsgSend(busHandler, pMsg);
+    } else {
+        WsfSetEvent(busHandler, I2C_BUS_SEGMENT_DONE_EVENT_MASK);
+    }
+}
+
+static void I2CBus_SegmentCompletionCallback(mxc_i2c_req_t *req, int result) {
+    I2CBus_Bus *bus = I2CBus_GetBus(req->i2c);
+    if (bus == NULL) {
+        return;
+    }
+
+    bus->segmentEndTime = TIME_TIMER->cnt;
+    bus->segmentResult = result;
+    I2CBus_SignalSegmentDone(bus);
+}
+
+static void I2CBus_StartSegment(I2CBus_Bus *bus) {
+    int status;
+
+    mxc_i2c_req_t *segment = &bus->active->segments[bus->active->currentSegment];
+    segment->i2c = bus->i2c;
+    segment->callback = I2CBus_SegmentCompletionCallback;
+
+    bus->isSegmentDone = 0;
+    bus->segmentStartTime = TIME_TIMER->cnt;
+
+    status = MXC_I2C_MasterTransactionAsync(segment);
+    if (status) {
+        TRACE_ERROR(TRACE_MODULE_I2C_BUS, status);
+        bus->segmentEndTime = bus->segmentStartTime;
+        bus->segmentResult = status;
+        I2CBus_SignalSegmentDone(bus);
+    }
+}
+
+static void I2CBus_ProcessSegmentDone(I2CBus_Bus *bus) {
+    I2CBus_Transaction *transaction = bus->active;
+    int result = bus->segmentResult;
+
+    bus->isSegmentDone = 0;
+
+    if (transaction == NULL) {
+        return;
+    }
+
+    mxc_i2c_req_t *segment = &transaction->segments[transaction->currentSegment];
+
+    bus->stats.busyTicks += bus->segmentEndTime - bus->segmentStartTime;
+    if (result == 0) {
+        bus->stats.bytesTransferred += segment->tx_len + segment->rx_len;
+    }
+
+    if (result == 0 && ++transaction->currentSegment < transaction->segmentsCount) {
+        I2CBus_StartSegment(bus);
+        return;
+    }
+
+    bus->active = NULL;
+    transaction->isQueued = 0;
+
+    bus->stats.transactions++;
+    if (result) {
+        bus->stats.failedTransactions++;
+    }
+
+    Trace_Event(TRACE_EVENT_I2C_TRANSACTION, ((bus - buses) << 8) | transaction->priority, result);
+
+    if (transaction->callback) {
+        transaction->callback(transaction, result);
+    }
+
+    I2CBus_StartNextTransaction(bus);
+}
+
+static void I2CBus_StartNextTransaction(I2CBus_Bus *bus) {
+    if (bus->active != NULL || bus->queueHead == NULL) {
+        return;
+    }
+
+    bus->active = bus->queueHead;
+    bus->queueHead = bus->active->next;
+    bus->active->next = NULL;
+    bus->active->currentSegment = 0;
+    bus->stats.queueDepth--;
+
+    I2CBus_StartSegment(bus);
+}
+
+static void I2CBus_Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    if (pMsg != NULL && pMsg->event != I2C_BUS_SEGMENT_DONE_EVENT) {
+        return;
+    }
+
+    for (size_t i = 0; i < I2C_BUS_COUNT; i++) {
+        if (buses[i].isSegmentDone) {
+            I2CBus_ProcessSegmentDone(&buses[i]);
+        }
+    }
+}
+
+void I2CBus_Init() {
+    busHandler = Profile_SetNextHandler(I2CBus_Handler, "I2C");
+}
+
+int I2CBus_ConfigureBus(mxc_i2c_regs_t *i2c, unsigned int frequency, IRQn_Type irq) {
+    int status;
+
+    I2CBus_Bus *bus = I2CBus_GetBus(i2c);
+    if (bus == NULL) {
+        return E_BAD_PARAM;
+    }
+
+    if (bus->active != NULL) {
+        return E_BUSY;
+    }
+
+    bus->isConfigured = 0;
+
+    status = MXC_I2C_Init(i2c, 1, 0);
+    if (status) {
+        TRACE_ERROR(TRACE_MODULE_I2C_BUS, status);
+        return status;
+    }
+
+    status = MXC_I2C_SetFrequency(i2c, frequency);
+    if (status < 0) {
+        TRACE_ERROR(TRACE_MODULE_I2C_BUS, status);
+        return status;
+    }
+
+    NVIC_SetPriority(irq, 3);
+    NVIC_ClearPendingIRQ(irq);
+    NVIC_EnableIRQ(irq);
+
+    bus->i2c = i2c;
+    bus->isConfigured = 1;
+
+    if (bus->stats.statsStartTime == 0) {
+        bus->stats.statsStartTime = TIME_TIMER->cnt;
+    }
+
+    I2CBus_StartNextTransaction(bus);
+
+    return E_NO_ERROR;
+}
+
+int I2CBus_Submit(I2CBus_Transaction *transaction) {
+    if (transaction->segmentsCount < 1) {
+        return E_BAD_PARAM;
+    }
+
+    I2CBus_Bus *bus = I2CBus_GetBus(transaction->segments[0].i2c);
+    if (bus == NULL) {
+        return E_BAD_PARAM;
+    }
+
+    if (transaction->isQueued) {
+        return E_BUSY;
+    }
+
+    // keep FIFO order between transactions of the same priority
+    I2CBus_Transaction **insertAt = &bus->queueHead;
+    while (*insertAt != NULL && (*insertAt)->priority >= transaction->priority) {
+        insertAt = &(*insertAt)->next;
+    }
+
+    transaction->next = *insertAt;
+    *insertAt = transaction;
+    transaction->isQueued = 1;
+
+    bus->stats.queueDepth++;
+    if (bus->stats.queueDepth > bus->stats.maxQueueDepth) {
+        bus->stats.maxQueueDepth = bus->stats.queueDepth;
+    }
+
+    if (bus->isConfigured) {
+        I2CBus_StartNextTransaction(bus);
+    }
+
+    return E_NO_ERROR;
+}
+
+int I2CBus_IsBusy() {
+    for (size_t i = 0; i < I2C_BUS_COUNT; i++) {
+        if (buses[i].active != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void I2CBus_GetStats(mxc_i2c_regs_t *i2c, I2CBus_Stats *stats) {
+    I2CBus_Bus *bus = I2CBus_GetBus(i2c);
+    if (bus == NULL) {
+        return;
+    }
+
+    *stats = bus->stats;
+}
+
+int I2CBus_GetUtilization(mxc_i2c_regs_t *i2c) {
+    I2CBus_Bus *bus = I2CBus_GetBus(i2c);
+    if (bus == NULL) {
+        return 0;
+    }
+
+    uint32_t elapsed = TIME_TIMER->cnt - bus->stats.statsStartTime;
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    return (int)((uint64_t)bus->stats.busyTicks * 100 / elapsed);
+}
+
+void I2CBus_ResetStats(mxc_i2c_regs_t *i2c) {
+    I2CBus_Bus *bus = I2CBus_GetBus(i2c);
+    if (bus == NULL) {
+        return;
+    }
+
+    int queueDepth = bus->stats.queueDepth;
+
+    bus->stats = (I2CBus_Stats){0};
+    bus->stats.queueDepth = queueDepth;
+    bus->stats.maxQueueDepth = queueDepth;
+    bus->stats.statsStartTime = TIME_TIMER->cnt;
+}
\ No newline at end of file
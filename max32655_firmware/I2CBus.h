@@ -0,0 +1,53 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+
+#include <i2c.h>
+#include <max32655.h>
+
+#define I2C_BUS_COUNT 3
+
+enum {
+    I2C_BUS_PRIORITY_LOW,
+    I2C_BUS_PRIORITY_NORMAL,
+    I2C_BUS_PRIORITY_HIGH,
+};
+
+typedef struct I2CBus_Transaction I2CBus_Transaction;
+typedef void (*I2CBus_CompletionCallback)(I2CBus_Transaction *transaction, int result);
+
+// Segments are executed back to back without any other transaction in between.
+// Write-then-read is a single segment with both tx_buf and rx_buf set.
+// Callback is invoked from I2CBus WSF handler, never from interrupt.
+struct I2CBus_Transaction {
+    mxc_i2c_req_t *segments;
+    int segmentsCount;
+    int priority;
+    I2CBus_CompletionCallback callback;
+
+    // owned by I2CBus
+    I2CBus_Transaction *next;
+    int currentSegment;
+    int isQueued;
+};
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t failedTransactions;
+    uint32_t bytesTransferred;
+    uint32_t busyTicks;
+    uint32_t statsStartTime;
+    int queueDepth;
+    int maxQueueDepth;
+} I2CBus_Stats;
+
+void I2CBus_Init();
+int I2CBus_ConfigureBus(mxc_i2c_regs_t *i2c, unsigned int frequency, IRQn_Type irq);
+int I2CBus_Submit(I2CBus_Transaction *transaction);
+int I2CBus_IsBusy();
+void I2CBus_GetStats(mxc_i2c_regs_t *i2c, I2CBus_Stats *stats);
+int I2CBus_GetUtilization(mxc_i2c_regs_t *i2c);
+void I2CBus_ResetStats(mxc_i2c_regs_t *i2c);
+
+#endif
\ No newline at end of file
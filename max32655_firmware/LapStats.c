@@ -0,0 +1,212 @@
+/* self */
+#include "LapStats.h"
+
+/* stdlib */
+#include <math.h>
+#include <stdint.h>
+
+#define LAP_STATS_MARKERS 5
+
+// P² estimator (Jain & Chlamtac), quantile is tracked by 5 markers, so memory and time per lap are constant
+typedef struct {
+    float p;
+    int count;
+    float heights[LAP_STATS_MARKERS];
+    int positions[LAP_STATS_MARKERS];
+    float desired[LAP_STATS_MARKERS];
+    float increments[LAP_STATS_MARKERS];
+} LapStats_Quantile;
+
+static int count = 0;
+static uint32_t best = 0;
+static uint32_t worst = 0;
+
+// Welford running mean and sum of squared differences from mean, float is enough for ticks and M4F computes it in hardware
+static float mean = 0;
+static float m2 = 0;
+
+static LapStats_Quantile median;
+static LapStats_Quantile p90;
+
+static void LapStats_QuantileReset(LapStats_Quantile *q, float p) {
+    q->p = p;
+    q->count = 0;
+
+    for (int i = 0; i < LAP_STATS_MARKERS; i++) {
+        q->positions[i] = i + 1;
+    }
+
+    q->desired[0] = 1;
+    q->desired[1] = 1 + 2 * p;
+    q->desired[2] = 1 + 4 * p;
+    q->desired[3] = 3 + 2 * p;
+    q->desired[4] = 5;
+
+    q->increments[0] = 0;
+    q->increments[1] = p / 2;
+    q->increments[2] = p;
+    q->increments[3] = (1 + p) / 2;
+    q->increments[4] = 1;
+}
+
+static float LapStats_Parabolic(LapStats_Quantile *q, int i, int d) {
+    float *h = q->heights;
+    int *n = q->positions;
+
+    return h[i] + (float)d / (n[i + 1] - n[i - 1]) *
+                      ((n[i] - n[i - 1] + d) * (h[i + 1] - h[i]) / (n[i + 1] - n[i]) +
+                       (n[i + 1] - n[i] - d) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+}
+
+static float LapStats_Linear(LapStats_Quantile *q, int i, int d) {
+    return q->heights[i] + d * (q->heights[i + d] - q->heights[i]) / (q->positions[i + d] - q->positions[i]);
+}
+
+static void LapStats_QuantileAdd(LapStats_Quantile *q, float x) {
+    float *h = q->heights;
+    int *n = q->positions;
+
+    // first laps are kept sorted as they are, they become initial markers
+    if (q->count < LAP_STATS_MARKERS) {
+        int i = q->count++;
+        while (i > 0 && h[i - 1] > x) {
+            h[i] = h[i - 1];
+            i--;
+        }
+        h[i] = x;
+        return;
+    }
+    q->count++;
+
+    int cell;
+    if (x < h[0]) {
+        h[0] = x;
+        cell = 0;
+    } else if (x >= h[LAP_STATS_MARKERS - 1]) {
+        h[LAP_STATS_MARKERS - 1] = x;
+        cell = LAP_STATS_MARKERS - 2;
+    } else {
+        cell = 0;
+        while (x >= h[cell + 1]) {
+            cell++;
+        }
+    }
+
+    for (int i = cell + 1; i < LAP_STATS_MARKERS; i++) {
+        n[i]++;
+    }
+    for (int i = 0; i < LAP_STATS_MARKERS; i++) {
+        q->desired[i] += q->increments[i];
+    }
+
+    // middle markers move by one position towards desired one, height follows piecewise parabola
+    for (int i = 1; i < LAP_STATS_MARKERS - 1; i++) {
+        float delta = q->desired[i] - n[i];
+        if ((delta >= 1 && n[i + 1] - n[i] > 1) || (delta <= -1 && n[i - 1] - n[i] < -1)) {
+            int d = delta > 0 ? 1 : -1;
+            float height = LapStats_Parabolic(q, i, d);
+            if (height <= h[i - 1] || height >= h[i + 1]) {
+                height = LapStats_Linear(q, i, d);
+            }
+            h[i] = height;
+            n[i] += d;
+        }
+    }
+}
+
+static uint32_t LapStats_QuantileGet(LapStats_Quantile *q) {
+    if (q->count == 0) {
+        return 0;
+    }
+
+    // until markers are initialized quantile is exact, nearest rank of sorted laps
+    if (q->count <= LAP_STATS_MARKERS) {
+        return q->heights[(int)(q->p * (q->count - 1) + 0.5f)];
+    }
+    return q->heights[LAP_STATS_MARKERS / 2];
+}
+
+void LapStats_Reset() {
+    count = 0;
+    best = 0;
+    worst = 0;
+    mean = 0;
+    m2 = 0;
+    LapStats_QuantileReset(&median, 0.5f);
+    LapStats_QuantileReset(&p90, 0.9f);
+}
+
+void LapStats_Add(uint32_t lapTime) {
+    if (count == 0 || lapTime < best) {
+        best = lapTime;
+    }
+    if (count == 0 || lapTime > worst) {
+        worst = lapTime;
+    }
+
+    count++;
+    float delta = lapTime - mean;
+    mean += delta / count;
+    m2 += delta * (lapTime - mean);
+
+    LapStats_QuantileAdd(&median, lapTime);
+    LapStats_QuantileAdd(&p90, lapTime);
+}
+
+int LapStats_GetCount() {
+    return count;
+}
+
+uint32_t LapStats_GetBest() {
+    return best;
+}
+
+uint32_t LapStats_GetWorst() {
+    return worst;
+}
+
+uint32_t LapStats_GetMean() {
+    return mean + 0.5f;
+}
+
+// sample standard deviation, 0 until there are two laps
+uint32_t LapStats_GetStdDev() {
+    if (count < 2) {
+        return 0;
+    }
+    return sqrtf(m2 / (count - 1)) + 0.5f;
+}
+
+uint32_t LapStats_GetMedian() {
+    return LapStats_QuantileGet(&median);
+}
+
+uint32_t LapStats_GetP90() {
+    return LapStats_QuantileGet(&p90);
+}
+
+static uint8_t *LapStats_WriteUint32(uint8_t *p, uint32_t value) {
+    *p++ = value;
+    *p++ = value >> 8;
+    *p++ = value >> 16;
+    *p++ = value >> 24;
+    return p;
+}
+
+int LapStats_GetReport(uint8_t *report, int maxLen) {
+    if (maxLen < LAP_STATS_REPORT_LEN) {
+        return 0;
+    }
+
+    uint8_t *p = report;
+    *p++ = count;
+    *p++ = count >> 8;
+    p = LapStats_WriteUint32(p, LapStats_GetBest());
+    p = LapStats_WriteUint32(p, LapStats_GetWorst());
+    p = LapStats_WriteUint32(p, LapStats_GetMean());
+    p = LapStats_WriteUint32(p, LapStats_GetStdDev());
+    p = LapStats_WriteUint32(p, LapStats_GetMedian());
+    p = LapStats_WriteUint32(p, LapStats_GetP90());
+
+    return p - report;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef LAP_STATS_H
+#define LAP_STATS_H
+
+#include <stdint.h>
+
+// Lap statistics report, all little endian: laps count (u16), then best, worst, mean, standard deviation,
+// median and 90th percentile lap time in ticks (u32 each). Keep in sync with clients.
+#define LAP_STATS_REPORT_LEN (2 + 6 * 4)
+
+void LapStats_Reset();
+void LapStats_Add(uint32_t lapTime);
+int LapStats_GetCount();
+uint32_t LapStats_GetBest();
+uint32_t LapStats_GetWorst();
+uint32_t LapStats_GetMean();
+uint32_t LapStats_GetStdDev();
+uint32_t LapStats_GetMedian();
+uint32_t LapStats_GetP90();
+int LapStats_GetReport(uint8_t *report, int maxLen);
+
+#endif
\ No newline at end of file
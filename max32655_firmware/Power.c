@@ -0,0 +1,178 @@
+/* self */
+#include "Power.h"
+
+/* project */
+#include "BLE.h"
+#include "Button.h"
+#include "DisplayBus.h"
+#include "I2CBus.h"
+#include "TimeSync.h"
+#include "Trace.h"
+
+/* stdlib */
+#include <stdint.h>
+
+/* max32655 + cordio */
+#include <lp.h>
+#include <max32655.h>
+#include <pal_sys.h>
+#include <wsf_cs.h>
+#include <wsf_os.h>
+#include <wsf_timer.h>
+#include <wut.h>
+
+// below this WSF timer deadline deep sleep entry/exit is not worth it
+#define POWER_DEEPSLEEP_MIN_MS 5
+
+static uint32_t residencyTicks[POWER_STATE_COUNT];
+static uint32_t lastTransitionTime;
+static uint32_t statsStartTime;
+static uint32_t wakeupCount;
+static int isDeepSleepAllowed = 1;
+
+static void Power_AccountResidency(int state) {
+    uint32_t now = Power_GetTime();
+    residencyTicks[state] += now - lastTransitionTime;
+    lastTransitionTime = now;
+}
+
+static int Power_SelectState() {
+    bool_t isTimerRunning;
+    wsfTimerTicks_t nextExpiration;
+
+    if (PalSysIsBusy()) {
+        return POWER_STATE_ACTIVE;
+    }
+
+    nextExpiration = WsfTimerNextExpiration(&isTimerRunning);
+    if (isTimerRunning && nextExpiration == 0) {
+        return POWER_STATE_ACTIVE;
+    }
+
+    // I2C and display DMA transfers and TIME_TIMER need peripheral clocks running
+    if (!isDeepSleepAllowed || I2CBus_IsBusy() || DisplayBus_IsBusy() || Trace_IsUartBusy()) {
+        return POWER_STATE_SLEEP;
+    }
+
+    // connected host and host clock mapping rely on TIME_TIMER ticks, which would stand still in deep sleep
+    if (BLE_GetConnectionsCount() > 0 || TimeSync_IsSynchronized()) {
+        return POWER_STATE_SLEEP;
+    }
+
+    if (isTimerRunning && nextExpiration * WSF_MS_PER_TICK < POWER_DEEPSLEEP_MIN_MS) {
+        return POWER_STATE_SLEEP;
+    }
+
+    return POWER_STATE_DEEPSLEEP;
+}
+
+static void Power_EnableWakeupSources() {
+    mxc_gpio_cfg_t wakeupPins;
+    wakeupPins.port = BUTTON_GPIO;
+    wakeupPins.mask = BUTTON_BTNR_PIN | BUTTON_BTNL_PIN | BUTTON_BTNM_PIN;
+    wakeupPins.func = MXC_GPIO_FUNC_IN;
+    wakeupPins.pad = MXC_GPIO_PAD_NONE;
+    wakeupPins.vssel = MXC_GPIO_VSSEL_VDDIOH;
+
+    MXC_LP_EnableGPIOWakeup(&wakeupPins);
+    MXC_GPIO_SetWakeEn(BUTTON_GPIO, wakeupPins.mask);
+
+    // WUT drives both WSF timers and the BLE baseband schedule, so it wakes us for the radio too
+    MXC_LP_EnableWUTAlarmWakeup();
+}
+
+static void Power_Sleep() {
+    WSF_CS_INIT(cs);
+
+    WSF_CS_ENTER(cs);
+
+    if (!wsfOsReadyToSleep()) {
+        WSF_CS_EXIT(cs);
+        return;
+    }
+
+    int state = Power_SelectState();
+    if (state == POWER_STATE_ACTIVE) {
+        WSF_CS_EXIT(cs);
+        return;
+    }
+
+    Power_AccountResidency(POWER_STATE_ACTIVE);
+    uint32_t sleepStart = lastTransitionTime;
+
+    if (state == POWER_STATE_DEEPSLEEP) {
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    }
+
+    // programs wakeup at the next WSF timer expiration and executes WFI
+    WsfTimerSleep();
+
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+    Power_AccountResidency(state);
+    wakeupCount++;
+
+    Trace_Event(TRACE_EVENT_SLEEP, state, lastTransitionTime - sleepStart);
+
+    WSF_CS_EXIT(cs);
+}
+
+void Power_EnterMainLoop() {
+    statsStartTime = Power_GetTime();
+    lastTransitionTime = statsStartTime;
+
+    Power_EnableWakeupSources();
+
+    while (1) {
+        WsfTimerSleepUpdate();
+        wsfOsDispatcher();
+
+        Trace_DrainUart();
+
+        if (wsfOsReadyToSleep()) {
+            Power_Sleep();
+        }
+    }
+}
+
+void Power_SetDeepSleepAllowed(int isAllowed) {
+    isDeepSleepAllowed = isAllowed;
+}
+
+// WUT is also the time base of WSF timers and BLE schedule, Cordio PAL runs it without prescaler
+uint32_t Power_GetTime() {
+    return MXC_WUT_GetCount();
+}
+
+uint32_t Power_GetResidency(int state) {
+    if (state < 0 || state >= POWER_STATE_COUNT) {
+        return 0;
+    }
+    return residencyTicks[state];
+}
+
+int Power_GetResidencyPercent(int state) {
+    if (state < 0 || state >= POWER_STATE_COUNT) {
+        return 0;
+    }
+
+    uint32_t elapsed = Power_GetTime() - statsStartTime;
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    return (int)((uint64_t)residencyTicks[state] * 100 / elapsed);
+}
+
+uint32_t Power_GetWakeupCount() {
+    return wakeupCount;
+}
+
+void Power_ResetStats() {
+    for (int i = 0; i < POWER_STATE_COUNT; i++) {
+        residencyTicks[i] = 0;
+    }
+    wakeupCount = 0;
+    statsStartTime = Power_GetTime();
+    lastTransitionTime = statsStartTime;
+}
\ No newline at end of file
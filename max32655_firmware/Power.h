@@ -0,0 +1,24 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+// residency is counted on WUT, which runs from 32 kHz crystal also in deep sleep where TIME_TIMER stops
+#define POWER_TICK_PER_SEC 32768
+
+enum {
+    POWER_STATE_ACTIVE,
+    POWER_STATE_SLEEP,
+    POWER_STATE_DEEPSLEEP,
+    POWER_STATE_COUNT
+};
+
+void Power_EnterMainLoop();
+void Power_SetDeepSleepAllowed(int isAllowed);
+uint32_t Power_GetTime();
+uint32_t Power_GetResidency(int state);
+int Power_GetResidencyPercent(int state);
+uint32_t Power_GetWakeupCount();
+void Power_ResetStats();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,272 @@
+/* self */
+#include "Profile.h"
+
+/* project */
+#include "Power.h"
+
+/* stdlib */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* max32655 + cordio */
+#if !PROFILE_VIRTUAL_CLOCK
+#include <max32655.h>
+#endif
+#include <wsf_os.h>
+#include <wsf_timer.h>
+#include <wsf_trace.h>
+
+typedef struct {
+    wsfEventHandler_t handler;
+    Profile_HandlerStats stats;
+} Profile_Handler;
+
+typedef struct {
+    wsfTimer_t *timer;
+    uint32_t deadline;
+    int isArmed;
+} Profile_Timer;
+
+static Profile_Handler handlers[PROFILE_MAX_HANDLERS];
+static int handlersCount = 0;
+
+static Profile_Timer timers[PROFILE_MAX_TIMERS];
+
+static uint32_t lastWakeupCount = 0;
+
+static const uint32_t latencyBucketLimits[PROFILE_LATENCY_BUCKETS - 1] = PROFILE_LATENCY_BUCKET_LIMITS_MS;
+
+#if PROFILE_VIRTUAL_CLOCK
+static uint32_t virtualTime = 0;
+static uint32_t virtualCycles = 0;
+
+void Profile_AdvanceVirtualClock(uint32_t ticks, uint32_t cycles) {
+    virtualTime += ticks;
+    virtualCycles += cycles;
+}
+
+static uint32_t Profile_GetTime() {
+    return virtualTime;
+}
+
+static uint32_t Profile_GetCycles() {
+    return virtualCycles;
+}
+#else
+// deadlines and dispatch are compared on WUT, TIME_TIMER stops in deep sleep which is when timers expire
+static uint32_t Profile_GetTime() {
+    return Power_GetTime();
+}
+
+static uint32_t Profile_GetCycles() {
+    return DWT->CYCCNT;
+}
+#endif
+
+static Profile_Timer *Profile_FindTimer(wsfMsgHdr_t *pMsg) {
+    for (int i = 0; i < PROFILE_MAX_TIMERS; i++) {
+        if (timers[i].timer != NULL && &timers[i].timer->msg == pMsg) {
+            return &timers[i];
+        }
+    }
+    return NULL;
+}
+
+static void Profile_RecordLatency(Profile_HandlerStats *stats, wsfMsgHdr_t *pMsg, uint32_t now) {
+    Profile_Timer *timer = Profile_FindTimer(pMsg);
+    if (timer == NULL || !timer->isArmed) {
+        return;
+    }
+
+    timer->isArmed = 0;
+
+    // timer may fire slightly early due to ms to tick rounding
+    int32_t latency = (int32_t)(now - timer->deadline);
+    if (latency < 0) {
+        latency = 0;
+    }
+
+    int bucket = 0;
+    while (bucket < PROFILE_LATENCY_BUCKETS - 1 && (uint32_t)latency >= latencyBucketLimits[bucket] * POWER_TICK_PER_SEC / 1000) {
+        bucket++;
+    }
+
+    if (stats->latency[bucket] < UINT16_MAX) {
+        stats->latency[bucket]++;
+    }
+}
+
+static void Profile_Dispatch(int index, wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    Profile_Handler *h = &handlers[index];
+
+    uint32_t wakeupCount = Power_GetWakeupCount();
+    if (wakeupCount != lastWakeupCount) {
+        // first handler dispatched after wakeup is the one which woke the MCU up
+        lastWakeupCount = wakeupCount;
+        h->stats.wakeups++;
+    }
+
+    if (pMsg != NULL) {
+        Profile_RecordLatency(&h->stats, pMsg, Profile_GetTime());
+    }
+
+    uint32_t start = Profile_GetCycles();
+    h->handler(event, pMsg);
+    uint32_t cycles = Profile_GetCycles() - start;
+
+    h->stats.invocations++;
+    h->stats.totalCycles += cycles;
+    if (cycles > h->stats.maxCycles) {
+        h->stats.maxCycles = cycles;
+    }
+}
+
+// WSF does not pass handler ID to the handler, so every slot needs its own entry point
+#define PROFILE_TRAMPOLINE(n)                                                      \
+    static void Profile_Trampoline##n(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {   \
+        Profile_Dispatch(n, event, pMsg);                                          \
+    }
+
+PROFILE_TRAMPOLINE(0)
+PROFILE_TRAMPOLINE(1)
+PROFILE_TRAMPOLINE(2)
+PROFILE_TRAMPOLINE(3)
+PROFILE_TRAMPOLINE(4)
+PROFILE_TRAMPOLINE(5)
+PROFILE_TRAMPOLINE(6)
+PROFILE_TRAMPOLINE(7)
+PROFILE_TRAMPOLINE(8)
+PROFILE_TRAMPOLINE(9)
+
+static const wsfEventHandler_t trampolines[PROFILE_MAX_HANDLERS] = {
+    Profile_Trampoline0,
+    Profile_Trampoline1,
+    Profile_Trampoline2,
+    Profile_Trampoline3,
+    Profile_Trampoline4,
+    Profile_Trampoline5,
+    Profile_Trampoline6,
+    Profile_Trampoline7,
+    Profile_Trampoline8,
+    Profile_Trampoline9,
+};
+
+void Profile_Init() {
+#if !PROFILE_VIRTUAL_CLOCK
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+wsfHandlerId_t Profile_SetNextHandler(wsfEventHandler_t handler, const char *name) {
+    if (handlersCount >= PROFILE_MAX_HANDLERS) {
+        APP_TRACE_WARN1("Profile_SetNextHandler: no free slot for %s, handler is not profiled", name);
+        return WsfOsSetNextHandler(handler);
+    }
+
+    Profile_Handler *h = &handlers[handlersCount];
+    h->handler = handler;
+    h->stats.name = name;
+    h->stats.handlerId = WsfOsSetNextHandler(trampolines[handlersCount]);
+
+    handlersCount++;
+
+    return h->stats.handlerId;
+}
+
+void Profile_TimerStartMs(wsfTimer_t *timer, wsfTimerTicks_t ms) {
+    Profile_Timer *slot = NULL;
+
+    for (int i = 0; i < PROFILE_MAX_TIMERS; i++) {
+        if (timers[i].timer == timer) {
+            slot = &timers[i];
+            break;
+        }
+        if (timers[i].timer == NULL && slot == NULL) {
+            slot = &timers[i];
+        }
+    }
+
+    if (slot != NULL) {
+        slot->timer = timer;
+        slot->deadline = Profile_GetTime() + (uint32_t)ms * POWER_TICK_PER_SEC / 1000;
+        slot->isArmed = 1;
+    }
+
+    WsfTimerStartMs(timer, ms);
+}
+
+// stopped timer is disarmed, so message of its earlier expiry still in queue is not counted as late dispatch
+void Profile_TimerStop(wsfTimer_t *timer) {
+    for (int i = 0; i < PROFILE_MAX_TIMERS; i++) {
+        if (timers[i].timer == timer) {
+            timers[i].isArmed = 0;
+            break;
+        }
+    }
+
+    WsfTimerStop(timer);
+}
+
+int Profile_GetHandlerStats(int index, Profile_HandlerStats *stats) {
+    if (index < 0 || index >= handlersCount) {
+        return 0;
+    }
+
+    *stats = handlers[index].stats;
+    return 1;
+}
+
+static uint8_t *Profile_WriteUint16(uint8_t *p, uint16_t value) {
+    *p++ = value;
+    *p++ = value >> 8;
+    return p;
+}
+
+static uint8_t *Profile_WriteUint32(uint8_t *p, uint32_t value) {
+    p = Profile_WriteUint16(p, value);
+    return Profile_WriteUint16(p, value >> 16);
+}
+
+int Profile_GetReport(uint8_t *report, int maxLen) {
+    uint8_t *p = report;
+
+    for (int i = 0; i < handlersCount; i++) {
+        if ((p - report) + PROFILE_RECORD_LEN > maxLen) {
+            break;
+        }
+
+        Profile_HandlerStats *stats = &handlers[i].stats;
+        uint32_t avgCycles = stats->invocations ? (uint32_t)(stats->totalCycles / stats->invocations) : 0;
+
+        // handler ID followed by first 3 chars of name, zero padded
+        *p++ = stats->handlerId;
+        for (int j = 0; j < 3; j++) {
+            *p++ = (stats->name && j < strlen(stats->name)) ? stats->name[j] : 0;
+        }
+
+        p = Profile_WriteUint32(p, stats->invocations);
+        p = Profile_WriteUint32(p, stats->wakeups);
+        p = Profile_WriteUint32(p, stats->maxCycles);
+        p = Profile_WriteUint32(p, avgCycles);
+
+        for (int j = 0; j < PROFILE_LATENCY_BUCKETS; j++) {
+            p = Profile_WriteUint16(p, stats->latency[j]);
+        }
+    }
+
+    return p - report;
+}
+
+void Profile_ResetStats() {
+    for (int i = 0; i < handlersCount; i++) {
+        Profile_HandlerStats *stats = &handlers[i].stats;
+        stats->invocations = 0;
+        stats->wakeups = 0;
+        stats->maxCycles = 0;
+        stats->totalCycles = 0;
+        memset(stats->latency, 0, sizeof(stats->latency));
+    }
+}
\ No newline at end of file
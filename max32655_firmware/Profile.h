@@ -0,0 +1,47 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#include <wsf_os.h>
+#include <wsf_timer.h>
+
+#define PROFILE_MAX_HANDLERS 10
+#define PROFILE_MAX_TIMERS 12
+
+// Host builds have neither DWT nor WUT, there cycles and ticks come from virtual clock which the simulation
+// advances with Profile_AdvanceVirtualClock, so profiles of simulated runs are deterministic.
+#ifndef PROFILE_VIRTUAL_CLOCK
+#define PROFILE_VIRTUAL_CLOCK 0
+#endif
+
+// expiry-to-dispatch latency buckets upper bounds in ms, last bucket is open
+#define PROFILE_LATENCY_BUCKETS 6
+#define PROFILE_LATENCY_BUCKET_LIMITS_MS {1, 2, 5, 10, 50}
+
+#define PROFILE_RECORD_LEN (4 + 4 * 4 + PROFILE_LATENCY_BUCKETS * 2)
+#define PROFILE_REPORT_MAX_LEN (PROFILE_MAX_HANDLERS * PROFILE_RECORD_LEN)
+
+typedef struct {
+    wsfHandlerId_t handlerId;
+    const char *name;
+    uint32_t invocations;
+    uint32_t wakeups;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint16_t latency[PROFILE_LATENCY_BUCKETS];
+} Profile_HandlerStats;
+
+void Profile_Init();
+wsfHandlerId_t Profile_SetNextHandler(wsfEventHandler_t handler, const char *name);
+void Profile_TimerStartMs(wsfTimer_t *timer, wsfTimerTicks_t ms);
+void Profile_TimerStop(wsfTimer_t *timer);
+int Profile_GetHandlerStats(int index, Profile_HandlerStats *stats);
+int Profile_GetReport(uint8_t *report, int maxLen);
+void Profile_ResetStats();
+
+#if PROFILE_VIRTUAL_CLOCK
+void Profile_AdvanceVirtualClock(uint32_t ticks, uint32_t cycles);
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+/* self */
+#include "Raster.h"
+
+/* stdlib */
+#include <stdint.h>
+#include <string.h>
+
+#define RASTER_REPEAT(byte) (0x01010101u * (uint8_t)(byte))
+
+// memcpy keeps word access legal for any alignment, compiler turns it into single load or store
+static inline uint32_t Raster_Load(const uint8_t *p) {
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static inline void Raster_Store(uint8_t *p, uint32_t word) {
+    memcpy(p, &word, sizeof(word));
+}
+
+// dst = (dst & andMask) ^ xorMask, covers fill (0, value), or (~value, value), invert (0xFF, 0xFF) and their
+// combinations in one pass
+void Raster_Rop(uint8_t *p, int len, uint8_t andMask, uint8_t xorMask) {
+    uint32_t andWord = RASTER_REPEAT(andMask);
+    uint32_t xorWord = RASTER_REPEAT(xorMask);
+    int i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        Raster_Store(p + i, (Raster_Load(p + i) & andWord) ^ xorWord);
+    }
+    for (; i < len; i++) {
+        p[i] = (p[i] & andMask) ^ xorMask;
+    }
+}
+
+// pixels move within their own column, bits shifted out of byte are dropped
+void Raster_ShiftLeft(uint8_t *p, int len, int shift) {
+    uint8_t keep = 0xFF << shift;
+    uint32_t keepWord = RASTER_REPEAT(keep);
+    int i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        Raster_Store(p + i, (Raster_Load(p + i) << shift) & keepWord);
+    }
+    for (; i < len; i++) {
+        p[i] = p[i] << shift;
+    }
+}
+
+void Raster_ShiftRight(uint8_t *p, int len, int shift) {
+    uint8_t keep = 0xFF >> shift;
+    uint32_t keepWord = RASTER_REPEAT(keep);
+    int i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        Raster_Store(p + i, (Raster_Load(p + i) >> shift) & keepWord);
+    }
+    for (; i < len; i++) {
+        p[i] = p[i] >> shift;
+    }
+}
+
+// pixels set in mask are taken from src, others stay
+void Raster_BlitMasked(uint8_t *dst, const uint8_t *src, const uint8_t *mask, int len) {
+    int i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        uint32_t maskWord = Raster_Load(mask + i);
+        Raster_Store(dst + i, (Raster_Load(dst + i) & ~maskWord) | (Raster_Load(src + i) & maskWord));
+    }
+    for (; i < len; i++) {
+        dst[i] = (dst[i] & ~mask[i]) | (src[i] & mask[i]);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdint.h>
+
+// Raster operations on a run of display columns, each byte is 8 vertical pixels of one row.
+// Runs are processed 32 bits (4 columns) at a time, so they do not depend on MSDK and build on host too.
+
+void Raster_Rop(uint8_t *p, int len, uint8_t andMask, uint8_t xorMask);
+void Raster_ShiftLeft(uint8_t *p, int len, int shift);
+void Raster_ShiftRight(uint8_t *p, int len, int shift);
+void Raster_BlitMasked(uint8_t *dst, const uint8_t *src, const uint8_t *mask, int len);
+
+#endif
\ No newline at end of file
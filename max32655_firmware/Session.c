@@ -0,0 +1,165 @@
+/* self */
+#include "Session.h"
+
+/* project */
+#include "GUI.h"
+#include "TimeSync.h"
+
+/* stdlib */
+#include <stdint.h>
+#include <string.h>
+
+/* max32655 + cordio */
+#include <mxc_errors.h>
+
+#define SESSION_CRC_POLYNOMIAL 0xEDB88320
+
+// bitwise variant, whole session is at most ~1.3 kB, so table would cost more flash than time it saves
+static uint32_t Session_UpdateCrc(uint32_t crc, const uint8_t *data, int len) {
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (SESSION_CRC_POLYNOMIAL & -(crc & 1));
+        }
+    }
+    return crc;
+}
+
+static uint8_t *Session_PutUint16(uint8_t *p, uint16_t value) {
+    *p++ = value;
+    *p++ = value >> 8;
+    return p;
+}
+
+static uint8_t *Session_PutUint32(uint8_t *p, uint32_t value) {
+    *p++ = value;
+    *p++ = value >> 8;
+    *p++ = value >> 16;
+    *p++ = value >> 24;
+    return p;
+}
+
+static uint8_t *Session_PutUint64(uint8_t *p, uint64_t value) {
+    p = Session_PutUint32(p, value);
+    return Session_PutUint32(p, value >> 32);
+}
+
+static int Session_PutVarint(uint8_t *p, uint32_t value) {
+    int len = 0;
+
+    while (value >= 0x80) {
+        p[len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    p[len++] = value;
+    return len;
+}
+
+void Session_Begin(Session_Encoder *encoder, const uint8_t *deviceAddress) {
+    uint64_t hostTime = 0;
+    uint32_t deviceTick = 0;
+    int32_t drift = 0;
+    uint8_t flags = 0;
+
+    if (GUI_IsRunning()) {
+        flags |= SESSION_FLAG_RUNNING;
+    }
+    if (TimeSync_IsSynchronized()) {
+        flags |= SESSION_FLAG_SYNCHRONIZED;
+        TimeSync_GetMapping(&hostTime, &deviceTick, &drift);
+    }
+
+    encoder->startTick = GUI_GetStartTick();
+    encoder->lapCount = GUI_GetLapCount();
+
+    uint8_t *p = encoder->header;
+    *p++ = 'S';
+    *p++ = 'W';
+    *p++ = 'S';
+    *p++ = 'N';
+    *p++ = SESSION_VERSION;
+    *p++ = SESSION_HEADER_LEN;
+    *p++ = flags;
+    *p++ = 0;
+    memcpy(p, deviceAddress, SESSION_DEVICE_ADDRESS_LEN);
+    p += SESSION_DEVICE_ADDRESS_LEN;
+    p = Session_PutUint16(p, encoder->lapCount);
+    p = Session_PutUint32(p, encoder->startTick);
+    p = Session_PutUint32(p, GUI_GetElapsedTime());
+    p = Session_PutUint64(p, hostTime);
+    p = Session_PutUint32(p, deviceTick);
+    Session_PutUint32(p, drift);
+
+    encoder->stage = SESSION_STAGE_HEADER;
+    encoder->lapIndex = 0;
+    encoder->offset = 0;
+    encoder->crc = 0xFFFFFFFF;
+    encoder->pendingLen = 0;
+    encoder->pendingPos = 0;
+}
+
+// produces next piece of session into pending buffer, returns its length, 0 at end
+static int Session_Fill(Session_Encoder *encoder) {
+    switch (encoder->stage) {
+        case SESSION_STAGE_HEADER:
+            memcpy(encoder->pending, encoder->header, SESSION_HEADER_LEN);
+            encoder->pendingLen = SESSION_HEADER_LEN;
+            encoder->stage = SESSION_STAGE_LAPS;
+            break;
+
+        case SESSION_STAGE_LAPS:
+            if (encoder->lapIndex < encoder->lapCount) {
+                // laps captured at begin are gone once stopwatch is started again or reset
+                if (GUI_GetStartTick() != encoder->startTick || GUI_GetLapCount() < encoder->lapCount) {
+                    return E_BAD_STATE;
+                }
+
+                encoder->pendingLen = Session_PutVarint(encoder->pending, GUI_GetLapTime(encoder->lapIndex++));
+                break;
+            }
+            encoder->stage = SESSION_STAGE_CRC;
+            // fall through
+
+        case SESSION_STAGE_CRC:
+            Session_PutUint32(encoder->pending, encoder->crc ^ 0xFFFFFFFF);
+            encoder->pendingLen = SESSION_CRC_LEN;
+            encoder->pendingPos = 0;
+            encoder->stage = SESSION_STAGE_END;
+            return encoder->pendingLen;
+
+        default:
+            return 0;
+    }
+
+    encoder->crc = Session_UpdateCrc(encoder->crc, encoder->pending, encoder->pendingLen);
+    encoder->pendingPos = 0;
+    return encoder->pendingLen;
+}
+
+// returns number of bytes, 0 at end of session or E_BAD_STATE when laps were overwritten meanwhile
+int Session_Read(Session_Encoder *encoder, uint8_t *buffer, int maxLen) {
+    int len = 0;
+
+    while (len < maxLen) {
+        if (encoder->pendingPos == encoder->pendingLen) {
+            int status = Session_Fill(encoder);
+            if (status < 0) {
+                return status;
+            }
+            if (status == 0) {
+                break;
+            }
+        }
+
+        int count = encoder->pendingLen - encoder->pendingPos;
+        if (count > maxLen - len) {
+            count = maxLen - len;
+        }
+        memcpy(buffer + len, encoder->pending + encoder->pendingPos, count);
+        encoder->pendingPos += count;
+        len += count;
+    }
+
+    encoder->offset += len;
+    return len;
+}
\ No newline at end of file
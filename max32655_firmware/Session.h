@@ -0,0 +1,47 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdint.h>
+
+// Binary session file, all little endian, keep in sync with tools/session_decode.c
+//   magic "SWSN", version (u8), header length (u8), flags (u8), reserved (u8), device address (6 bytes),
+//   laps count (u16), start tick (u32), elapsed ticks (u32), time sync host time (u64), device tick (u32)
+//   and drift in ppb (i32), then lap times as unsigned LEB128 varints, CRC-32 (IEEE) of all preceding bytes.
+// Lap time is difference of consecutive lap offsets, so typical lap takes 3 bytes instead of 4.
+#define SESSION_VERSION 1
+#define SESSION_HEADER_LEN 40
+#define SESSION_DEVICE_ADDRESS_LEN 6
+#define SESSION_CRC_LEN 4
+
+#define SESSION_FLAG_RUNNING 0x01
+#define SESSION_FLAG_SYNCHRONIZED 0x02
+
+// largest single piece produced at once, header
+#define SESSION_PENDING_MAX SESSION_HEADER_LEN
+
+enum {
+    SESSION_STAGE_HEADER,
+    SESSION_STAGE_LAPS,
+    SESSION_STAGE_CRC,
+    SESSION_STAGE_END,
+};
+
+// Session is encoded on the fly while it is read, header captured at begin is the only copy kept.
+// Laps are read from GUI as they are reached, they never change until stopwatch is started again or reset.
+typedef struct {
+    uint8_t header[SESSION_HEADER_LEN];
+    uint32_t startTick;
+    uint16_t lapCount;
+    uint16_t lapIndex;
+    uint8_t stage;
+    uint32_t offset;
+    uint32_t crc;
+    uint8_t pending[SESSION_PENDING_MAX];
+    uint8_t pendingLen;
+    uint8_t pendingPos;
+} Session_Encoder;
+
+void Session_Begin(Session_Encoder *encoder, const uint8_t *deviceAddress);
+int Session_Read(Session_Encoder *encoder, uint8_t *buffer, int maxLen);
+
+#endif
\ No newline at end of file
@@ -1,11 +1,14 @@
 /* project */
-#include "time.h"
+#include "Time.h"
 
 /* max32655 + mbed + cordio */
 #include <max32655.h>
+#include <nvic_table.h>
 #include <tmr.h>
 #include <wsf_trace.h>
 
+static void (*alarmCallback)();
+
 void Time_Init() {
     int status;
 
@@ -24,4 +27,56 @@ void Time_Init() {
     }
 
     MXC_TMR_Start(TIME_TIMER);
+}
+
+static void Time_AlarmInterruptHandler() {
+    MXC_TMR_ClearFlags(TIME_ALARM_TIMER);
+    MXC_TMR_Stop(TIME_ALARM_TIMER);
+
+    if (alarmCallback) {
+        alarmCallback();
+    }
+}
+
+// callback is called from interrupt when TIME_TIMER reaches tick, tick must be in future
+int Time_StartAlarm(uint32_t tick, void (*callback)()) {
+    int status;
+
+    int32_t remaining = (int32_t)(tick - TIME_TIMER->cnt);
+    if (remaining <= 0) {
+        return E_BAD_PARAM;
+    }
+
+    Time_StopAlarm();
+
+    mxc_tmr_cfg_t cfg;
+    cfg.pres = TMR_PRES_1;
+    cfg.mode = TMR_MODE_ONESHOT;
+    cfg.bitMode = TMR_BIT_MODE_32;
+    cfg.clock = MXC_TMR_32K_CLK;
+    cfg.cmp_cnt = remaining;
+    cfg.pol = 0;
+
+    status = MXC_TMR_Init(TIME_ALARM_TIMER, &cfg, FALSE);
+    if (status) {
+        return status;
+    }
+
+    alarmCallback = callback;
+
+    MXC_NVIC_SetVector(TIME_ALARM_IRQn, Time_AlarmInterruptHandler);
+    NVIC_ClearPendingIRQ(TIME_ALARM_IRQn);
+    NVIC_EnableIRQ(TIME_ALARM_IRQn);
+    MXC_TMR_EnableInt(TIME_ALARM_TIMER);
+    MXC_TMR_Start(TIME_ALARM_TIMER);
+
+    return E_NO_ERROR;
+}
+
+void Time_StopAlarm() {
+    MXC_TMR_Stop(TIME_ALARM_TIMER);
+    MXC_TMR_DisableInt(TIME_ALARM_TIMER);
+    NVIC_DisableIRQ(TIME_ALARM_IRQn);
+    MXC_TMR_ClearFlags(TIME_ALARM_TIMER);
+    alarmCallback = NULL;
 }
\ No newline at end of file
@@ -8,6 +8,12 @@
 #define TIME_TICK_PER_MSEC 33
 #define TIME_TIMER MXC_TMR3
 
+// one-shot timer clocked from the same 32 kHz source, used for events scheduled on TIME_TIMER ticks
+#define TIME_ALARM_TIMER MXC_TMR2
+#define TIME_ALARM_IRQn TMR2_IRQn
+
 void Time_Init();
+int Time_StartAlarm(uint32_t tick, void (*callback)());
+void Time_StopAlarm();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+/* self */
+#include "TimeSync.h"
+
+/* project */
+#include "Time.h"
+
+/* stdlib */
+#include <stdint.h>
+
+// signed tick difference to anchor covers only ±18 h, host re-anchors on every sync round
+#define TIME_SYNC_MAX_AGE_TICKS (12UL * 3600 * TIME_TICK_PER_SEC)
+
+// host clock = anchorHostTime + device elapsed * (1 + driftPpb / 1e9)
+static uint64_t anchorHostTime;
+static uint32_t anchorDeviceTick;
+static int32_t driftPpb;
+static int isSynchronized = 0;
+
+static int64_t TimeSync_TicksToUs(int64_t ticks) {
+    return ticks * 1000000 / TIME_TICK_PER_SEC;
+}
+
+static int64_t TimeSync_UsToTicks(int64_t us) {
+    return us * TIME_TICK_PER_SEC / 1000000;
+}
+
+void TimeSync_SetMapping(uint64_t hostTime, uint32_t deviceTick, int32_t drift) {
+    anchorHostTime = hostTime;
+    anchorDeviceTick = deviceTick;
+    driftPpb = drift;
+    isSynchronized = 1;
+}
+
+// mapping expires well before anchor is out of range, after that deep sleep is allowed again
+int TimeSync_IsSynchronized() {
+    int32_t age = (int32_t)(TIME_TIMER->cnt - anchorDeviceTick);
+    if (isSynchronized && (age > (int32_t)TIME_SYNC_MAX_AGE_TICKS || age < -(int32_t)TIME_SYNC_MAX_AGE_TICKS)) {
+        isSynchronized = 0;
+    }
+    return isSynchronized;
+}
+
+uint64_t TimeSync_DeviceTickToHost(uint32_t tick) {
+    // signed difference keeps ticks before anchor working, it is valid within ±2^31 ticks (~18 hours)
+    int64_t deviceUs = TimeSync_TicksToUs((int32_t)(tick - anchorDeviceTick));
+    return anchorHostTime + deviceUs + deviceUs * driftPpb / 1000000000;
+}
+
+uint32_t TimeSync_HostToDeviceTick(uint64_t hostTime) {
+    int64_t hostUs = (int64_t)(hostTime - anchorHostTime);
+    int64_t deviceUs = hostUs - hostUs * driftPpb / 1000000000;
+    return anchorDeviceTick + (uint32_t)TimeSync_UsToTicks(deviceUs);
+}
+
+void TimeSync_GetMapping(uint64_t *hostTime, uint32_t *deviceTick, int32_t *drift) {
+    *hostTime = anchorHostTime;
+    *deviceTick = anchorDeviceTick;
+    *drift = driftPpb;
+}
\ No newline at end of file
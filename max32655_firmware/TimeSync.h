@@ -0,0 +1,14 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+
+// host time is in microseconds since 0001-01-01 UTC (.NET DateTime ticks / 10)
+
+void TimeSync_SetMapping(uint64_t hostTime, uint32_t deviceTick, int32_t drift);
+int TimeSync_IsSynchronized();
+uint64_t TimeSync_DeviceTickToHost(uint32_t tick);
+uint32_t TimeSync_HostToDeviceTick(uint64_t hostTime);
+void TimeSync_GetMapping(uint64_t *hostTime, uint32_t *deviceTick, int32_t *drift);
+
+#endif
\ No newline at end of file
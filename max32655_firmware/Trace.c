@@ -0,0 +1,193 @@
+/* self */
+#include "Trace.h"
+
+/* project */
+#include "Time.h"
+
+/* stdlib */
+#include <stdint.h>
+
+/* max32655 + cordio */
+#include <max32655.h>
+#include <uart.h>
+
+typedef struct {
+    uint32_t timestamp;
+    uint8_t sequence;
+    uint8_t event;
+    uint16_t arg0;
+    uint32_t arg1;
+} Trace_Record;
+
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_RECORDS - 1)
+
+static Trace_Record buffer[TRACE_BUFFER_RECORDS];
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+
+// lost records not yet reported to reader and total since boot
+static uint32_t pendingLost = 0;
+static uint32_t totalLost = 0;
+
+// end of records and lost count returned by last peek, they are dropped when reader confirms delivery
+static uint32_t peekEnd = 0;
+static uint32_t peekLost = 0;
+
+#if TRACE_UART_DRAIN
+static uint8_t uartFrame[2 + TRACE_RECORD_LEN];
+static int uartFrameLen = 0;
+static int uartFramePos = 0;
+#endif
+
+// called from interrupts too, so only PRIMASK protects head/tail
+void Trace_Event(uint8_t event, uint16_t arg0, uint32_t arg1) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    Trace_Record *r = &buffer[head & TRACE_BUFFER_MASK];
+    r->timestamp = TIME_TIMER->cnt;
+    r->sequence = head;
+    r->event = event;
+    r->arg0 = arg0;
+    r->arg1 = arg1;
+
+    head++;
+    if (head - tail > TRACE_BUFFER_RECORDS) {
+        tail++;
+        pendingLost++;
+        totalLost++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+static uint8_t *Trace_Serialize(uint8_t *p, Trace_Record *r) {
+    *p++ = r->timestamp;
+    *p++ = r->timestamp >> 8;
+    *p++ = r->timestamp >> 16;
+    *p++ = r->timestamp >> 24;
+    *p++ = r->sequence;
+    *p++ = r->event;
+    *p++ = r->arg0;
+    *p++ = r->arg0 >> 8;
+    *p++ = r->arg1;
+    *p++ = r->arg1 >> 8;
+    *p++ = r->arg1 >> 16;
+    *p++ = r->arg1 >> 24;
+    return p;
+}
+
+// removes oldest record, lost records are reported as synthetic TRACE_EVENT_LOST record first
+static int Trace_Pop(Trace_Record *r) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    int isAvailable = 1;
+
+    if (pendingLost) {
+        r->timestamp = TIME_TIMER->cnt;
+        r->sequence = tail - 1;
+        r->event = TRACE_EVENT_LOST;
+        r->arg0 = 0;
+        r->arg1 = pendingLost;
+        pendingLost = 0;
+    } else if (tail != head) {
+        *r = buffer[tail & TRACE_BUFFER_MASK];
+        tail++;
+    } else {
+        isAvailable = 0;
+    }
+
+    __set_PRIMASK(primask);
+
+    return isAvailable;
+}
+
+// copies oldest records without removing them, so read that is not delivered can be repeated
+int Trace_Peek(uint8_t *out, int maxLen) {
+    uint8_t *p = out;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    peekEnd = tail;
+    peekLost = 0;
+
+    if (pendingLost && TRACE_RECORD_LEN <= maxLen) {
+        Trace_Record r = {
+            .timestamp = TIME_TIMER->cnt,
+            .sequence = tail - 1,
+            .event = TRACE_EVENT_LOST,
+            .arg0 = 0,
+            .arg1 = pendingLost,
+        };
+        p = Trace_Serialize(p, &r);
+        peekLost = pendingLost;
+    }
+
+    while (peekEnd != head && (p - out) + TRACE_RECORD_LEN <= maxLen) {
+        p = Trace_Serialize(p, &buffer[peekEnd & TRACE_BUFFER_MASK]);
+        peekEnd++;
+    }
+
+    __set_PRIMASK(primask);
+
+    return p - out;
+}
+
+// records overwritten since peek already moved tail past them
+void Trace_ConsumePeeked() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if ((int32_t)(peekEnd - tail) > 0) {
+        tail = peekEnd;
+    }
+    pendingLost = pendingLost > peekLost ? pendingLost - peekLost : 0;
+    peekEnd = tail;
+    peekLost = 0;
+
+    __set_PRIMASK(primask);
+}
+
+int Trace_GetPendingCount() {
+    return head - tail;
+}
+
+uint32_t Trace_GetLostCount() {
+    return totalLost;
+}
+
+void Trace_DrainUart() {
+#if TRACE_UART_DRAIN
+    Trace_Record r;
+
+    while (1) {
+        if (uartFramePos == uartFrameLen) {
+            if (!Trace_Pop(&r)) {
+                return;
+            }
+
+            uartFrame[0] = TRACE_UART_SYNC0;
+            uartFrame[1] = TRACE_UART_SYNC1;
+            uartFrameLen = Trace_Serialize(uartFrame + 2, &r) - uartFrame;
+            uartFramePos = 0;
+        }
+
+        // never blocks, rest of frame is sent on next idle pass
+        int written = MXC_UART_WriteTXFIFO(TRACE_UART, uartFrame + uartFramePos, uartFrameLen - uartFramePos);
+        if (written <= 0) {
+            return;
+        }
+        uartFramePos += written;
+    }
+#endif
+}
+
+int Trace_IsUartBusy() {
+#if TRACE_UART_DRAIN
+    return uartFramePos != uartFrameLen || head != tail || !(MXC_UART_GetStatus(TRACE_UART) & MXC_F_UART_STATUS_TX_EM);
+#else
+    return 0;
+#endif
+}
\ No newline at end of file
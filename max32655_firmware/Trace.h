@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// must be power of 2
+#define TRACE_BUFFER_RECORDS 256
+
+// timestamp (u32), sequence (u8), event (u8), arg0 (u16), arg1 (u32), all little endian
+#define TRACE_RECORD_LEN 12
+
+// UART drain shares console UART with APP_TRACE, so it is off by default
+#ifndef TRACE_UART_DRAIN
+#define TRACE_UART_DRAIN 0
+#endif
+
+#define TRACE_UART MXC_UART0
+#define TRACE_UART_SYNC0 0xA5
+#define TRACE_UART_SYNC1 0x5A
+
+// keep in sync with tools/trace_decode.c
+enum {
+    TRACE_EVENT_LOST,
+    TRACE_EVENT_ERROR,
+    TRACE_EVENT_BUTTON_PRESS,
+    TRACE_EVENT_DISPLAY_FRAME,
+    TRACE_EVENT_I2C_TRANSACTION,
+    TRACE_EVENT_SLEEP,
+    TRACE_EVENT_BLE_CONNECTION,
+    TRACE_EVENT_STOPWATCH,
+    TRACE_EVENT_BLE_LINK,
+    TRACE_EVENT_GUI_FRAME,
+};
+
+enum {
+    TRACE_MODULE_DISPLAY,
+    TRACE_MODULE_FUEL_GAUGE,
+    TRACE_MODULE_GUI,
+    TRACE_MODULE_I2C_BUS,
+};
+
+enum {
+    TRACE_STOPWATCH_START,
+    TRACE_STOPWATCH_STOP,
+    TRACE_STOPWATCH_LAP,
+    TRACE_STOPWATCH_RESET,
+};
+
+// arg0 carries connection ID in upper byte, arg1 ticks since connection was opened
+enum {
+    TRACE_BLE_LINK_ENCRYPTED,
+    TRACE_BLE_LINK_PAIRED,
+    TRACE_BLE_LINK_NOTIFY_READY,
+    TRACE_BLE_LINK_FIRST_NOTIFICATION,
+};
+
+// arg0 carries module in upper 4 bits and source line in lower 12 bits
+#define TRACE_ERROR(module, status) Trace_Event(TRACE_EVENT_ERROR, ((module) << 12) | (__LINE__ & 0xFFF), (uint32_t)(status))
+
+void Trace_Event(uint8_t event, uint16_t arg0, uint32_t arg1);
+int Trace_Peek(uint8_t *buffer, int maxLen);
+void Trace_ConsumePeeked();
+int Trace_GetPendingCount();
+uint32_t Trace_GetLostCount();
+void Trace_DrainUart();
+int Trace_IsUartBusy();
+
+#endif
\ No newline at end of file
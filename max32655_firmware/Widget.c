@@ -0,0 +1,151 @@
+/* self */
+#include "Widget.h"
+
+/* project */
+#include "Display.h"
+#include "FontData.h"
+
+/* stdlib */
+#include <stdint.h>
+#include <string.h>
+
+void Widget_Init(Widget *widget, int row, int x, int width) {
+    memset(widget, 0, sizeof(*widget));
+    widget->row = row;
+    widget->x = x;
+    widget->width = width;
+    widget->isInvalid = 1;
+}
+
+void Widget_Clear(Widget *widget) {
+    memset(&widget->content, 0, sizeof(widget->content));
+}
+
+// strncpy pads rest of buffer with zeros, so equal texts compare equal as whole content
+void Widget_SetText(Widget *widget, const char *text) {
+    strncpy(widget->content.text, text, WIDGET_TEXT_LEN - 1);
+}
+
+void Widget_SetValue(Widget *widget, const char *value) {
+    strncpy(widget->content.value, value, WIDGET_TEXT_LEN - 1);
+}
+
+void Widget_SetIcon(Widget *widget, const uint8_t *icon, int len) {
+    widget->content.icon = icon;
+    widget->content.iconLen = len;
+}
+
+void Widget_SetCustom(Widget *widget, Widget_DrawFunction draw, int key) {
+    widget->content.draw = draw;
+    widget->content.key = key;
+}
+
+void Widget_SetStyle(Widget *widget, int align, int shift, int isInverted) {
+    widget->content.align = align;
+    widget->content.shift = shift;
+    widget->content.isInverted = isInverted;
+}
+
+// text of tall fonts covers rows below widget, widgets of those rows are hidden meanwhile
+void Widget_SetFont(Widget *widget, const Font *font) {
+    widget->content.font = font;
+}
+
+// hidden widget leaves its columns to widget above it, it is drawn again once it is shown
+void Widget_Hide(Widget *widget) {
+    widget->content.isHidden = 1;
+}
+
+// forces redraw even when content is unchanged, e.g. custom widget whose source data changed under the same key
+void Widget_Invalidate(Widget *widget) {
+    widget->isInvalid = 1;
+}
+
+// pixels of source widget were moved to columns of target one, e.g. by scrolling display rows
+void Widget_MoveDrawn(Widget *target, const Widget *source) {
+    target->drawn = source->drawn;
+    target->isInvalid = source->isInvalid;
+}
+
+// text is clipped to widget columns, so it never overwrites neighbours that are not redrawn
+static void Widget_PrintClipped(const Font *font, int x, int left, int right, int row, const char *text) {
+    if (x < left) {
+        x = left;
+    }
+
+    while (*text) {
+        if (x + Display_GetFontCharLength(font, *text) > right) {
+            break;
+        }
+        x = Display_PrintFontChar(font, x, row, *text);
+        text++;
+    }
+}
+
+static void Widget_Rasterise(Widget *widget) {
+    Widget_Content *c = &widget->content;
+    const Font *font = c->font ? c->font : &Font_Small;
+    int right = widget->x + widget->width;
+
+    if (c->isHidden) {
+        return;
+    }
+
+    for (int i = 0; i < font->height; i++) {
+        Display_FillSpan(widget->x, right, widget->row + i, 0);
+    }
+
+    if (c->draw) {
+        c->draw(widget);
+        return;
+    }
+
+    if (c->icon) {
+        Display_CopyRect(widget->x, widget->row, c->iconLen < widget->width ? c->iconLen : widget->width, 1, c->icon, c->iconLen);
+    }
+
+    if (c->text[0]) {
+        // last column of string is spacing, centered text ignores it
+        int len = Display_GetFontStringLength(font, c->text);
+        int x = widget->x + 1;
+        if (c->align == WIDGET_ALIGN_CENTER) {
+            x = widget->x + widget->width / 2 - (len - 1) / 2;
+        } else if (c->align == WIDGET_ALIGN_RIGHT) {
+            x = right - len;
+        }
+        Widget_PrintClipped(font, x, widget->x, right, widget->row, c->text);
+    }
+
+    if (c->value[0]) {
+        Widget_PrintClipped(font, right - Display_GetFontStringLength(font, c->value), widget->x, right, widget->row, c->value);
+    }
+
+    if (c->shift) {
+        Display_ShiftLeftSpan(widget->x, right, widget->row, c->shift);
+    }
+    if (c->isInverted) {
+        Display_OrSpan(widget->x, right, widget->row, 0b00000001);
+        Display_InvertSpan(widget->x, right, widget->row);
+    }
+}
+
+// returns 1 when widget was redrawn, hiding widget draws nothing
+int Widget_Render(Widget *widget) {
+    if (!widget->isInvalid && memcmp(&widget->content, &widget->drawn, sizeof(widget->content)) == 0) {
+        return 0;
+    }
+
+    Widget_Rasterise(widget);
+    widget->drawn = widget->content;
+    widget->isInvalid = 0;
+    return !widget->drawn.isHidden;
+}
+
+int Widget_RenderAll(Widget **widgets, int count) {
+    int redrawn = 0;
+
+    for (int i = 0; i < count; i++) {
+        redrawn += Widget_Render(widgets[i]);
+    }
+    return redrawn;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include "Font.h"
+
+#include <stdint.h>
+
+#define WIDGET_TEXT_LEN 16
+
+enum {
+    WIDGET_ALIGN_LEFT,
+    WIDGET_ALIGN_CENTER,
+    WIDGET_ALIGN_RIGHT,
+};
+
+typedef struct Widget Widget;
+
+// custom widgets rasterise their columns themselves, key tells when content changed
+typedef void (*Widget_DrawFunction)(Widget *widget);
+
+// everything that decides widget pixels, widget is redrawn only when it differs from what was drawn last time
+typedef struct {
+    char text[WIDGET_TEXT_LEN];
+    char value[WIDGET_TEXT_LEN];
+    const uint8_t *icon;
+    const Font *font;
+    Widget_DrawFunction draw;
+    int key;
+    uint8_t iconLen;
+    uint8_t align;
+    uint8_t shift;
+    uint8_t isInverted;
+    uint8_t isHidden;
+} Widget_Content;
+
+// Retained widget owns columns [x, x + width) of one display row, or of rows below it too when its font is taller. Pages set content of widgets on every render,
+// pixels outside of changed widgets are kept, so display only gets rows that really changed.
+struct Widget {
+    uint8_t row;
+    uint8_t x;
+    uint8_t width;
+    uint8_t isInvalid;
+    Widget_Content content;
+    Widget_Content drawn;
+};
+
+void Widget_Init(Widget *widget, int row, int x, int width);
+void Widget_Clear(Widget *widget);
+void Widget_SetText(Widget *widget, const char *text);
+void Widget_SetValue(Widget *widget, const char *value);
+void Widget_SetIcon(Widget *widget, const uint8_t *icon, int len);
+void Widget_SetCustom(Widget *widget, Widget_DrawFunction draw, int key);
+void Widget_SetStyle(Widget *widget, int align, int shift, int isInverted);
+void Widget_SetFont(Widget *widget, const Font *font);
+void Widget_Hide(Widget *widget);
+void Widget_Invalidate(Widget *widget);
+void Widget_MoveDrawn(Widget *target, const Widget *source);
+int Widget_Render(Widget *widget);
+int Widget_RenderAll(Widget **widgets, int count);
+
+#endif
\ No newline at end of file
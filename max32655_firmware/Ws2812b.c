@@ -20,6 +20,7 @@
 
 static uint8_t gpioData[WS2812B_LEDS_MAX * WS2812B_BITS_PER_PIXEL + 1];
 static int isDisabled = 0;
+static uint32_t frameCount = 0;
 
 void WS2812B_init() {
     int status;
@@ -135,8 +136,14 @@ void WS2812B_Transmit() {
     MXC_GPIO_OutSet(WS2812B_LED_IN_GPIO, WS2812B_LED_IN_PIN);
 
     __enable_irq();
+
+    frameCount++;
 }
 
 void WS2812B_Disable() {
     isDisabled = 1;
+}
+
+uint32_t WS2812B_GetFrameCount() {
+    return frameCount;
 }
\ No newline at end of file
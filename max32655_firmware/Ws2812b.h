@@ -9,5 +9,6 @@ void WS2812B_init();
 void WS2812B_Disable();
 void WS2812B_SetColor(int index, uint8_t r, uint8_t g, uint8_t b);
 void WS2812B_Transmit();
+uint32_t WS2812B_GetFrameCount();
 
 #endif
\ No newline at end of file
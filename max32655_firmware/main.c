@@ -2,8 +2,12 @@
 #include "BLE.h"
 #include "Button.h"
 #include "Display.h"
+#include "Energy.h"
 #include "FuelGauge.h"
 #include "GUI.h"
+#include "I2CBus.h"
+#include "Power.h"
+#include "Profile.h"
 #include "Time.h"
 #include "Ws2812b.h"
 
@@ -12,15 +16,18 @@
 #include <wsf_os.h>
 
 int main(void) {
+    Profile_Init();
     WS2812B_init();
     BLE_Init();
     Time_Init();
     Button_Init();
+    I2CBus_Init();
     Display_Init();
     FuelGauge_Init();
     GUI_Init();
+    Energy_Init();
 
-    WsfOsEnterMainLoop();
+    Power_EnterMainLoop();
     __BKPT();
     return 0;
 }
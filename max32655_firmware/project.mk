@@ -12,3 +12,21 @@ LIB_CORDIO = 1
 
 # Optimize for size
 MXC_OPTIMIZE_CFLAGS = -Og
+
+# Display link, DISPLAY_TRANSPORT_I2C (default), DISPLAY_TRANSPORT_SPI for SPI modules or DISPLAY_TRANSPORT_SIM,
+# which has no display attached and traces frame rate the modelled link would reach
+# PROJ_CFLAGS += -DDISPLAY_TRANSPORT=DISPLAY_TRANSPORT_SPI
+
+# Font tables are compiled from fonts/*.font by host tool, FontData.c and FontData.h are kept in tree
+# and regenerated whenever font sources or compiler change
+HOST_CC ?= cc
+FONT_SOURCES := fonts/small.font fonts/digits16.font fonts/digits24.font
+
+.DEFAULT_GOAL := all
+
+FontData.h: FontData.c
+
+FontData.c: $(FONT_SOURCES) tools/font_compile.c
+	@mkdir -p $(BUILD_DIR)
+	$(HOST_CC) -std=c99 -O2 -o $(BUILD_DIR)/font_compile tools/font_compile.c
+	$(BUILD_DIR)/font_compile FontData.c FontData.h $(FONT_SOURCES)
@@ -0,0 +1,408 @@
+// Host test of Display.c against model of display controller. Model takes transfers the way SSD1306 and SH1106
+// take I2C stream: control byte, then commands with their arguments or data written to GDDRAM at page and column
+// pointer, and shows panel rows from GDDRAM at start line. Unknown commands, wrong arguments and data past end of
+// page are counted as errors, so test checks Display speaks the controller's language, not only that pixels match.
+//
+// Build: make display_test_64x48 display_test_128x64 display_test_sh1106 (cc -std=c99 -DDISPLAY_PANEL=<panel>
+//        -I.. -Ihost display_test.c ../Display.c ../Raster.c ../FontData.c)
+// Usage: display_test_<panel>, exits with 1 when any check fails
+//
+// WSF is not run, test completes bus transfers and fires Display's retry timer by hand, in between it draws, so
+// drawing during transmission and bus failures at every point of frame are covered.
+
+#include "Display.h"
+#include "DisplayBus.h"
+#include "Profile.h"
+#include "Time.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPECT(condition)                                                    \
+    do {                                                                     \
+        if (!(condition)) {                                                  \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);    \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+// geometry of panels from their datasheets, independent of Display.c
+#if DISPLAY_PANEL == DISPLAY_PANEL_SSD1306_64X48
+#define PANEL_NAME "SSD1306 64x48"
+#define PANEL_COLUMNS 64
+#define PANEL_PAGES 6
+#define PANEL_FIRST_COLUMN 32
+#define CONTROLLER_COLUMNS 128
+#define IS_SH1106 0
+#elif DISPLAY_PANEL == DISPLAY_PANEL_SSD1306_128X64
+#define PANEL_NAME "SSD1306 128x64"
+#define PANEL_COLUMNS 128
+#define PANEL_PAGES 8
+#define PANEL_FIRST_COLUMN 0
+#define CONTROLLER_COLUMNS 128
+#define IS_SH1106 0
+#else
+#define PANEL_NAME "SH1106 128x64"
+#define PANEL_COLUMNS 128
+#define PANEL_PAGES 8
+#define PANEL_FIRST_COLUMN 2
+#define CONTROLLER_COLUMNS 132
+#define IS_SH1106 1
+#endif
+
+#define CONTROLLER_PAGES 8
+#define SSD1306_PAGE_ADDRESSING 0x02
+#define RETRY_TIMER_MS 100
+
+mxc_tmr_regs_t Host_Tmr[4];
+
+static int failures = 0;
+
+// controller state, GDDRAM starts with noise as it does after power up
+static struct {
+    uint8_t ram[CONTROLLER_PAGES][CONTROLLER_COLUMNS];
+    int page;
+    int column;
+    int startLine;
+    int multiplex;
+    int addressingMode;
+    int isOn;
+    int isConfigured;
+    int errors;
+    uint32_t dataBytes;
+} controller;
+
+static DisplayBus_Transfer *busQueue = NULL;
+
+static wsfEventHandler_t handlers[PROFILE_MAX_HANDLERS];
+static int handlersCount = 0;
+static wsfTimer_t *displayTimer = NULL;
+
+wsfHandlerId_t Profile_SetNextHandler(wsfEventHandler_t handler, const char *name) {
+    handlers[handlersCount] = handler;
+    return handlersCount++;
+}
+
+void Profile_TimerStartMs(wsfTimer_t *timer, wsfTimerTicks_t ms) {
+    timer->isStarted = 1;
+    timer->ticks = ms;
+    displayTimer = timer;
+}
+
+void Profile_TimerStop(wsfTimer_t *timer) {
+    timer->isStarted = 0;
+}
+
+void Trace_Event(uint8_t event, uint16_t arg0, uint32_t arg1) {
+}
+
+void DisplayBus_Init() {
+}
+
+int DisplayBus_Configure() {
+    return 0;
+}
+
+// urgent transfers go ahead of others, like every transport
+int DisplayBus_Submit(DisplayBus_Transfer *transfer) {
+    DisplayBus_Transfer **insertAt = &busQueue;
+    while (*insertAt != NULL && (!transfer->isUrgent || (*insertAt)->isUrgent)) {
+        insertAt = &(*insertAt)->next;
+    }
+
+    transfer->next = *insertAt;
+    *insertAt = transfer;
+    return 0;
+}
+
+int DisplayBus_IsBusy() {
+    return busQueue != NULL;
+}
+
+static int Controller_ArgumentsCount(uint8_t command) {
+    switch (command) {
+        case 0x81:  // contrast
+        case 0xA8:  // multiplex ratio
+        case 0xD3:  // display offset
+        case 0xD5:  // clock divide
+        case 0xD9:  // pre-charge period
+        case 0xDA:  // COM pins
+        case 0xDB:  // VCOMH deselect level
+            return 1;
+        case 0x8D:  // SSD1306 charge pump
+        case 0x20:  // SSD1306 addressing mode
+            return IS_SH1106 ? -1 : 1;
+        case 0x21:  // SSD1306 column and page range, horizontal and vertical addressing only
+        case 0x22:
+            return IS_SH1106 ? -1 : 2;
+        case 0xAD:  // SH1106 DC-DC
+            return IS_SH1106 ? 1 : -1;
+    }
+
+    if (command <= 0x1F || (command >= 0x40 && command <= 0x7F) || (command >= 0xB0 && command <= 0xB7) || command == 0xA0 || command == 0xA1 || command == 0xA4 ||
+        command == 0xA5 || command == 0xA6 || command == 0xA7 || command == 0xAE || command == 0xAF || command == 0xC0 || command == 0xC8 || command == 0xE3) {
+        return 0;
+    }
+    if (IS_SH1106 && command >= 0x30 && command <= 0x33) {
+        return 0;
+    }
+    return -1;
+}
+
+static void Controller_Command(const uint8_t *p) {
+    uint8_t command = p[0];
+
+    if (command <= 0x0F) {
+        controller.column = (controller.column & 0xF0) | command;
+    } else if (command <= 0x1F) {
+        controller.column = (controller.column & 0x0F) | ((command & 0x0F) << 4);
+    } else if (command >= 0x40 && command <= 0x7F) {
+        controller.startLine = command & 0x3F;
+    } else if (command >= 0xB0 && command <= 0xB7) {
+        controller.page = command & 0x07;
+    } else if (command == 0xAE || command == 0xAF) {
+        controller.isOn = command == 0xAF;
+        controller.isConfigured |= controller.isOn;
+    } else if (command == 0xA8) {
+        controller.multiplex = p[1] + 1;
+    } else if (command == 0x20) {
+        controller.addressingMode = p[1];
+    }
+}
+
+// bytes of segment up to len are taken, so transfer failing half way leaves controller as real one would
+static void Controller_Segment(const uint8_t *p, unsigned int len) {
+    if (len == 0) {
+        return;
+    }
+
+    if (p[0] == DISPLAY_BUS_CONTROL_DATA) {
+        if (controller.addressingMode != SSD1306_PAGE_ADDRESSING) {
+            controller.errors++;
+        }
+        for (unsigned int i = 1; i < len; i++) {
+            if (controller.column >= CONTROLLER_COLUMNS) {
+                controller.errors++;
+                break;
+            }
+            controller.ram[controller.page][controller.column++] = p[i];
+            controller.dataBytes++;
+        }
+        return;
+    }
+
+    if (p[0] != DISPLAY_BUS_CONTROL_COMMANDS) {
+        controller.errors++;
+        return;
+    }
+
+    unsigned int i = 1;
+    while (i < len) {
+        int argumentsCount = Controller_ArgumentsCount(p[i]);
+        if (argumentsCount < 0) {
+            controller.errors++;
+            i++;
+            continue;
+        }
+        if (i + argumentsCount >= len) {
+            break;
+        }
+        Controller_Command(p + i);
+        i += 1 + argumentsCount;
+    }
+}
+
+// failed transfer reaches controller only up to a random byte
+static void Bus_Complete(int isFailing) {
+    DisplayBus_Transfer *transfer = busQueue;
+    busQueue = transfer->next;
+    transfer->next = NULL;
+
+    int failSegment = isFailing ? rand() % transfer->segmentsCount : transfer->segmentsCount;
+    for (int i = 0; i < transfer->segmentsCount && i <= failSegment; i++) {
+        unsigned int len = i < failSegment ? transfer->lengths[i] : rand() % (transfer->lengths[i] + 1);
+        Controller_Segment(transfer->segments[i], len);
+    }
+
+    TIME_TIMER->cnt += 30;
+    transfer->callback(transfer, isFailing ? -1 : 0);
+}
+
+static int Test_FireTimer() {
+    if (displayTimer == NULL || !displayTimer->isStarted) {
+        return 0;
+    }
+
+    displayTimer->isStarted = 0;
+    TIME_TIMER->cnt += displayTimer->ticks * TIME_TICK_PER_SEC / 1000;
+    handlers[displayTimer->handlerId](0, &displayTimer->msg);
+    return 1;
+}
+
+static void Test_Drain() {
+    while (busQueue != NULL || Test_FireTimer()) {
+        if (busQueue != NULL) {
+            Bus_Complete(0);
+        }
+    }
+}
+
+// glass shows multiplex rows from start line on, panel columns start at its first column in GDDRAM
+static int Test_IsGlassEqual() {
+    uint8_t row[DISPLAY_WIDTH];
+
+    if (!controller.isOn || controller.startLine % 8 || controller.multiplex != PANEL_PAGES * 8) {
+        return 0;
+    }
+
+    for (int i = 0; i < PANEL_PAGES; i++) {
+        Display_GetRowBuffer(i, row);
+        int page = (controller.startLine / 8 + i) % CONTROLLER_PAGES;
+        if (memcmp(row, &controller.ram[page][PANEL_FIRST_COLUMN], PANEL_COLUMNS) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void Test_DrawRandomRow(int row) {
+    uint8_t pixels[DISPLAY_WIDTH];
+    for (int i = 0; i < DISPLAY_WIDTH; i++) {
+        pixels[i] = rand();
+    }
+    Display_SetRowBuffer(row, pixels);
+}
+
+static void Test_DrawRandom() {
+    int row = rand() % DISPLAY_LINES;
+    int x0 = rand() % DISPLAY_WIDTH;
+    int x1 = x0 + rand() % (DISPLAY_WIDTH - x0) + 1;
+
+    switch (rand() % 5) {
+        case 0:
+            Display_FillSpan(x0, x1, row, rand());
+            break;
+        case 1:
+            Display_InvertSpan(x0, x1, row);
+            break;
+        case 2:
+            Display_PrintString(x0, row, "12:34.5");
+            break;
+        case 3:
+            Display_ScrollRows(0, DISPLAY_LINES - 1, rand() % 3 - 1);
+            break;
+        default:
+            Test_DrawRandomRow(row);
+            break;
+    }
+}
+
+int main() {
+    srand(1);
+    for (int i = 0; i < CONTROLLER_PAGES; i++) {
+        for (int j = 0; j < CONTROLLER_COLUMNS; j++) {
+            controller.ram[i][j] = rand();
+        }
+    }
+    controller.addressingMode = SSD1306_PAGE_ADDRESSING;
+    controller.startLine = 5;
+
+    EXPECT(DISPLAY_WIDTH == PANEL_COLUMNS && DISPLAY_LINES == PANEL_PAGES);
+
+    // configuration waits for first timer, first frame goes out whole
+    Display_Init();
+    for (int i = 0; i < DISPLAY_LINES; i++) {
+        Test_DrawRandomRow(i);
+    }
+    Display_Show();
+    Test_Drain();
+    EXPECT(controller.isConfigured);
+    EXPECT(Test_IsGlassEqual());
+
+    // nothing changed, nothing sent
+    uint32_t dataBytes = controller.dataBytes;
+    Display_Show();
+    Test_Drain();
+    EXPECT(controller.dataBytes == dataBytes);
+
+    // scroll by one row moves start line and sends only the row that scrolled in
+    Display_ScrollRows(0, DISPLAY_LINES - 1, 1);
+    Test_DrawRandomRow(DISPLAY_LINES - 1);
+    Display_Show();
+    Test_Drain();
+    EXPECT(controller.dataBytes - dataBytes == DISPLAY_WIDTH);
+    EXPECT(controller.startLine == 8);
+    EXPECT(Test_IsGlassEqual());
+
+    // rows drawn again while frame is in transmission, both before and after the page being sent
+    for (int i = 0; i < DISPLAY_LINES; i++) {
+        Test_DrawRandomRow(i);
+    }
+    Display_Show();
+    Bus_Complete(0);
+    Bus_Complete(0);
+    Test_DrawRandomRow(0);
+    Test_DrawRandomRow(DISPLAY_LINES - 1);
+    Display_Show();
+    Test_Drain();
+    EXPECT(Test_IsGlassEqual());
+
+    // failure of every transfer of a frame in turn, display is configured again and whole frame sent
+    for (int failAt = 0; failAt < DISPLAY_LINES + 1; failAt++) {
+        for (int i = 0; i < DISPLAY_LINES; i++) {
+            Test_DrawRandomRow(i);
+        }
+        Display_Show();
+        for (int i = 0; i < failAt && busQueue != NULL; i++) {
+            Bus_Complete(0);
+        }
+        if (busQueue != NULL) {
+            Bus_Complete(1);
+            EXPECT(displayTimer->isStarted && displayTimer->ticks == RETRY_TIMER_MS);
+        }
+        Test_Drain();
+        EXPECT(Test_IsGlassEqual());
+    }
+
+    // random drawing, shows, transfers and failures in any order, glass matches whenever display is idle
+    int idleChecks = 0;
+    int isDrawnSinceShow = 0;
+    for (int step = 0; step < 20000; step++) {
+        int action = rand() % 10;
+        if (action < 4) {
+            Test_DrawRandom();
+            isDrawnSinceShow = 1;
+        } else if (action < 6) {
+            Display_Show();
+            isDrawnSinceShow = 0;
+        } else if (busQueue != NULL) {
+            Bus_Complete(rand() % 20 == 0);
+        } else if (!Test_FireTimer() && !isDrawnSinceShow) {
+            EXPECT(Test_IsGlassEqual());
+            idleChecks++;
+        }
+    }
+    Display_Show();
+    Test_Drain();
+    EXPECT(Test_IsGlassEqual());
+    EXPECT(idleChecks > 100);
+
+    // off while frame is in transmission, rest of frame is not sent after it
+    Test_DrawRandomRow(0);
+    Test_DrawRandomRow(DISPLAY_LINES - 1);
+    Display_Show();
+    Display_Off();
+    Test_Drain();
+    EXPECT(!controller.isOn);
+
+    EXPECT(controller.errors == 0);
+
+    if (failures) {
+        printf("%s: %d checks failed\n", PANEL_NAME, failures);
+        return 1;
+    }
+    printf("%s: all checks passed, %d idle frames compared\n", PANEL_NAME, idleChecks);
+    return 0;
+}
@@ -0,0 +1,246 @@
+// Host font compiler, turns bitmap font sources into glyph tables Display.c blits page by page.
+//
+// Build: cc -std=c99 -O2 -o font_compile font_compile.c
+// Usage: font_compile output.c output.h font...
+//
+// Font source is text, '#' lines start comments:
+//   name Font_Small      C name of font
+//   height 1             height in display pages of 8 px
+//   spacing 1            blank columns drawn after every glyph
+//   glyph A              glyph follows as rows of '#' (pixel on) and '.' (off), "glyph space" is ' '
+//   .##.                 all rows of glyph have the same width, missing bottom rows are blank
+//   #..#
+//
+// Glyph of height h and width w becomes h rows of w bytes, bit 0 of byte is top pixel of page, so renderer
+// draws it with one rectangle copy. Characters without glyph between first and last one have zero width.
+// Output is plain C with no host dependencies and is the same for the same sources, so it can be kept in tree.
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FONT_NAME_LEN 64
+#define FONT_MAX_HEIGHT 4
+#define GLYPH_MAX_WIDTH 32
+#define LINE_LEN 256
+#define CHARS 128
+
+typedef struct {
+    int width;
+    uint8_t pages[FONT_MAX_HEIGHT][GLYPH_MAX_WIDTH];
+} Glyph;
+
+typedef struct {
+    char name[FONT_NAME_LEN];
+    int height;
+    int spacing;
+    Glyph glyphs[CHARS];
+    int isDefined[CHARS];
+} Font;
+
+static Font font;
+static const char *path;
+static int lineNo;
+
+static void Fail(const char *message) {
+    fprintf(stderr, "%s:%d: %s\n", path, lineNo, message);
+    exit(1);
+}
+
+static void TrimRight(char *line) {
+    size_t len = strlen(line);
+    while (len > 0 && isspace((unsigned char)line[len - 1])) {
+        line[--len] = '\0';
+    }
+}
+
+static int ParseGlyphChar(const char *token) {
+    if (strcmp(token, "space") == 0) {
+        return ' ';
+    }
+    if (strlen(token) != 1 || (unsigned char)token[0] >= CHARS) {
+        Fail("glyph must be single ASCII character or 'space'");
+    }
+    return token[0];
+}
+
+static void ParseFont(const char *fontPath) {
+    char line[LINE_LEN];
+    Glyph *glyph = NULL;
+    int glyphRow = 0;
+
+    path = fontPath;
+    lineNo = 0;
+    memset(&font, 0, sizeof(font));
+
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        TrimRight(line);
+
+        if (line[0] == '#' && glyph == NULL) {
+            continue;
+        }
+        if (line[0] == '\0') {
+            glyph = NULL;
+            continue;
+        }
+
+        if (glyph && (line[0] == '#' || line[0] == '.')) {
+            int width = strlen(line);
+            if (glyphRow == 0) {
+                if (width > GLYPH_MAX_WIDTH) {
+                    Fail("glyph too wide");
+                }
+                glyph->width = width;
+            } else if (width != glyph->width) {
+                Fail("glyph rows differ in width");
+            }
+            if (glyphRow >= font.height * 8) {
+                Fail("glyph taller than font");
+            }
+
+            for (int x = 0; x < width; x++) {
+                if (line[x] == '#') {
+                    glyph->pages[glyphRow / 8][x] |= 1 << (glyphRow % 8);
+                } else if (line[x] != '.') {
+                    Fail("glyph rows consist of '#' and '.'");
+                }
+            }
+            glyphRow++;
+            continue;
+        }
+
+        char key[LINE_LEN];
+        char value[LINE_LEN];
+        if (sscanf(line, "%255s %255s", key, value) != 2) {
+            Fail("expected key and value");
+        }
+
+        if (strcmp(key, "name") == 0) {
+            snprintf(font.name, sizeof(font.name), "%s", value);
+        } else if (strcmp(key, "height") == 0) {
+            font.height = atoi(value);
+            if (font.height < 1 || font.height > FONT_MAX_HEIGHT) {
+                Fail("height out of range");
+            }
+        } else if (strcmp(key, "spacing") == 0) {
+            font.spacing = atoi(value);
+        } else if (strcmp(key, "glyph") == 0) {
+            if (font.height == 0) {
+                Fail("height must precede glyphs");
+            }
+            int ch = ParseGlyphChar(value);
+            if (font.isDefined[ch]) {
+                Fail("glyph defined twice");
+            }
+            font.isDefined[ch] = 1;
+            glyph = &font.glyphs[ch];
+            glyphRow = 0;
+        } else {
+            Fail("unknown key");
+        }
+    }
+    fclose(f);
+
+    if (font.name[0] == '\0') {
+        Fail("font has no name");
+    }
+}
+
+static void WriteFont(FILE *out) {
+    int first = -1;
+    int last = -1;
+    for (int ch = 0; ch < CHARS; ch++) {
+        if (font.isDefined[ch]) {
+            if (first < 0) {
+                first = ch;
+            }
+            last = ch;
+        }
+    }
+    if (first < 0) {
+        Fail("font has no glyphs");
+    }
+
+    fprintf(out, "\n// %s\nstatic const uint8_t %sGlyphs[] = {", path, font.name);
+    int count = 0;
+    for (int ch = first; ch <= last; ch++) {
+        Glyph *glyph = &font.glyphs[ch];
+        for (int page = 0; page < font.height; page++) {
+            for (int x = 0; x < glyph->width; x++) {
+                fprintf(out, "%s0x%02x,", count % 16 ? " " : "\n    ", glyph->pages[page][x]);
+                count++;
+            }
+        }
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static const uint16_t %sOffsets[] = {", font.name);
+    int offset = 0;
+    for (int ch = first; ch <= last + 1; ch++) {
+        fprintf(out, "%s%d,", (ch - first) % 16 ? " " : "\n    ", offset);
+        if (ch <= last) {
+            offset += font.glyphs[ch].width;
+        }
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "const Font %s = {\n", font.name);
+    fprintf(out, "    .height = %d,\n", font.height);
+    fprintf(out, "    .spacing = %d,\n", font.spacing);
+    fprintf(out, "    .first = %d,\n", first);
+    fprintf(out, "    .last = %d,\n", last);
+    fprintf(out, "    .offsets = %sOffsets,\n", font.name);
+    fprintf(out, "    .glyphs = %sGlyphs,\n", font.name);
+    fprintf(out, "};\n");
+}
+
+static FILE *OpenOutput(const char *outputPath) {
+    FILE *out = fopen(outputPath, "w");
+    if (!out) {
+        perror(outputPath);
+        exit(1);
+    }
+    fprintf(out, "// Generated by tools/font_compile from fonts/*.font, do not edit.\n");
+    return out;
+}
+
+static const char *BaseName(const char *p) {
+    const char *slash = strrchr(p, '/');
+    return slash ? slash + 1 : p;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: font_compile output.c output.h font...\n");
+        return 2;
+    }
+
+    FILE *source = OpenOutput(argv[1]);
+    FILE *header = OpenOutput(argv[2]);
+
+    fprintf(source, "\n/* self */\n#include \"%s\"\n\n/* stdlib */\n#include <stdint.h>\n", BaseName(argv[2]));
+    fprintf(header, "\n#ifndef FONT_DATA_H\n#define FONT_DATA_H\n\n#include \"Font.h\"\n\n");
+
+    for (int i = 3; i < argc; i++) {
+        ParseFont(argv[i]);
+        WriteFont(source);
+        fprintf(header, "extern const Font %s;\n", font.name);
+    }
+
+    fprintf(header, "\n#endif\n");
+
+    if (fclose(source) || fclose(header)) {
+        perror("font_compile");
+        return 1;
+    }
+    return 0;
+}
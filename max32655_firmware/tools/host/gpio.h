@@ -0,0 +1,35 @@
+// Host stand-in for MSDK gpio.h, pins are only configured as wakeup sources.
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <stdint.h>
+
+#include "max32655.h"
+
+#define MXC_GPIO_PIN_21 (1UL << 21)
+#define MXC_GPIO_PIN_22 (1UL << 22)
+#define MXC_GPIO_PIN_25 (1UL << 25)
+
+typedef enum {
+    MXC_GPIO_FUNC_IN,
+} mxc_gpio_func_t;
+
+typedef enum {
+    MXC_GPIO_PAD_NONE,
+} mxc_gpio_pad_t;
+
+typedef enum {
+    MXC_GPIO_VSSEL_VDDIOH,
+} mxc_gpio_vssel_t;
+
+typedef struct {
+    mxc_gpio_regs_t *port;
+    uint32_t mask;
+    mxc_gpio_func_t func;
+    mxc_gpio_pad_t pad;
+    mxc_gpio_vssel_t vssel;
+} mxc_gpio_cfg_t;
+
+void MXC_GPIO_SetWakeEn(mxc_gpio_regs_t *port, uint32_t mask);
+
+#endif
@@ -0,0 +1,19 @@
+// Host stand-in for MSDK i2c.h, host tests never start transactions.
+#ifndef I2C_H
+#define I2C_H
+
+#include "max32655.h"
+
+typedef struct _i2c_req_t mxc_i2c_req_t;
+
+struct _i2c_req_t {
+    mxc_i2c_regs_t *i2c;
+    uint8_t addr;
+    unsigned char *tx_buf;
+    unsigned int tx_len;
+    unsigned char *rx_buf;
+    unsigned int rx_len;
+    int restart;
+};
+
+#endif
@@ -0,0 +1,10 @@
+// Host stand-in for MSDK lp.h.
+#ifndef LP_H
+#define LP_H
+
+#include "gpio.h"
+
+void MXC_LP_EnableGPIOWakeup(mxc_gpio_cfg_t *wuPins);
+void MXC_LP_EnableWUTAlarmWakeup();
+
+#endif
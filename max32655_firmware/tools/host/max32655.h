@@ -0,0 +1,56 @@
+// Host stand-in for MSDK max32655.h. Peripherals are plain structs, host test defines them and models what
+// they do.
+#ifndef MAX32655_H
+#define MAX32655_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wsf_types.h"
+
+#define E_NO_ERROR 0
+#define E_BAD_PARAM -3
+#define E_BAD_STATE -7
+
+typedef enum {
+    TMR2_IRQn,
+    GPIO0_IRQn,
+    MXC_IRQ_COUNT
+} IRQn_Type;
+
+typedef struct {
+    volatile uint32_t cnt;
+} mxc_tmr_regs_t;
+
+typedef struct {
+    int id;
+} mxc_i2c_regs_t;
+
+typedef struct {
+    int id;
+} mxc_gpio_regs_t;
+
+typedef struct {
+    volatile uint32_t SCR;
+} SCB_Type;
+
+#define SCB_SCR_SLEEPDEEP_Msk (1UL << 2)
+
+extern mxc_tmr_regs_t Host_Tmr[4];
+extern mxc_i2c_regs_t Host_I2c[3];
+extern mxc_gpio_regs_t Host_Gpio0;
+extern SCB_Type Host_Scb;
+
+#define MXC_TMR2 (&Host_Tmr[2])
+#define MXC_TMR3 (&Host_Tmr[3])
+#define MXC_I2C1 (&Host_I2c[1])
+#define MXC_I2C2 (&Host_I2c[2])
+#define MXC_GPIO0 (&Host_Gpio0)
+#define SCB (&Host_Scb)
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+
+#endif
@@ -0,0 +1,9 @@
+// Host stand-in for MSDK nvic_table.h.
+#ifndef NVIC_TABLE_H
+#define NVIC_TABLE_H
+
+#include "max32655.h"
+
+void MXC_NVIC_SetVector(IRQn_Type irq, void (*handler)(void));
+
+#endif
@@ -0,0 +1,9 @@
+// Host stand-in for Cordio pal_sys.h.
+#ifndef PAL_SYS_H
+#define PAL_SYS_H
+
+#include "wsf_types.h"
+
+bool_t PalSysIsBusy();
+
+#endif
@@ -0,0 +1,42 @@
+// Host stand-in for MSDK tmr.h, only 32 kHz timers used by Time.c.
+#ifndef TMR_H
+#define TMR_H
+
+#include <stdint.h>
+
+#include "max32655.h"
+
+typedef enum {
+    TMR_PRES_1,
+} mxc_tmr_pres_t;
+
+typedef enum {
+    TMR_MODE_ONESHOT,
+    TMR_MODE_CONTINUOUS,
+} mxc_tmr_mode_t;
+
+typedef enum {
+    TMR_BIT_MODE_32,
+} mxc_tmr_bit_mode_t;
+
+typedef enum {
+    MXC_TMR_32K_CLK,
+} mxc_tmr_clock_t;
+
+typedef struct {
+    mxc_tmr_pres_t pres;
+    mxc_tmr_mode_t mode;
+    mxc_tmr_bit_mode_t bitMode;
+    mxc_tmr_clock_t clock;
+    uint32_t cmp_cnt;
+    unsigned int pol;
+} mxc_tmr_cfg_t;
+
+int MXC_TMR_Init(mxc_tmr_regs_t *tmr, mxc_tmr_cfg_t *cfg, bool_t initPins);
+void MXC_TMR_Start(mxc_tmr_regs_t *tmr);
+void MXC_TMR_Stop(mxc_tmr_regs_t *tmr);
+void MXC_TMR_EnableInt(mxc_tmr_regs_t *tmr);
+void MXC_TMR_DisableInt(mxc_tmr_regs_t *tmr);
+void MXC_TMR_ClearFlags(mxc_tmr_regs_t *tmr);
+
+#endif
@@ -0,0 +1,9 @@
+// Host stand-in for Cordio wsf_cs.h, host tests run on one thread without interrupts of their own.
+#ifndef WSF_CS_H
+#define WSF_CS_H
+
+#define WSF_CS_INIT(cs)
+#define WSF_CS_ENTER(cs)
+#define WSF_CS_EXIT(cs)
+
+#endif
@@ -0,0 +1,26 @@
+// Host stand-in for Cordio wsf_os.h, only what firmware units built on host use. Handlers are dispatched by
+// the host test itself.
+#ifndef WSF_OS_H
+#define WSF_OS_H
+
+#include <stdint.h>
+
+#include "wsf_types.h"
+
+typedef uint8_t wsfHandlerId_t;
+typedef uint16_t wsfEventMask_t;
+
+typedef struct {
+    uint16_t param;
+    uint8_t event;
+    uint8_t status;
+} wsfMsgHdr_t;
+
+typedef void (*wsfEventHandler_t)(wsfEventMask_t event, wsfMsgHdr_t *pMsg);
+
+wsfHandlerId_t WsfOsSetNextHandler(wsfEventHandler_t handler);
+void WsfSetEvent(wsfHandlerId_t handlerId, wsfEventMask_t event);
+bool_t wsfOsReadyToSleep();
+void wsfOsDispatcher();
+
+#endif
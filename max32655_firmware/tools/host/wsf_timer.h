@@ -0,0 +1,27 @@
+// Host stand-in for Cordio wsf_timer.h, timers are kept by the host test.
+#ifndef WSF_TIMER_H
+#define WSF_TIMER_H
+
+#include <stdint.h>
+
+#include "wsf_os.h"
+
+#define WSF_MS_PER_TICK 1
+
+typedef uint32_t wsfTimerTicks_t;
+
+typedef struct wsfTimer_tag {
+    struct wsfTimer_tag *pNext;
+    wsfTimerTicks_t ticks;
+    wsfHandlerId_t handlerId;
+    bool_t isStarted;
+    wsfMsgHdr_t msg;
+} wsfTimer_t;
+
+void WsfTimerStartMs(wsfTimer_t *pTimer, wsfTimerTicks_t ms);
+void WsfTimerStop(wsfTimer_t *pTimer);
+wsfTimerTicks_t WsfTimerNextExpiration(bool_t *pTimerRunning);
+void WsfTimerSleep();
+void WsfTimerSleepUpdate();
+
+#endif
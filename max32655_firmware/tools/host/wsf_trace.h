@@ -0,0 +1,10 @@
+// Host stand-in for Cordio wsf_trace.h, traces are dropped.
+#ifndef WSF_TRACE_H
+#define WSF_TRACE_H
+
+#define APP_TRACE_ERR0(msg)
+#define APP_TRACE_ERR1(msg, var1) ((void)(var1))
+#define APP_TRACE_WARN1(msg, var1) ((void)(var1))
+#define APP_TRACE_INFO1(msg, var1) ((void)(var1))
+
+#endif
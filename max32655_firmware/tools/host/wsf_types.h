@@ -0,0 +1,17 @@
+// Host stand-in for Cordio wsf_types.h.
+#ifndef WSF_TYPES_H
+#define WSF_TYPES_H
+
+#include <stdint.h>
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+typedef uint8_t bool_t;
+
+#endif
@@ -0,0 +1,9 @@
+// Host stand-in for MSDK wut.h.
+#ifndef WUT_H
+#define WUT_H
+
+#include <stdint.h>
+
+uint32_t MXC_WUT_GetCount();
+
+#endif
@@ -0,0 +1,111 @@
+// Host test of Profile.c on its virtual clock, WSF and Power are stubbed here and handlers are dispatched by hand.
+//
+// Build: make profile_test (cc -std=c99 -DPROFILE_VIRTUAL_CLOCK=1 -I.. -Ihost profile_test.c ../Profile.c)
+// Usage: profile_test, exits with 1 when any check fails
+
+#include "Power.h"
+#include "Profile.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define EXPECT(condition)                                                    \
+    do {                                                                     \
+        if (!(condition)) {                                                  \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);    \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+#define MS_TICKS(ms) ((ms) * POWER_TICK_PER_SEC / 1000)
+
+static int failures = 0;
+
+static wsfEventHandler_t registered[PROFILE_MAX_HANDLERS + 1];
+static int registeredCount = 0;
+static uint32_t wakeupCount = 0;
+static uint32_t handlerCycles = 0;
+
+wsfHandlerId_t WsfOsSetNextHandler(wsfEventHandler_t handler) {
+    registered[registeredCount] = handler;
+    return registeredCount++;
+}
+
+void WsfTimerStartMs(wsfTimer_t *pTimer, wsfTimerTicks_t ms) {
+    pTimer->isStarted = 1;
+}
+
+void WsfTimerStop(wsfTimer_t *pTimer) {
+    pTimer->isStarted = 0;
+}
+
+uint32_t Power_GetWakeupCount() {
+    return wakeupCount;
+}
+
+static void Test_Handler(wsfEventMask_t event, wsfMsgHdr_t *pMsg) {
+    Profile_AdvanceVirtualClock(0, handlerCycles);
+}
+
+static void Test_Dispatch(wsfTimer_t *timer) {
+    registered[timer->handlerId](0, &timer->msg);
+}
+
+int main() {
+    Profile_HandlerStats stats;
+    wsfTimer_t timer = {0};
+
+    Profile_Init();
+    timer.handlerId = Profile_SetNextHandler(Test_Handler, "Test");
+
+    // expiry dispatched 3 ms late falls into 2 to 5 ms bucket, dispatch right after wakeup counts as wakeup
+    Profile_TimerStartMs(&timer, 100);
+    Profile_AdvanceVirtualClock(MS_TICKS(103), 0);
+    wakeupCount++;
+    handlerCycles = 1000;
+    Test_Dispatch(&timer);
+
+    // expiry within 1 ms, no wakeup in between
+    Profile_TimerStartMs(&timer, 20);
+    Profile_AdvanceVirtualClock(MS_TICKS(20), 0);
+    handlerCycles = 3000;
+    Test_Dispatch(&timer);
+
+    // message of stopped timer still in queue is not latency of anything
+    Profile_TimerStartMs(&timer, 100);
+    Profile_TimerStop(&timer);
+    Profile_AdvanceVirtualClock(MS_TICKS(1000), 0);
+    handlerCycles = 2000;
+    Test_Dispatch(&timer);
+
+    EXPECT(!Profile_GetHandlerStats(1, &stats));
+    EXPECT(Profile_GetHandlerStats(0, &stats));
+    EXPECT(stats.invocations == 3);
+    EXPECT(stats.wakeups == 1);
+    EXPECT(stats.maxCycles == 3000);
+    EXPECT(stats.totalCycles == 6000);
+    EXPECT(stats.latency[0] == 1);
+    EXPECT(stats.latency[1] == 0);
+    EXPECT(stats.latency[2] == 1);
+    EXPECT(stats.latency[PROFILE_LATENCY_BUCKETS - 1] == 0);
+
+    uint8_t report[PROFILE_REPORT_MAX_LEN];
+    int len = Profile_GetReport(report, sizeof(report));
+    EXPECT(len == PROFILE_RECORD_LEN);
+    EXPECT(report[0] == timer.handlerId && report[1] == 'T' && report[2] == 'e' && report[3] == 's');
+    // invocations, wakeups, max and average cycles follow as little endian words
+    EXPECT(report[4] == 3 && report[8] == 1);
+    EXPECT(report[12] == (3000 & 0xff) && report[13] == (3000 >> 8));
+    EXPECT(report[16] == (2000 & 0xff) && report[17] == (2000 >> 8));
+
+    Profile_ResetStats();
+    Profile_GetHandlerStats(0, &stats);
+    EXPECT(stats.invocations == 0 && stats.totalCycles == 0 && stats.latency[2] == 0);
+
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
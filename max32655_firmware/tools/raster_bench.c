@@ -0,0 +1,150 @@
+// Host benchmark of Raster.c against per-pixel framebuffer calls GUI used before, on menu page workload.
+//
+// Build: cc -std=c99 -O2 -I.. -o raster_bench raster_bench.c ../Raster.c
+// Usage: raster_bench [frames]
+//
+// Per-pixel functions are kept out of line, as they are on device where Display.c is separate translation unit.
+// Both variants render the same frame, which is compared byte by byte before timing is trusted.
+// Variants are timed in alternating rounds and the best round of each is reported, so frequency scaling and
+// other load do not favour either. Ratio depends on host CPU and compiler, x86 hosts at -O2 measured anywhere
+// from about 6x to 11x, absolute times say nothing about the device.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "Raster.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DISPLAY_WIDTH 64
+#define DISPLAY_LINES 6
+#define STATUS_POS 6
+#define STATUS_END 48
+#define MENU_LINES 4
+#define SELECTED_LINE 2
+#define ROUNDS 5
+
+static uint8_t pixelBuffer[DISPLAY_WIDTH * DISPLAY_LINES];
+static uint8_t rasterBuffer[DISPLAY_WIDTH * DISPLAY_LINES];
+
+__attribute__((noinline)) static void SetPixel(int x, int row, uint8_t value) {
+    if (x >= DISPLAY_WIDTH || row >= DISPLAY_LINES) {
+        return;
+    }
+    pixelBuffer[row * DISPLAY_WIDTH + x] = value;
+}
+
+__attribute__((noinline)) static void OrPixel(int x, int row, uint8_t value) {
+    pixelBuffer[row * DISPLAY_WIDTH + x] |= value;
+}
+
+__attribute__((noinline)) static void InvertPixel(int x, int row) {
+    pixelBuffer[row * DISPLAY_WIDTH + x] ^= 0xFF;
+}
+
+__attribute__((noinline)) static void ShiftLeftPixel(int x, int row, int shift) {
+    pixelBuffer[row * DISPLAY_WIDTH + x] <<= shift;
+}
+
+// glyph-like content, so shifts and inversions have something to move
+static void DrawContent(uint8_t *buffer) {
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_LINES; i++) {
+        buffer[i] = (i * 37) & 0x1F;
+    }
+}
+
+static void RenderPixels() {
+    for (int i = STATUS_POS; i < STATUS_END; i++) {
+        ShiftLeftPixel(i, 0, 1);
+    }
+
+    for (int line = 1; line <= MENU_LINES; line++) {
+        for (int j = 0; j < DISPLAY_WIDTH; j++) {
+            ShiftLeftPixel(j, line, 2);
+        }
+        if (line == SELECTED_LINE) {
+            for (int j = 0; j < DISPLAY_WIDTH; j++) {
+                OrPixel(j, line, 0b00000001);
+                InvertPixel(j, line);
+            }
+        }
+    }
+
+    for (int i = 0; i < DISPLAY_WIDTH; i++) {
+        ShiftLeftPixel(i, DISPLAY_LINES - 1, 2);
+        OrPixel(i, DISPLAY_LINES - 1, 0b00000001);
+    }
+    SetPixel(31, DISPLAY_LINES - 1, 0xFF);
+    SetPixel(32, DISPLAY_LINES - 1, 0xFF);
+    for (int i = 0; i < DISPLAY_WIDTH; i++) {
+        InvertPixel(i, DISPLAY_LINES - 1);
+    }
+}
+
+static void RenderRaster() {
+    Raster_ShiftLeft(rasterBuffer + STATUS_POS, STATUS_END - STATUS_POS, 1);
+
+    for (int line = 1; line <= MENU_LINES; line++) {
+        uint8_t *row = rasterBuffer + line * DISPLAY_WIDTH;
+        Raster_ShiftLeft(row, DISPLAY_WIDTH, 2);
+        if (line == SELECTED_LINE) {
+            Raster_Rop(row, DISPLAY_WIDTH, 0xFE, 0xFE);
+        }
+    }
+
+    uint8_t *buttons = rasterBuffer + (DISPLAY_LINES - 1) * DISPLAY_WIDTH;
+    Raster_ShiftLeft(buttons, DISPLAY_WIDTH, 2);
+    Raster_Rop(buttons, DISPLAY_WIDTH, 0xFE, 0xFE);
+    Raster_Rop(buttons + 31, 2, 0x00, 0x00);
+}
+
+static double Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// operations take the same time whatever pixels are, so frame is not redrawn between iterations
+static double Measure(void (*render)(), long frames) {
+    double start = Now();
+    for (long i = 0; i < frames; i++) {
+        render();
+    }
+    return Now() - start;
+}
+
+int main(int argc, char **argv) {
+    long frames = argc > 1 ? atol(argv[1]) : 200000;
+
+    DrawContent(pixelBuffer);
+    RenderPixels();
+    DrawContent(rasterBuffer);
+    RenderRaster();
+    if (memcmp(pixelBuffer, rasterBuffer, DISPLAY_WIDTH * DISPLAY_LINES) != 0) {
+        fprintf(stderr, "raster output differs from per-pixel output\n");
+        return 1;
+    }
+
+    double pixelTime = 0;
+    double rasterTime = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        double t = Measure(RenderPixels, frames);
+        if (round == 0 || t < pixelTime) {
+            pixelTime = t;
+        }
+
+        t = Measure(RenderRaster, frames);
+        if (round == 0 || t < rasterTime) {
+            rasterTime = t;
+        }
+    }
+
+    printf("frames      %ld x %d rounds\n", frames, ROUNDS);
+    printf("per-pixel   %.1f ns/frame\n", pixelTime * 1e9 / frames);
+    printf("raster      %.1f ns/frame\n", rasterTime * 1e9 / frames);
+    printf("speedup     %.1fx\n", pixelTime / rasterTime);
+    return 0;
+}
@@ -0,0 +1,351 @@
+// Host decoder of binary session files produced by Session.c, converts them to CSV or JSON lines.
+//
+// Build: cc -std=c99 -O2 -o session_decode session_decode.c
+// Usage: session_decode [-j] [file]
+//   file  one or more concatenated session files, e.g. archive of exports (default stdin)
+//   -j    print one JSON object per session instead of CSV row per lap
+//
+// Input is decoded in one pass with fixed memory, so archives of any size stream through at disk speed.
+// Session is printed only after its CRC is checked. Damaged session is reported on stderr and search for next
+// magic restarts right after its magic, so damaged archive still yields every intact session, also when broken
+// lap count made it overlap sessions that follow.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SESSION_VERSION 1
+#define SESSION_HEADER_LEN 40
+#define SESSION_TICK_PER_SEC 32768
+#define SESSION_FLAG_RUNNING 0x01
+#define SESSION_FLAG_SYNCHRONIZED 0x02
+
+// host time of time sync is in microseconds since 0001-01-01, Unix epoch starts 62135596800 s later
+#define SESSION_UNIX_EPOCH_US 62135596800000000ull
+
+// largest session is 255 B header, 65535 laps of 5 B varint and CRC, it has to fit whole into input buffer
+#define SESSION_MAX_LEN (255 + 65535 * 5 + 4)
+#define INPUT_BUFFER_LEN (512 * 1024)
+#define OUTPUT_BUFFER_LEN 65536
+
+#if INPUT_BUFFER_LEN < SESSION_MAX_LEN
+#error "input buffer must hold largest session"
+#endif
+
+typedef struct {
+    uint8_t flags;
+    uint8_t address[6];
+    uint16_t lapCount;
+    uint32_t startTick;
+    uint32_t elapsed;
+    uint64_t hostTime;
+    uint32_t deviceTick;
+    int32_t drift;
+} Header;
+
+static FILE *input;
+static uint8_t inputBuffer[INPUT_BUFFER_LEN];
+static size_t inputLen = 0;
+static size_t inputPos = 0;
+// bytes from here on stay in buffer when it is refilled, so decoding can go back to them
+static size_t keepPos = 0;
+static unsigned long long bufferOffset = 0;
+
+static uint32_t crcTable[256];
+static uint32_t crc;
+
+static int isJson = 0;
+static unsigned long sessionNumber = 0;
+static unsigned long long sessionOffset;
+static unsigned long errorCount = 0;
+
+static void InitCrcTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; bit++) {
+            c = (c >> 1) ^ (0xEDB88320 & -(c & 1));
+        }
+        crcTable[i] = c;
+    }
+}
+
+// returns next byte or EOF, every byte read is part of CRC
+static int ReadByte() {
+    if (inputPos == inputLen) {
+        memmove(inputBuffer, inputBuffer + keepPos, inputLen - keepPos);
+        bufferOffset += keepPos;
+        inputLen -= keepPos;
+        inputPos -= keepPos;
+        keepPos = 0;
+
+        size_t n = fread(inputBuffer + inputLen, 1, sizeof(inputBuffer) - inputLen, input);
+        if (n == 0) {
+            return EOF;
+        }
+        inputLen += n;
+    }
+
+    uint8_t b = inputBuffer[inputPos++];
+    crc = crcTable[(crc ^ b) & 0xFF] ^ (crc >> 8);
+    return b;
+}
+
+static int ReadBytes(uint8_t *p, int len) {
+    for (int i = 0; i < len; i++) {
+        int c = ReadByte();
+        if (c == EOF) {
+            return 0;
+        }
+        p[i] = c;
+    }
+    return 1;
+}
+
+static int ReadVarint(uint32_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int c = ReadByte();
+        if (c == EOF) {
+            return 0;
+        }
+        *value |= (uint32_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint32_t GetUint32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// seeks to next "SWSN" and keeps it in buffer, bytes skipped are reported once
+static int FindMagic() {
+    static const uint8_t magic[4] = {'S', 'W', 'S', 'N'};
+    unsigned long skipped = 0;
+    int matched = 0;
+
+    while (matched < 4) {
+        if (matched == 0) {
+            keepPos = inputPos;
+        }
+
+        int c = ReadByte();
+        if (c == EOF) {
+            if (skipped + matched > 0) {
+                fprintf(stderr, "%lu trailing bytes ignored\n", skipped + matched);
+                errorCount++;
+            }
+            return 0;
+        }
+
+        // failed match restarts one byte after its start, so overlapping match is not missed
+        if (c == magic[matched]) {
+            matched++;
+        } else {
+            inputPos = keepPos + 1;
+            skipped++;
+            matched = 0;
+        }
+    }
+
+    if (skipped) {
+        fprintf(stderr, "%lu bytes without session skipped\n", skipped);
+        errorCount++;
+    }
+    return 1;
+}
+
+static int ReadHeader(Header *h) {
+    uint8_t p[SESSION_HEADER_LEN];
+
+    if (!ReadBytes(p + 4, 2)) {
+        return 0;
+    }
+
+    // newer versions append fields to header, they are skipped
+    int headerLen = p[5];
+    if (p[4] < SESSION_VERSION || headerLen < SESSION_HEADER_LEN) {
+        fprintf(stderr, "session at byte %llu: unsupported version %d\n", sessionOffset, p[4]);
+        return 0;
+    }
+
+    if (!ReadBytes(p + 6, SESSION_HEADER_LEN - 6)) {
+        return 0;
+    }
+    for (int i = SESSION_HEADER_LEN; i < headerLen; i++) {
+        if (ReadByte() == EOF) {
+            return 0;
+        }
+    }
+
+    h->flags = p[6];
+    memcpy(h->address, p + 8, sizeof(h->address));
+    h->lapCount = p[14] | (p[15] << 8);
+    h->startTick = GetUint32(p + 16);
+    h->elapsed = GetUint32(p + 20);
+    h->hostTime = GetUint32(p + 24) | ((uint64_t)GetUint32(p + 28) << 32);
+    h->deviceTick = GetUint32(p + 32);
+    h->drift = (int32_t)GetUint32(p + 36);
+    return 1;
+}
+
+// same mapping as TimeSync_DeviceTickToHost in firmware
+static uint64_t DeviceTickToHost(const Header *h, uint32_t tick) {
+    int64_t deviceUs = (int64_t)(int32_t)(tick - h->deviceTick) * 1000000 / SESSION_TICK_PER_SEC;
+    return h->hostTime + deviceUs + deviceUs * h->drift / 1000000000;
+}
+
+static void FormatStart(const Header *h, char *text, size_t len) {
+    if (!(h->flags & SESSION_FLAG_SYNCHRONIZED)) {
+        text[0] = 0;
+        return;
+    }
+
+    uint64_t unixUs = DeviceTickToHost(h, h->startTick) - SESSION_UNIX_EPOCH_US;
+    time_t seconds = unixUs / 1000000;
+    size_t n = strftime(text, len, "%Y-%m-%dT%H:%M:%S", gmtime(&seconds));
+    snprintf(text + n, len - n, ".%06uZ", (unsigned)(unixUs % 1000000));
+}
+
+static void FormatAddress(const Header *h, char *text) {
+    sprintf(text, "%02X:%02X:%02X:%02X:%02X:%02X", h->address[5], h->address[4], h->address[3], h->address[2], h->address[1], h->address[0]);
+}
+
+// seconds with microsecond resolution, integer math keeps it exact and fast
+static void FormatTicks(uint64_t ticks, char *text) {
+    uint64_t us = ticks * 1000000 / SESSION_TICK_PER_SEC;
+    sprintf(text, "%llu.%06u", (unsigned long long)(us / 1000000), (unsigned)(us % 1000000));
+}
+
+static void PrintCsvHeader() {
+    printf("device,session,start_utc,running,lap,lap_time_s,split_time_s\n");
+}
+
+// reads session after magic and checks its CRC, nothing is printed yet
+static int CheckSession(Header *h, size_t *lapsOffset) {
+    crc = 0xFFFFFFFF;
+    crc = crcTable[(crc ^ 'S') & 0xFF] ^ (crc >> 8);
+    crc = crcTable[(crc ^ 'W') & 0xFF] ^ (crc >> 8);
+    crc = crcTable[(crc ^ 'S') & 0xFF] ^ (crc >> 8);
+    crc = crcTable[(crc ^ 'N') & 0xFF] ^ (crc >> 8);
+
+    sessionOffset = bufferOffset + keepPos;
+    if (!ReadHeader(h)) {
+        fprintf(stderr, "session at byte %llu: truncated header\n", sessionOffset);
+        return 0;
+    }
+
+    // refill may move buffer contents, so position of laps is kept relative to magic
+    *lapsOffset = inputPos - keepPos;
+    for (int i = 0; i < h->lapCount; i++) {
+        uint32_t lapTicks;
+        if (!ReadVarint(&lapTicks)) {
+            fprintf(stderr, "session at byte %llu: truncated at lap %d\n", sessionOffset, i + 1);
+            return 0;
+        }
+    }
+
+    uint32_t expected = crc ^ 0xFFFFFFFF;
+    uint8_t stored[4];
+    if (!ReadBytes(stored, sizeof(stored))) {
+        fprintf(stderr, "session at byte %llu: truncated CRC\n", sessionOffset);
+        return 0;
+    }
+
+    if (GetUint32(stored) != expected) {
+        fprintf(stderr, "session at byte %llu: CRC mismatch\n", sessionOffset);
+        return 0;
+    }
+    return 1;
+}
+
+// laps of checked session are decoded again from buffer while they are printed
+static void PrintSession(const Header *h, size_t lapsOffset) {
+    char address[18];
+    char start[40];
+    char lapText[24];
+    char split[24];
+    uint64_t splitTicks = 0;
+    size_t endPos = inputPos;
+
+    sessionNumber++;
+    inputPos = keepPos + lapsOffset;
+
+    FormatAddress(h, address);
+    FormatStart(h, start, sizeof(start));
+    int isRunning = (h->flags & SESSION_FLAG_RUNNING) != 0;
+
+    if (isJson) {
+        FormatTicks(h->elapsed, lapText);
+        printf("{\"device\":\"%s\",\"session\":%lu,\"start_utc\":%s%s%s,\"running\":%s,\"elapsed_s\":%s,\"laps_s\":[",
+               address, sessionNumber, start[0] ? "\"" : "", start[0] ? start : "null", start[0] ? "\"" : "",
+               isRunning ? "true" : "false", lapText);
+    }
+
+    for (int i = 0; i < h->lapCount; i++) {
+        uint32_t lapTicks;
+        ReadVarint(&lapTicks);
+
+        splitTicks += lapTicks;
+        FormatTicks(lapTicks, lapText);
+        if (isJson) {
+            printf(i ? ",%s" : "%s", lapText);
+        } else {
+            FormatTicks(splitTicks, split);
+            printf("%s,%lu,%s,%d,%d,%s,%s\n", address, sessionNumber, start, isRunning, i + 1, lapText, split);
+        }
+    }
+
+    if (isJson) {
+        printf("]}\n");
+    }
+    inputPos = endPos;
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0) {
+            isJson = 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    input = path ? fopen(path, "rb") : stdin;
+    if (input == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    static char outputBuffer[OUTPUT_BUFFER_LEN];
+    setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+    InitCrcTable();
+    if (!isJson) {
+        PrintCsvHeader();
+    }
+
+    while (FindMagic()) {
+        Header h;
+        size_t lapsOffset;
+
+        // damaged header or lap count may hide next sessions, search resumes right after this magic
+        if (!CheckSession(&h, &lapsOffset)) {
+            errorCount++;
+            inputPos = keepPos + 1;
+            continue;
+        }
+        PrintSession(&h, lapsOffset);
+    }
+
+    if (input != stdin) {
+        fclose(input);
+    }
+
+    return errorCount ? 1 : 0;
+}
@@ -0,0 +1,391 @@
+// Host test of synchronised start on firmware code: TimeSync.c maps scheduled host time to tick, Time.c latches
+// start on alarm timer and Power.c main loop picks sleep states on its own. Around them device is modelled like
+// MAX32655: every device has its own crystal drift, TIME_TIMER and alarm timer stand still in deep sleep, WUT
+// keeps counting and wakes the CPU for WSF timers, which here are an always armed 1 s tick like GUI idle tick.
+//
+// Build: make sync_start_test
+// Usage: sync_start_test, exits with 1 when any device latched start 1 ms or more off, or deep sleep was taken
+// while synchronised
+//
+// Each device runs in its own process, as firmware state is static. Host side of every device syncs, leaves,
+// comes back a minute later to arm start at the same host time for all, and leaves again. Device stays
+// synchronised for 13 hours afterwards, mapping must expire after 12 and deep sleep resume.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "BLE.h"
+#include "DisplayBus.h"
+#include "I2CBus.h"
+#include "Power.h"
+#include "Time.h"
+#include "TimeSync.h"
+#include "Trace.h"
+
+#include <lp.h>
+#include <nvic_table.h>
+#include <pal_sys.h>
+#include <tmr.h>
+#include <wsf_os.h>
+#include <wsf_timer.h>
+#include <wut.h>
+
+#include <math.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEVICE_COUNT 5
+#define TICK_PER_SEC 32768.0
+#define US_PER_SEC 1000000LL
+#define WSF_TICK_US (1000 * 1000LL)
+
+// host time in microseconds since 0001-01-01, around 2026
+#define EPOCH (63900000000LL * US_PER_SEC)
+#define AT(seconds) (EPOCH + (int64_t)((seconds) * US_PER_SEC))
+
+#define SYNC_TIME AT(20)
+#define SYNC_LEAVE_TIME AT(25)
+#define ARM_TIME AT(85)
+#define ARM_LEAVE_TIME AT(88)
+#define START_TIME AT(95)
+#define STOP_TIME AT(100)
+#define EXPIRY_CHECK_TIME (SYNC_TIME + 12LL * 3600 * US_PER_SEC - 60 * US_PER_SEC)
+#define END_TIME (SYNC_TIME + 13LL * 3600 * US_PER_SEC)
+
+// host estimate of mapping is this good, see TimeSyncSimulator in windows app
+#define SYNC_ERROR_US 200
+#define DRIFT_ERROR_PPB 500
+#define LATCH_LIMIT_US 1000
+
+typedef struct {
+    int isLatched;
+    int64_t latchError;
+    uint32_t deepSleepBeforeSync;
+    uint32_t deepSleepWhileSynchronised;
+    uint32_t deepSleepAfterExpiry;
+    int isSynchronisedAtEnd;
+} Device_Result;
+
+mxc_tmr_regs_t Host_Tmr[4];
+mxc_i2c_regs_t Host_I2c[3];
+mxc_gpio_regs_t Host_Gpio0;
+SCB_Type Host_Scb;
+
+static const double drifts[DEVICE_COUNT] = {40, -25, 10, -5, 30};
+
+// true time is host time, crystal counts ticks since boot at drifted rate
+static double driftPpm;
+static int64_t now;
+static int64_t bootTime;
+static uint64_t frozenTicks;
+static uint32_t timerOffset;
+static uint32_t wutOffset;
+
+static uint64_t alarmTarget;
+static uint32_t alarmCompare;
+static int isAlarmRunning;
+static int isAlarmIrqEnabled;
+static void (*alarmVector)(void);
+
+static int connectionsCount;
+static int64_t nextWsfTick;
+static int nextAction;
+static jmp_buf finished;
+static Device_Result result;
+
+static uint64_t Device_CrystalAt(int64_t time) {
+    return (uint64_t)floor((time - bootTime) * (TICK_PER_SEC / US_PER_SEC) * (1 + driftPpm / 1e6));
+}
+
+static int64_t Device_TimeOfCrystal(uint64_t ticks) {
+    return bootTime + (int64_t)ceil(ticks / (TICK_PER_SEC / US_PER_SEC) / (1 + driftPpm / 1e6));
+}
+
+// TIME_TIMER without wrap, so alarm target compares simply
+static uint64_t Device_TimerAt(int64_t time) {
+    return Device_CrystalAt(time) - frozenTicks + timerOffset;
+}
+
+static void Device_UpdateCounters() {
+    MXC_TMR3->cnt = (uint32_t)Device_TimerAt(now);
+}
+
+// in deep sleep TIME_TIMER and alarm timer lose the ticks, alarm interrupt ends plain sleep early
+static void Device_AdvanceTo(int64_t time, int isDeepSleep) {
+    if (isDeepSleep) {
+        frozenTicks += Device_CrystalAt(time) - Device_CrystalAt(now);
+    } else if (isAlarmRunning && Device_TimerAt(time) >= alarmTarget) {
+        uint64_t fireCrystal = alarmTarget - timerOffset + frozenTicks;
+        now = Device_TimeOfCrystal(fireCrystal);
+        Device_UpdateCounters();
+        if (isAlarmIrqEnabled && alarmVector) {
+            alarmVector();
+        }
+        return;
+    }
+
+    now = time;
+    Device_UpdateCounters();
+}
+
+int MXC_TMR_Init(mxc_tmr_regs_t *tmr, mxc_tmr_cfg_t *cfg, bool_t initPins) {
+    if (tmr == MXC_TMR2) {
+        alarmCompare = cfg->cmp_cnt;
+    }
+    return E_NO_ERROR;
+}
+
+void MXC_TMR_Start(mxc_tmr_regs_t *tmr) {
+    if (tmr == MXC_TMR2) {
+        alarmTarget = Device_TimerAt(now) + alarmCompare;
+        isAlarmRunning = 1;
+    }
+}
+
+void MXC_TMR_Stop(mxc_tmr_regs_t *tmr) {
+    if (tmr == MXC_TMR2) {
+        isAlarmRunning = 0;
+    }
+}
+
+void MXC_TMR_EnableInt(mxc_tmr_regs_t *tmr) {
+}
+
+void MXC_TMR_DisableInt(mxc_tmr_regs_t *tmr) {
+}
+
+void MXC_TMR_ClearFlags(mxc_tmr_regs_t *tmr) {
+}
+
+void MXC_NVIC_SetVector(IRQn_Type irq, void (*handler)(void)) {
+    if (irq == TIME_ALARM_IRQn) {
+        alarmVector = handler;
+    }
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+    if (irq == TIME_ALARM_IRQn) {
+        isAlarmIrqEnabled = 1;
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq) {
+    if (irq == TIME_ALARM_IRQn) {
+        isAlarmIrqEnabled = 0;
+    }
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq) {
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {
+}
+
+uint32_t MXC_WUT_GetCount() {
+    return (uint32_t)Device_CrystalAt(now) + wutOffset;
+}
+
+void MXC_LP_EnableGPIOWakeup(mxc_gpio_cfg_t *wuPins) {
+}
+
+void MXC_LP_EnableWUTAlarmWakeup() {
+}
+
+void MXC_GPIO_SetWakeEn(mxc_gpio_regs_t *port, uint32_t mask) {
+}
+
+bool_t PalSysIsBusy() {
+    return FALSE;
+}
+
+int I2CBus_IsBusy() {
+    return 0;
+}
+
+int DisplayBus_IsBusy() {
+    return 0;
+}
+
+int Trace_IsUartBusy() {
+    return 0;
+}
+
+void Trace_DrainUart() {
+}
+
+void Trace_Event(uint8_t event, uint16_t arg0, uint32_t arg1) {
+}
+
+int BLE_GetConnectionsCount() {
+    return connectionsCount;
+}
+
+static void Device_StartLatched() {
+    result.isLatched = 1;
+    result.latchError = now - START_TIME;
+}
+
+// host side of device, each step runs once its time is reached
+static void Host_Sync() {
+    connectionsCount = 1;
+
+    int64_t hostTime = now + rand() % (2 * SYNC_ERROR_US + 1) - SYNC_ERROR_US;
+    int32_t drift = (int32_t)llround((1 / (1 + driftPpm / 1e6) - 1) * 1e9) + rand() % (2 * DRIFT_ERROR_PPB + 1) - DRIFT_ERROR_PPB;
+    TimeSync_SetMapping(hostTime, MXC_TMR3->cnt, drift);
+
+    result.deepSleepBeforeSync = Power_GetResidency(POWER_STATE_DEEPSLEEP);
+}
+
+static void Host_Leave() {
+    connectionsCount = 0;
+}
+
+// like GUI_ScheduleStart
+static void Host_Arm() {
+    connectionsCount = 1;
+
+    if (Time_StartAlarm(TimeSync_HostToDeviceTick(START_TIME), Device_StartLatched) == E_NO_ERROR) {
+        Power_SetDeepSleepAllowed(0);
+    }
+}
+
+// like GUI_StopClick
+static void Host_Stop() {
+    Power_SetDeepSleepAllowed(1);
+}
+
+static void Host_CheckBeforeExpiry() {
+    result.deepSleepWhileSynchronised = Power_GetResidency(POWER_STATE_DEEPSLEEP) - result.deepSleepBeforeSync;
+    result.deepSleepAfterExpiry = Power_GetResidency(POWER_STATE_DEEPSLEEP);
+}
+
+static void Host_Finish() {
+    result.deepSleepAfterExpiry = Power_GetResidency(POWER_STATE_DEEPSLEEP) - result.deepSleepAfterExpiry;
+    result.isSynchronisedAtEnd = TimeSync_IsSynchronized();
+    longjmp(finished, 1);
+}
+
+static const struct {
+    int64_t time;
+    void (*action)();
+} actions[] = {
+    {SYNC_TIME, Host_Sync},
+    {SYNC_LEAVE_TIME, Host_Leave},
+    {ARM_TIME, Host_Arm},
+    {ARM_LEAVE_TIME, Host_Leave},
+    {STOP_TIME, Host_Stop},
+    {EXPIRY_CHECK_TIME, Host_CheckBeforeExpiry},
+    {END_TIME, Host_Finish},
+};
+
+static int64_t Host_NextWakeup() {
+    int64_t next = nextWsfTick;
+    if (actions[nextAction].time < next) {
+        next = actions[nextAction].time;
+    }
+    return next;
+}
+
+// host actions stand in for BLE handler, which runs on WSF too
+bool_t wsfOsReadyToSleep() {
+    return TRUE;
+}
+
+void wsfOsDispatcher() {
+    while (now >= nextWsfTick) {
+        nextWsfTick += WSF_TICK_US;
+    }
+    while (now >= actions[nextAction].time) {
+        actions[nextAction++].action();
+    }
+}
+
+wsfTimerTicks_t WsfTimerNextExpiration(bool_t *pTimerRunning) {
+    *pTimerRunning = TRUE;
+    int64_t remaining = Host_NextWakeup() - now;
+    return remaining > 0 ? (wsfTimerTicks_t)((remaining + 999) / 1000) : 0;
+}
+
+void WsfTimerSleepUpdate() {
+}
+
+void WsfTimerSleep() {
+    Device_AdvanceTo(Host_NextWakeup(), (SCB->SCR & SCB_SCR_SLEEPDEEP_Msk) != 0);
+}
+
+static void Device_Run(int index) {
+    srand(index + 1);
+    driftPpm = drifts[index];
+    bootTime = EPOCH - (rand() % 3600 + 1) * US_PER_SEC;
+    timerOffset = (uint32_t)rand() << 8;
+    wutOffset = (uint32_t)rand() << 8;
+    now = EPOCH;
+    nextWsfTick = now + WSF_TICK_US;
+    Device_UpdateCounters();
+
+    Time_Init();
+    if (!setjmp(finished)) {
+        Power_EnterMainLoop();
+    }
+}
+
+int main() {
+    Device_Result results[DEVICE_COUNT];
+    int failures = 0;
+
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return 1;
+        }
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            Device_Run(i);
+            _exit(write(fds[1], &result, sizeof(result)) == sizeof(result) ? 0 : 1);
+        }
+
+        close(fds[1]);
+        int status;
+        ssize_t len = read(fds[0], &results[i], sizeof(results[i]));
+        close(fds[0]);
+        waitpid(pid, &status, 0);
+        if (len != sizeof(results[i]) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            printf("device %d did not finish\n", i + 1);
+            return 1;
+        }
+    }
+
+    int64_t earliest = INT64_MAX;
+    int64_t latest = INT64_MIN;
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        Device_Result *r = &results[i];
+        printf("device %d (%+.0f ppm): started %+.3f ms, deep sleep %.1f s before sync, %.1f s synchronised, %.1f s after expiry\n", i + 1, drifts[i], r->latchError / 1000.0, r->deepSleepBeforeSync / TICK_PER_SEC,
+               r->deepSleepWhileSynchronised / TICK_PER_SEC, r->deepSleepAfterExpiry / TICK_PER_SEC);
+
+        if (!r->isLatched || llabs(r->latchError) >= LATCH_LIMIT_US) {
+            printf("device %d: start not latched or too far off\n", i + 1);
+            failures++;
+        }
+        // harness must reach deep sleep when nothing holds it off, or the test proves nothing
+        if (r->deepSleepBeforeSync < 15 * TICK_PER_SEC || r->deepSleepAfterExpiry < 3000 * TICK_PER_SEC) {
+            printf("device %d: no deep sleep while unsynchronised\n", i + 1);
+            failures++;
+        }
+        if (r->deepSleepWhileSynchronised != 0 || r->isSynchronisedAtEnd) {
+            printf("device %d: deep sleep while synchronised or mapping did not expire\n", i + 1);
+            failures++;
+        }
+
+        earliest = r->latchError < earliest ? r->latchError : earliest;
+        latest = r->latchError > latest ? r->latchError : latest;
+    }
+
+    printf("spread of starts %.3f ms\n", (latest - earliest) / 1000.0);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,285 @@
+// Host decoder of binary trace records produced by Trace.c.
+//
+// Build: cc -std=c99 -O2 -o trace_decode trace_decode.c
+// Usage: trace_decode [-u] [-r] [file]
+//   file  concatenated values read from Trace characteristic (default stdin)
+//   -u    input is UART capture where every record is prefixed by 0xA5 0x5A
+//   -r    print only reconnection latency report, time from connection open to first notification sent, split by
+//         whether link was encrypted with stored bond, paired on the spot or left unencrypted
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TRACE_RECORD_LEN 12
+#define TRACE_TICK_PER_SEC 32768
+#define TRACE_UART_SYNC0 0xA5
+#define TRACE_UART_SYNC1 0x5A
+
+// keep in sync with Trace.h
+enum {
+    TRACE_EVENT_LOST,
+    TRACE_EVENT_ERROR,
+    TRACE_EVENT_BUTTON_PRESS,
+    TRACE_EVENT_DISPLAY_FRAME,
+    TRACE_EVENT_I2C_TRANSACTION,
+    TRACE_EVENT_SLEEP,
+    TRACE_EVENT_BLE_CONNECTION,
+    TRACE_EVENT_STOPWATCH,
+    TRACE_EVENT_BLE_LINK,
+    TRACE_EVENT_GUI_FRAME,
+};
+
+static const char *moduleNames[] = {"Display", "FuelGauge", "GUI", "I2CBus"};
+static const char *sleepStateNames[] = {"active", "sleep", "deepsleep"};
+static const char *stopwatchActionNames[] = {"start", "stop", "lap", "reset"};
+static const char *buttonNames[] = {"right", "left", "middle"};
+static const char *linkEventNames[] = {"encrypted", "paired", "notifications enabled", "first notification sent"};
+
+// keep in sync with Trace.h
+enum {
+    TRACE_BLE_LINK_ENCRYPTED,
+    TRACE_BLE_LINK_PAIRED,
+    TRACE_BLE_LINK_NOTIFY_READY,
+    TRACE_BLE_LINK_FIRST_NOTIFICATION,
+};
+
+#define NAME(table, index) ((index) < sizeof(table) / sizeof(*table) ? table[index] : "?")
+
+typedef struct {
+    uint32_t timestamp;
+    uint8_t sequence;
+    uint8_t event;
+    uint16_t arg0;
+    uint32_t arg1;
+} Record;
+
+// connection IDs are small, Cordio allows at most 8 links
+#define CONN_MAX 16
+
+enum {
+    LINK_BONDED,
+    LINK_PAIRED,
+    LINK_UNENCRYPTED,
+    LINK_KINDS,
+};
+
+static const char *linkKindNames[] = {"bonded", "paired", "unencrypted"};
+
+typedef struct {
+    uint32_t count;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+} LatencyStats;
+
+static int isReport = 0;
+static uint8_t isConnOpen[CONN_MAX];
+static uint8_t isConnEncrypted[CONN_MAX];
+static uint8_t isConnPaired[CONN_MAX];
+static uint8_t isConnNotified[CONN_MAX];
+static LatencyStats latencies[LINK_KINDS];
+static uint32_t silentConnections = 0;
+
+static uint64_t timeBase = 0;
+static uint32_t lastTimestamp = 0;
+static int lastSequence = -1;
+
+static uint32_t ReadUint32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void ParseRecord(const uint8_t *p, Record *r) {
+    r->timestamp = ReadUint32(p);
+    r->sequence = p[4];
+    r->event = p[5];
+    r->arg0 = p[6] | (p[7] << 8);
+    r->arg1 = ReadUint32(p + 8);
+}
+
+static void PrintRecord(const Record *r) {
+    // timestamp wraps after ~36 hours
+    if (r->timestamp < lastTimestamp) {
+        timeBase += 1ull << 32;
+    }
+    lastTimestamp = r->timestamp;
+
+    if (r->event != TRACE_EVENT_LOST && lastSequence >= 0 && r->sequence != (uint8_t)(lastSequence + 1)) {
+        printf("%14s  sequence gap %d -> %d\n", "", lastSequence, r->sequence);
+    }
+    lastSequence = r->sequence;
+
+    double seconds = (double)(timeBase + r->timestamp) / TRACE_TICK_PER_SEC;
+    printf("%14.6f  #%-3d ", seconds, r->sequence);
+
+    switch (r->event) {
+        case TRACE_EVENT_LOST:
+            printf("LOST       %u records overwritten\n", r->arg1);
+            break;
+        case TRACE_EVENT_ERROR:
+            printf("ERROR      %s line %d status %d\n", NAME(moduleNames, r->arg0 >> 12), r->arg0 & 0xFFF, (int32_t)r->arg1);
+            break;
+        case TRACE_EVENT_BUTTON_PRESS:
+            printf("BUTTON     %s pressed at tick %u\n", NAME(buttonNames, r->arg0), r->arg1);
+            break;
+        case TRACE_EVENT_DISPLAY_FRAME:
+            printf("DISPLAY    start page %d, %d rows, %u bytes sent, %u ms after show\n", r->arg0 >> 8, r->arg0 & 0xFF, r->arg1 & 0xFFFF, r->arg1 >> 16);
+            break;
+        case TRACE_EVENT_I2C_TRANSACTION:
+            printf("I2C        bus %d priority %d result %d\n", r->arg0 >> 8, r->arg0 & 0xFF, (int32_t)r->arg1);
+            break;
+        case TRACE_EVENT_SLEEP:
+            printf("SLEEP      %s for %.3f ms\n", NAME(sleepStateNames, r->arg0), r->arg1 * 1000.0 / TRACE_TICK_PER_SEC);
+            break;
+        case TRACE_EVENT_BLE_CONNECTION:
+            printf("BLE        connection %d %s\n", r->arg0, r->arg1 ? "opened" : "closed");
+            break;
+        case TRACE_EVENT_STOPWATCH:
+            printf("STOPWATCH  %s at tick %u\n", NAME(stopwatchActionNames, r->arg0), r->arg1);
+            break;
+        case TRACE_EVENT_BLE_LINK:
+            printf("BLE LINK   connection %d %s %.1f ms after open\n", r->arg0 >> 8, NAME(linkEventNames, r->arg0 & 0xFF), r->arg1 * 1000.0 / TRACE_TICK_PER_SEC);
+            break;
+        case TRACE_EVENT_GUI_FRAME:
+            printf("GUI        %d of %u widgets redrawn\n", r->arg0, r->arg1);
+            break;
+        default:
+            printf("EVENT %-4d arg0=0x%04x arg1=0x%08x\n", r->event, r->arg0, r->arg1);
+            break;
+    }
+}
+
+// encryption and pairing are traced before first notification on same link, as notifications wait for encryption
+static void AccountRecord(const Record *r) {
+    if (r->event == TRACE_EVENT_BLE_CONNECTION && r->arg0 < CONN_MAX) {
+        if (r->arg1) {
+            isConnOpen[r->arg0] = 1;
+            isConnEncrypted[r->arg0] = 0;
+            isConnPaired[r->arg0] = 0;
+            isConnNotified[r->arg0] = 0;
+        } else {
+            silentConnections += isConnOpen[r->arg0] && !isConnNotified[r->arg0];
+            isConnOpen[r->arg0] = 0;
+        }
+        return;
+    }
+
+    int connId = r->arg0 >> 8;
+    if (r->event != TRACE_EVENT_BLE_LINK || connId >= CONN_MAX || !isConnOpen[connId]) {
+        return;
+    }
+
+    switch (r->arg0 & 0xFF) {
+        case TRACE_BLE_LINK_ENCRYPTED:
+            isConnEncrypted[connId] = 1;
+            break;
+        case TRACE_BLE_LINK_PAIRED:
+            isConnPaired[connId] = 1;
+            break;
+        case TRACE_BLE_LINK_FIRST_NOTIFICATION: {
+            if (isConnNotified[connId]) {
+                break;
+            }
+            isConnNotified[connId] = 1;
+
+            LatencyStats *stats = &latencies[isConnPaired[connId] ? LINK_PAIRED : isConnEncrypted[connId] ? LINK_BONDED : LINK_UNENCRYPTED];
+            if (stats->count == 0 || r->arg1 < stats->minTicks) {
+                stats->minTicks = r->arg1;
+            }
+            if (stats->count == 0 || r->arg1 > stats->maxTicks) {
+                stats->maxTicks = r->arg1;
+            }
+            stats->count++;
+            stats->totalTicks += r->arg1;
+            break;
+        }
+    }
+}
+
+static void HandleRecord(const Record *r) {
+    if (isReport) {
+        AccountRecord(r);
+    } else {
+        PrintRecord(r);
+    }
+}
+
+static void PrintReport() {
+    printf("connection open to first notification sent:\n");
+    for (int i = 0; i < LINK_KINDS; i++) {
+        const LatencyStats *stats = &latencies[i];
+        if (stats->count == 0) {
+            printf("  %-12s no connections\n", linkKindNames[i]);
+            continue;
+        }
+        printf("  %-12s %u connections, min %.1f ms, average %.1f ms, max %.1f ms\n", linkKindNames[i], stats->count, stats->minTicks * 1000.0 / TRACE_TICK_PER_SEC,
+               (double)stats->totalTicks / stats->count * 1000.0 / TRACE_TICK_PER_SEC, stats->maxTicks * 1000.0 / TRACE_TICK_PER_SEC);
+    }
+    printf("  %-12s %u connections closed before any notification\n", "silent", silentConnections);
+}
+
+static void DecodeRaw(FILE *f) {
+    uint8_t buffer[TRACE_RECORD_LEN];
+    Record r;
+
+    while (fread(buffer, 1, sizeof(buffer), f) == sizeof(buffer)) {
+        ParseRecord(buffer, &r);
+        HandleRecord(&r);
+    }
+}
+
+static void DecodeUart(FILE *f) {
+    uint8_t buffer[TRACE_RECORD_LEN];
+    Record r;
+    int c, prev = -1;
+
+    while ((c = fgetc(f)) != EOF) {
+        if (prev == TRACE_UART_SYNC0 && c == TRACE_UART_SYNC1) {
+            if (fread(buffer, 1, sizeof(buffer), f) != sizeof(buffer)) {
+                break;
+            }
+            ParseRecord(buffer, &r);
+            HandleRecord(&r);
+            prev = -1;
+        } else {
+            prev = c;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int isUart = 0;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-u") == 0) {
+            isUart = 1;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            isReport = 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    FILE *f = path ? fopen(path, "rb") : stdin;
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    if (isUart) {
+        DecodeUart(f);
+    } else {
+        DecodeRaw(f);
+    }
+
+    if (isReport) {
+        PrintReport();
+    }
+
+    if (f != stdin) {
+        fclose(f);
+    }
+
+    return 0;
+}